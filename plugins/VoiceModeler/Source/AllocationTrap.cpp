@@ -0,0 +1,108 @@
+#include "AllocationTrap.h"
+
+#if VOICEMODELER_TRAP_ALLOCATIONS
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    thread_local bool armed = false;
+    std::atomic<int> trapped { 0 };
+
+    void trap() noexcept
+    {
+        if (! armed)
+            return;
+
+        trapped.fetch_add (1, std::memory_order_relaxed);
+
+        // jassert のログ出力も確保するので、止めている間は外す
+        armed = false;
+        jassertfalse;   // processBlock の中でヒープを使った（コールスタックを見る）
+        armed = true;
+    }
+
+    void* allocate (std::size_t size) noexcept
+    {
+        trap();
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        trap();
+        const auto align = std::max ((std::size_t) alignment, sizeof (void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc (size == 0 ? 1 : size, align);
+       #else
+        void* p = nullptr;
+        return posix_memalign (&p, align, size == 0 ? 1 : size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void release (void* p) noexcept
+    {
+        if (p != nullptr)
+            trap();
+        std::free (p);
+    }
+
+    void releaseAligned (void* p) noexcept
+    {
+        if (p != nullptr)
+            trap();
+
+       #if JUCE_WINDOWS
+        _aligned_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+
+    void* orThrow (void* p)
+    {
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+AllocationTrap::ScopedAudioThread::ScopedAudioThread() noexcept : wasArmed (armed) { armed = true; }
+AllocationTrap::ScopedAudioThread::~ScopedAudioThread() noexcept                   { armed = wasArmed; }
+
+int AllocationTrap::getNumTrapped() noexcept { return trapped.load (std::memory_order_relaxed); }
+
+// グローバルな operator new / delete の差し替え。既定版どうしが呼び合うかは実装次第なので
+// （サニタイザや MSVC の CRT は呼ばないことがある）、単体・配列 × 通常・nothrow・アライン付きの全部を置く
+void* operator new   (std::size_t size)                                   { return orThrow (allocate (size)); }
+void* operator new[] (std::size_t size)                                   { return orThrow (allocate (size)); }
+void* operator new   (std::size_t size, const std::nothrow_t&) noexcept   { return allocate (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept   { return allocate (size); }
+
+void operator delete   (void* p) noexcept                                 { release (p); }
+void operator delete[] (void* p) noexcept                                 { release (p); }
+void operator delete   (void* p, std::size_t) noexcept                    { release (p); }
+void operator delete[] (void* p, std::size_t) noexcept                    { release (p); }
+void operator delete   (void* p, const std::nothrow_t&) noexcept          { release (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept          { release (p); }
+
+// 既定より大きいアラインメント（SIMD 型のコンテナなど）
+void* operator new   (std::size_t size, std::align_val_t a)                                 { return orThrow (allocateAligned (size, a)); }
+void* operator new[] (std::size_t size, std::align_val_t a)                                 { return orThrow (allocateAligned (size, a)); }
+void* operator new   (std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return allocateAligned (size, a); }
+void* operator new[] (std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return allocateAligned (size, a); }
+
+void operator delete   (void* p, std::align_val_t) noexcept                                 { releaseAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                                 { releaseAligned (p); }
+void operator delete   (void* p, std::size_t, std::align_val_t) noexcept                    { releaseAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept                    { releaseAligned (p); }
+void operator delete   (void* p, std::align_val_t, const std::nothrow_t&) noexcept          { releaseAligned (p); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept          { releaseAligned (p); }
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// デバッグ用：オーディオスレッドでのヒープ操作を捕まえる。
+// VOICEMODELER_TRAP_ALLOCATIONS=1 でビルドすると、グローバルな operator new / delete（配列・nothrow・
+// align_val_t 付きを含む全形）を差し替え、
+// ScopedAudioThread の間（processBlock）に呼ばれたら数えて jassertfalse で止める。既定（0）では何もしない。
+// malloc を直接使う確保（juce::HeapBlock など）は対象外。Linux では VoiceModelerBench --rtsafety が malloc 側も数える。
+#ifndef VOICEMODELER_TRAP_ALLOCATIONS
+ #define VOICEMODELER_TRAP_ALLOCATIONS 0
+#endif
+
+namespace AllocationTrap
+{
+   #if VOICEMODELER_TRAP_ALLOCATIONS
+    // このスレッドで生きている間、operator new / delete を捕まえる（入れ子可）
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+
+    private:
+        bool wasArmed;
+        JUCE_DECLARE_NON_COPYABLE (ScopedAudioThread)
+    };
+
+    int getNumTrapped() noexcept;   // 起動から捕まえた回数
+   #else
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept {}
+    };
+
+    inline int getNumTrapped() noexcept { return 0; }
+   #endif
+}
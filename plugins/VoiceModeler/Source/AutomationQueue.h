@@ -0,0 +1,139 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// ブロック内のオートメーション点（サンプル位置＋実値）をパラメータごとに溜めるキュー。
+// 配列は prepare で確保し、以後の push / 消費は確保なし。push と消費は同じスレッド（processBlock の直前に
+// ラッパー／オフラインレンダラが積む）を想定し、offset は次に処理するブロックの先頭からのサンプル位置。
+// パラメータごとに offset は非減少で積むこと（戻った場合は直前の位置に揃える）。
+class AutomationQueue
+{
+public:
+    // イベントの有無をビットマスクで持つので 32 パラメータまで
+    static constexpr int maxParameters = 32;
+
+    struct Event
+    {
+        int offset = 0;
+        float value = 0.0f;
+    };
+
+    void prepare (int numParameters, int capacityPerParameter)
+    {
+        jassert (numParameters <= maxParameters);
+        lanes.resize ((size_t) numParameters);
+        for (auto& lane : lanes)
+        {
+            lane.events.resize ((size_t) juce::jmax (1, capacityPerParameter));
+            lane.count = lane.read = 0;
+        }
+        pending = 0;
+    }
+
+    // 一杯なら最後のイベントを上書きして false（最終値は失わない）
+    bool push (int parameter, int offset, float value) noexcept
+    {
+        if (! juce::isPositiveAndBelow (parameter, (int) lanes.size()))
+            return false;
+
+        auto& lane = lanes[(size_t) parameter];
+        if (lane.count > lane.read)
+            offset = juce::jmax (offset, lane.events[(size_t) lane.count - 1].offset);
+        offset = juce::jmax (0, offset);
+
+        if (lane.count == (int) lane.events.size())
+        {
+            lane.events[(size_t) lane.count - 1] = { offset, value };
+            return false;
+        }
+
+        if (lane.count == lane.read)
+            pending |= bit (parameter);
+
+        lane.events[(size_t) lane.count++] = { offset, value };
+        return true;
+    }
+
+    bool isEmpty() const noexcept                       { return pending == 0; }
+    bool hasEvents (int parameter) const noexcept       { return (pending & bit (parameter)) != 0; }
+
+    // from より後ろで最初のイベント位置（なければ end）
+    int nextOffset (int from, int end) const noexcept
+    {
+        int next = end;
+        for (int p = 0; p < (int) lanes.size(); ++p)
+        {
+            if (! hasEvents (p))
+                continue;
+
+            auto& lane = lanes[(size_t) p];
+            for (int i = lane.read; i < lane.count; ++i)
+            {
+                if (lane.events[(size_t) i].offset > from)
+                {
+                    next = juce::jmin (next, lane.events[(size_t) i].offset);
+                    break;
+                }
+            }
+        }
+        return next;
+    }
+
+    // offset <= position のイベントを順に fn (parameter, value) へ渡して取り除く
+    template <typename Fn>
+    void popUntil (int position, Fn&& fn) noexcept
+    {
+        for (int p = 0; p < (int) lanes.size(); ++p)
+        {
+            if (! hasEvents (p))
+                continue;
+
+            auto& lane = lanes[(size_t) p];
+            while (lane.read < lane.count && lane.events[(size_t) lane.read].offset <= position)
+                fn (p, lane.events[(size_t) lane.read++].value);
+
+            if (lane.read == lane.count)
+            {
+                lane.count = lane.read = 0;
+                pending &= ~bit (p);
+            }
+        }
+    }
+
+    // ブロックの終わり：残り（offset >= numSamples）を次のブロックの先頭基準にずらす
+    void endBlock (int numSamples) noexcept
+    {
+        for (int p = 0; p < (int) lanes.size(); ++p)
+        {
+            if (! hasEvents (p))
+                continue;
+
+            auto& lane = lanes[(size_t) p];
+            int n = 0;
+            for (int i = lane.read; i < lane.count; ++i)
+                lane.events[(size_t) n++] = { lane.events[(size_t) i].offset - numSamples, lane.events[(size_t) i].value };
+
+            lane.count = n;
+            lane.read = 0;
+        }
+    }
+
+    void clear() noexcept
+    {
+        for (auto& lane : lanes)
+            lane.count = lane.read = 0;
+        pending = 0;
+    }
+
+private:
+    struct Lane
+    {
+        std::vector<Event> events;
+        int count = 0, read = 0;
+    };
+
+    static constexpr juce::uint32 bit (int p) noexcept  { return 1u << (juce::uint32) p; }
+
+    std::vector<Lane> lanes;
+    juce::uint32 pending = 0;                           // イベントが残っているパラメータ
+};
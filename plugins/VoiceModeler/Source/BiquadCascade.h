@@ -0,0 +1,270 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "BiquadCoefficients.h"
+#include <array>
+#include <utility>
+#include <vector>
+
+// 複数段の biquad（TDF-II）を 1 パスで処理する融合カスケード。
+// チャンネルを SIMDRegister のレーンに割り当て（L/R を同時に処理）、
+// 1 サンプルごとに全段を通してからバッファへ書き戻す。
+// 状態は [チャンネルグループ][段] × レーン（= チャンネル）の SoA 配置で、
+// 多チャンネルはレーン幅ごとのグループ数で増える。モノラルはレーン詰め替えなしのスカラ経路。
+// 内側のループは有効段数ごとに展開したカーネル（processStages<N>）で、ブロック中は状態をレジスタに置く。
+// ブロック末のデノーマル対策もレーン単位の get/set ではなく比較マスクで行う（小ブロックではこれが支配的だった）。
+// ステレオは -O2 / SSE2 で段ごとの IIR::Filter より 3 倍以上速い（--cascade で計測）。
+// モノラルは 1 レーンしか使わないので 1.3〜2 倍にとどまる。
+//
+// 1 段あたりの演算順序は juce::dsp::IIR::Filter と同一なので、
+// 係数が同じなら段ごとに ProcessorDuplicator を回した結果とビット一致する。
+// 旧チェイン（float で設計した係数）との差は係数の丸めのみ。ホワイトノイズ入力で
+// 最大 -69 dB re peak @48 kHz、-50 dB @192 kHz（25 Hz HPF が支配的）。
+// これは旧チェイン自身の double 基準に対する誤差と同程度。
+// double で使う（Precision = Double）と係数も状態も double のままなので、この誤差はなくなる。
+// SIMD のレーン数は半分（SSE で 2ch ずつ）になる。
+//
+// 係数が恒等（BiquadCoeffs {}）で状態もゼロになった段は処理から外す（0 dB の EQ、0 % の鼻腔など）。
+// 恒等段はゼロ状態のまま入力を素通しするだけなので、外しても結果はビット一致する。
+template <typename SampleType>
+class BiquadCascade
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes     = (int) Vec::size();
+    static constexpr int maxStages = 16;
+
+    void prepare (int numChannelsToUse, int maxBlockSize)
+    {
+        numChannels = juce::jmax (1, numChannelsToUse);
+        numGroups = (numChannels + lanes - 1) / lanes;
+        blockSize = juce::jmax (1, maxBlockSize);
+
+        scratch.assign ((size_t) blockSize, Vec::expand (SampleType (0)));
+        state.assign ((size_t) (numGroups * maxStages * 2), Vec::expand (SampleType (0)));
+    }
+
+    void reset() noexcept
+    {
+        for (auto& s : state)
+            s = Vec::expand (SampleType (0));
+
+        monoS1.fill (SampleType (0));
+        monoS2.fill (SampleType (0));
+
+        updateActiveStages();
+    }
+
+    void setNumStages (int n) noexcept { numStages = juce::jlimit (0, maxStages, n); updateActiveStages(); }
+    int getNumStages() const noexcept  { return numStages; }
+
+    // 実際に処理している段の数（恒等で状態ゼロの段を除く）
+    int getNumActiveStages() const noexcept { return numActive; }
+
+    void setStage (int index, const BiquadCoeffs& c) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (index, maxStages));
+        b0[(size_t) index] = Vec::expand ((SampleType) c.b0);
+        b1[(size_t) index] = Vec::expand ((SampleType) c.b1);
+        b2[(size_t) index] = Vec::expand ((SampleType) c.b2);
+        a1[(size_t) index] = Vec::expand ((SampleType) c.a1);
+        a2[(size_t) index] = Vec::expand ((SampleType) c.a2);
+
+        mono[(size_t) index] = { (SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2,
+                                 (SampleType) c.a1, (SampleType) c.a2 };
+
+        // 恒等になった段は状態が抜けるまで処理を続け、ブロック末で外す
+        const bool wasIdentity = identity[(size_t) index];
+        identity[(size_t) index] = c == BiquadCoeffs {};
+        if (wasIdentity && ! identity[(size_t) index])
+            updateActiveStages();
+    }
+
+    // in-place で [startSample, startSample + numSamples) を処理。prepare 時より長い区間は内部で分割する
+    void process (SampleType* const* channels, int numChannelsToProcess, int startSample, int numSamples) noexcept
+    {
+        if (numActive == 0 || scratch.empty())
+            return;
+
+        const int chs = juce::jmin (numChannels, numChannelsToProcess);
+
+        if (chs == 1)
+        {
+            processMono (channels[0] + startSample, numSamples);
+            updateActiveStages();
+            return;
+        }
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const int ch0 = g * lanes;
+            const int n   = juce::jmin (lanes, chs - ch0);
+            if (n <= 0)
+                break;
+
+            for (int start = startSample, end = startSample + numSamples; start < end; start += blockSize)
+            {
+                const int len = juce::jmin (blockSize, end - start);
+                interleave (channels + ch0, n, start, len);
+                processGroup (g, len);
+                deinterleave (channels + ch0, n, start, len);
+            }
+        }
+
+        updateActiveStages();
+    }
+
+private:
+    void interleave (SampleType* const* chans, int n, int start, int len) noexcept
+    {
+        auto* flat = reinterpret_cast<SampleType*> (scratch.data());
+        for (int l = 0; l < n; ++l)
+        {
+            const auto* src = chans[l] + start;
+            for (int i = 0; i < len; ++i)
+                flat[i * lanes + l] = src[i];
+        }
+    }
+
+    void deinterleave (SampleType* const* chans, int n, int start, int len) const noexcept
+    {
+        const auto* flat = reinterpret_cast<const SampleType*> (scratch.data());
+        for (int l = 0; l < n; ++l)
+        {
+            auto* dst = chans[l] + start;
+            for (int i = 0; i < len; ++i)
+                dst[i] = flat[i * lanes + l];
+        }
+    }
+
+    void processGroup (int g, int len) noexcept
+    {
+        auto* s1 = state.data() + (size_t) (g * maxStages * 2);
+        static constexpr auto kernels = makeKernels (std::make_index_sequence<(size_t) maxStages>());
+        (this->*kernels[(size_t) (numActive - 1)]) (s1, s1 + maxStages, scratch.data(), len);
+    }
+
+    // 段数をコンパイル時に固定したカーネル。係数と状態をローカル配列に取り、
+    // ブロックの間は状態をレジスタに置いたまま回す（段数で分岐するとメモリ往復になる）
+    template <int numToRun>
+    void processStages (Vec* s1, Vec* s2, Vec* io, int len) noexcept
+    {
+        Vec c0[numToRun], c1[numToRun], c2[numToRun], d1[numToRun], d2[numToRun];
+        Vec z1[numToRun], z2[numToRun];
+
+        for (int k = 0; k < numToRun; ++k)
+        {
+            const auto s = (size_t) active[(size_t) k];
+            c0[k] = b0[s]; c1[k] = b1[s]; c2[k] = b2[s]; d1[k] = a1[s]; d2[k] = a2[s];
+            z1[k] = s1[s]; z2[k] = s2[s];
+        }
+
+        for (int i = 0; i < len; ++i)
+        {
+            Vec x = io[i];
+            for (int k = 0; k < numToRun; ++k)
+            {
+                const Vec y = c0[k] * x + z1[k];
+                z1[k] = c1[k] * x - d1[k] * y + z2[k];
+                z2[k] = c2[k] * x - d2[k] * y;
+                x = y;
+            }
+            io[i] = x;
+        }
+
+        // IIR::Filter と同じくブロック末で状態をゼロへスナップ（デノーマル対策）
+        for (int k = 0; k < numToRun; ++k)
+        {
+            const auto s = (size_t) active[(size_t) k];
+            s1[s] = snapToZero (z1[k]);
+            s2[s] = snapToZero (z2[k]);
+        }
+    }
+
+    using Kernel = void (BiquadCascade::*) (Vec*, Vec*, Vec*, int) noexcept;
+
+    template <size_t... n>
+    static constexpr std::array<Kernel, sizeof... (n)> makeKernels (std::index_sequence<n...>) noexcept
+    {
+        return { { &BiquadCascade::processStages<(int) n + 1>... } };
+    }
+
+    // モノラル：インターリーブせず直接スカラで処理
+    void processMono (SampleType* data, int len) noexcept
+    {
+        const int na = numActive;
+
+        for (int i = 0; i < len; ++i)
+        {
+            SampleType x = data[i];
+            for (int k = 0; k < na; ++k)
+            {
+                const auto s = (size_t) active[(size_t) k];
+                const auto& c = mono[s];
+                const SampleType y = c[0] * x + monoS1[s];
+                monoS1[s] = c[1] * x - c[3] * y + monoS2[s];
+                monoS2[s] = c[2] * x - c[4] * y;
+                x = y;
+            }
+            data[i] = x;
+        }
+
+        for (int k = 0; k < na; ++k)
+        {
+            snapToZero (monoS1[(size_t) active[(size_t) k]]);
+            snapToZero (monoS2[(size_t) active[(size_t) k]]);
+        }
+    }
+
+    // 段の並び順のまま、恒等でないか状態が残っている段だけを active に詰める
+    void updateActiveStages() noexcept
+    {
+        numActive = 0;
+
+        for (int s = 0; s < numStages; ++s)
+            if (! identity[(size_t) s] || ! stateIsZero (s))
+                active[(size_t) numActive++] = s;
+    }
+
+    bool stateIsZero (int s) const noexcept
+    {
+        if (monoS1[(size_t) s] != SampleType (0) || monoS2[(size_t) s] != SampleType (0))
+            return false;
+
+        for (int g = 0; g < numGroups && ! state.empty(); ++g)
+        {
+            const auto* s1 = state.data() + (size_t) (g * maxStages * 2);
+            for (const auto& v : { s1[s], s1[maxStages + s] })
+                for (size_t l = 0; l < Vec::size(); ++l)
+                    if (v.get (l) != SampleType (0))
+                        return false;
+        }
+
+        return true;
+    }
+
+    static void snapToZero (SampleType& x) noexcept
+    {
+        if (! (x < SampleType (-1.0e-8) || x > SampleType (1.0e-8)))
+            x = SampleType (0);
+    }
+
+    // レーンごとの分岐をせず、比較マスクで ±1e-8 以内のレーンだけ 0 にする
+    static Vec snapToZero (Vec v) noexcept
+    {
+        return v & (Vec::lessThan (v, Vec::expand (SampleType (-1.0e-8)))
+                      | Vec::greaterThan (v, Vec::expand (SampleType (1.0e-8))));
+    }
+
+    std::array<Vec, maxStages> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    std::vector<Vec> state;   // [group][s1 × maxStages, s2 × maxStages]
+    std::vector<Vec> scratch; // レーンインターリーブ済みの作業バッファ
+
+    std::array<std::array<SampleType, 5>, maxStages> mono {};   // b0 b1 b2 a1 a2
+    std::array<SampleType, maxStages> monoS1 {}, monoS2 {};
+
+    std::array<bool, maxStages> identity {};  // 係数が恒等か（setStage で更新）
+    std::array<int, maxStages> active {};     // 処理する段の番号（昇順）
+    int numActive = 0;
+
+    int numStages = 0, numChannels = 1, numGroups = 1, blockSize = 0;
+};
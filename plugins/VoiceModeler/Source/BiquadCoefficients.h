@@ -0,0 +1,84 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+
+// 正規化済み（a0 = 1）の biquad 係数。ヒープ確保なしで値渡しできる POD。
+// 計算は double で行い、フィルタ側の精度に合わせてキャストする。
+struct BiquadCoeffs
+{
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+
+    bool operator== (const BiquadCoeffs& o) const noexcept
+    {
+        return b0 == o.b0 && b1 == o.b1 && b2 == o.b2 && a1 == o.a1 && a2 == o.a2;
+    }
+    bool operator!= (const BiquadCoeffs& o) const noexcept { return ! (*this == o); }
+};
+
+// juce::dsp::IIR::Coefficients の make* と同じ式（RBJ cookbook）。
+// 違いは結果をヒープ上の Coefficients ではなく BiquadCoeffs に直接返す点だけ。
+namespace BiquadDesign
+{
+    inline BiquadCoeffs normalise (double b0, double b1, double b2,
+                                   double a0, double a1, double a2) noexcept
+    {
+        const double inv = 1.0 / a0;
+        return { b0 * inv, b1 * inv, b2 * inv, a1 * inv, a2 * inv };
+    }
+
+    inline BiquadCoeffs peak (double sampleRate, double freq, double q, double gainFactor) noexcept
+    {
+        // 0 dB のピークは伝達関数が 1 なので、恒等係数を返す（カスケード側で段ごと省ける）
+        if (gainFactor == 1.0)
+            return {};
+
+        const double A     = std::sqrt (juce::jmax (1.0e-15, gainFactor));
+        const double omega = juce::MathConstants<double>::twoPi * juce::jmax (freq, 2.0) / sampleRate;
+        const double alpha = std::sin (omega) / (q * 2.0);
+        const double c2    = -2.0 * std::cos (omega);
+        const double aA    = alpha * A;
+        const double aOA   = alpha / A;
+        return normalise (1.0 + aA, c2, 1.0 - aA, 1.0 + aOA, c2, 1.0 - aOA);
+    }
+
+    inline BiquadCoeffs bandPass (double sampleRate, double freq, double q) noexcept
+    {
+        const double n    = 1.0 / std::tan (juce::MathConstants<double>::pi * freq / sampleRate);
+        const double n2   = n * n;
+        const double invQ = 1.0 / q;
+        const double c1   = 1.0 / (1.0 + invQ * n + n2);
+        return { c1 * n * invQ, 0.0, -c1 * n * invQ,
+                 c1 * 2.0 * (1.0 - n2), c1 * (1.0 - invQ * n + n2) };
+    }
+
+    inline BiquadCoeffs highPass (double sampleRate, double freq,
+                                  double q = juce::MathConstants<double>::sqrt2 * 0.5) noexcept
+    {
+        const double n    = std::tan (juce::MathConstants<double>::pi * freq / sampleRate);
+        const double n2   = n * n;
+        const double invQ = 1.0 / q;
+        const double c1   = 1.0 / (1.0 + invQ * n + n2);
+        return { c1, -2.0 * c1, c1,
+                 c1 * 2.0 * (n2 - 1.0), c1 * (1.0 - invQ * n + n2) };
+    }
+
+    inline BiquadCoeffs lowPass (double sampleRate, double freq,
+                                 double q = juce::MathConstants<double>::sqrt2 * 0.5) noexcept
+    {
+        const double n    = 1.0 / std::tan (juce::MathConstants<double>::pi * freq / sampleRate);
+        const double n2   = n * n;
+        const double invQ = 1.0 / q;
+        const double c1   = 1.0 / (1.0 + invQ * n + n2);
+        return { c1, c1 * 2.0, c1,
+                 c1 * 2.0 * (1.0 - n2), c1 * (1.0 - invQ * n + n2) };
+    }
+
+    // 既存の IIR::Coefficients（2次）へ確保なしで書き込む
+    template <typename SampleType>
+    void copyTo (const BiquadCoeffs& c, juce::dsp::IIR::Coefficients<SampleType>& dst) noexcept
+    {
+        jassert (dst.getFilterOrder() == 2);
+        auto* raw = dst.getRawCoefficients();
+        raw[0] = (SampleType) c.b0; raw[1] = (SampleType) c.b1; raw[2] = (SampleType) c.b2;
+        raw[3] = (SampleType) c.a1; raw[4] = (SampleType) c.a2;
+    }
+}
@@ -0,0 +1,137 @@
+#include "DynamicsDetector.h"
+
+void DynamicsDetector::prepare (double sampleRate, int maxBlockSize, ScratchArena& arena)
+{
+    sr = sampleRate;
+    maxBlock = juce::jmax (1, maxBlockSize);
+
+    // 数えるパスでは nullptr（process は何もしない）
+    mono = arena.take<float> ((size_t) maxBlock);
+    for (auto& g : gains)
+    {
+        g = arena.take<float> ((size_t) maxBlock);
+        if (g != nullptr)
+            std::fill (g, g + maxBlock, 1.0f);
+    }
+
+    // 全帯域のレーンは恒等。帯域のレーンは係数エンジンから setBand で入る
+    for (int l = 0; l < numLanes; ++l)
+        setBand (l, {});
+
+    setTiming (5.0f, 120.0f);
+    reset();
+}
+
+void DynamicsDetector::reset() noexcept
+{
+    s1.fill (0.0f);
+    s2.fill (0.0f);
+    envelope.fill (0.0f);
+    current.fill (1.0f);
+    target.fill (1.0f);
+    step.fill (0.0f);
+    counter = 0;    // 次のサンプルで目標を計算し直す
+}
+
+void DynamicsDetector::setBand (int lane, const BiquadCoeffs& c) noexcept
+{
+    const auto l = (size_t) lane;
+    b0[l] = (float) c.b0; b1[l] = (float) c.b1; b2[l] = (float) c.b2;
+    a1[l] = (float) c.a1; a2[l] = (float) c.a2;
+}
+
+void DynamicsDetector::setTiming (float attackMs, float releaseMs) noexcept
+{
+    const auto coefficient = [this] (float ms)
+    {
+        return 1.0f - (float) std::exp (-1.0 / (juce::jmax (0.01, (double) ms) * 0.001 * sr));
+    };
+
+    attack  = coefficient (attackMs);
+    release = coefficient (releaseMs);
+}
+
+void DynamicsDetector::setLane (int lane, float threshold, float range) noexcept
+{
+    thresholdDb[(size_t) lane] = threshold;
+    rangeDb[(size_t) lane] = range;
+}
+
+void DynamicsDetector::updateTargets() noexcept
+{
+    // 前の区間の目標にそろえてから次の目標へ（ランプの丸めを溜めない。キーが無音なら 1 のまま）
+    for (size_t l = 0; l < (size_t) numLanes; ++l)
+    {
+        current[l] = target[l];
+
+        float gain = 1.0f;
+        if (rangeDb[l] != 0.0f)
+        {
+            const float levelDb = 20.0f * std::log10 (juce::jmax (envelope[l], 1.0e-7f));
+            const float amount  = juce::jlimit (0.0f, 1.0f, (levelDb - thresholdDb[l]) / fullRangeDb);
+            if (amount > 0.0f)
+                gain = juce::Decibels::decibelsToGain (rangeDb[l] * amount);
+        }
+
+        target[l] = gain;
+        step[l] = (gain - current[l]) / (float) gainInterval;
+    }
+}
+
+template <typename SampleType>
+void DynamicsDetector::process (const SampleType* const* key, int numKeyChannels, int startSample, int numSamples) noexcept
+{
+    jassert (mono != nullptr && numSamples <= maxBlock);
+    if (mono == nullptr)
+        return;
+    numSamples = juce::jmin (numSamples, maxBlock);
+
+    // キーのモノ和（チャンネル平均）
+    float* x = mono;
+    if (numKeyChannels <= 0)
+    {
+        std::fill (x, x + numSamples, 0.0f);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+            x[i] = (float) key[0][startSample + i];
+
+        for (int ch = 1; ch < numKeyChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                x[i] += (float) key[ch][startSample + i];
+
+        if (numKeyChannels > 1)
+            juce::FloatVectorOperations::multiply (x, 1.0f / (float) numKeyChannels, numSamples);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // 4 レーン同時：BPF（TDF-II）→ 整流 → アタック／リリース
+        for (size_t l = 0; l < (size_t) numLanes; ++l)
+        {
+            const float y = b0[l] * x[i] + s1[l];
+            s1[l] = b1[l] * x[i] - a1[l] * y + s2[l];
+            s2[l] = b2[l] * x[i] - a2[l] * y;
+
+            const float r = std::abs (y);
+            const float c = r > envelope[l] ? attack : release;
+            envelope[l] += c * (r - envelope[l]);
+        }
+
+        if (--counter <= 0)
+        {
+            updateTargets();
+            counter = gainInterval;
+        }
+
+        for (size_t l = 0; l < (size_t) numLanes; ++l)
+        {
+            current[l] += step[l];
+            gains[l][(size_t) i] = current[l];
+        }
+    }
+}
+
+template void DynamicsDetector::process<float>  (const float* const*,  int, int, int) noexcept;
+template void DynamicsDetector::process<double> (const double* const*, int, int, int) noexcept;
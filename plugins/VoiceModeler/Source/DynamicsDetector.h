@@ -0,0 +1,61 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "BiquadCoefficients.h"
+#include "ScratchArena.h"
+#include <array>
+
+// 動的 EQ／RBass ダッキングの検出器。キー信号（入力 or サイドチェイン）のモノ和から、
+// 4 つのレーン（EQ1–3 の帯域、RBass は全帯域）の包絡をブロックごとにまとめて計算し、サンプルごとのゲイン（倍率）を出す。
+//
+//   レーン：BPF（全帯域のレーンは恒等）→ 整流 → アタック／リリースの 1 極 → gainInterval ごとにゲインを計算して直線補間
+//   ゲイン：しきい値を超えた量に比例して rangeDb まで（しきい値から fullRangeDb 上でいっぱい）。0 dB 以下なら 1
+//
+// 4 レーンは同じ処理を同じ順に通るので、レーンを内側のループにして SIMD 1 本で回す。
+// 内部は float（キーの精度は問わない）。作業域は prepare で ScratchArena から切り出し、処理中は確保しない。
+class DynamicsDetector
+{
+public:
+    enum Lane { eq1, eq2, eq3, rbass, numLanes };
+
+    static constexpr int gainInterval = 16;         // ゲイン計算の間隔（サンプル）
+    static constexpr float fullRangeDb = 12.0f;
+
+    void prepare (double sampleRate, int maxBlockSize, ScratchArena& arena);
+    void reset() noexcept;                          // 包絡・BPF の状態を捨て、ゲインを 1 に戻す
+
+    void setBand (int lane, const BiquadCoeffs& bandPass) noexcept;
+    void setTiming (float attackMs, float releaseMs) noexcept;
+    void setLane (int lane, float thresholdDb, float rangeDb) noexcept;
+
+    // レーンを処理する必要があるか（range が 0 でないか、ゲインがまだ 1 に戻りきっていない）
+    bool isEngaged (int lane) const noexcept
+    {
+        const auto l = (size_t) lane;
+        return rangeDb[l] != 0.0f || target[l] != 1.0f || current[l] != 1.0f;
+    }
+
+    // キーの [startSample, startSample + numSamples) を検出。numKeyChannels が 0 ならキーは無音
+    template <typename SampleType>
+    void process (const SampleType* const* key, int numKeyChannels, int startSample, int numSamples) noexcept;
+
+    // 直近の process の区間のゲイン（先頭が startSample に対応）
+    const float* getGains (int lane) const noexcept { return gains[(size_t) lane]; }
+
+private:
+    void updateTargets() noexcept;
+
+    double sr = 48000.0;
+
+    // レーンの状態（SoA）
+    alignas (16) std::array<float, numLanes> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    alignas (16) std::array<float, numLanes> s1 {}, s2 {}, envelope {};
+    alignas (16) std::array<float, numLanes> current {}, target {}, step {};   // ゲインのランプ（区間の終わりで target）
+    std::array<float, numLanes> thresholdDb {}, rangeDb {};
+    float attack = 1.0f, release = 1.0f;            // 1 極の係数（1 サンプルで近づく割合）
+    int counter = 0;                                // 次のゲイン計算までのサンプル数
+
+    // ScratchArena の領域（maxBlock サンプルずつ）
+    float* mono = nullptr;
+    std::array<float*, numLanes> gains {};
+    int maxBlock = 0;
+};
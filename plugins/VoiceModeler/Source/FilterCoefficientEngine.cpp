@@ -0,0 +1,263 @@
+#include "FilterCoefficientEngine.h"
+#include "ParameterIDs.h"
+
+namespace
+{
+    // Source の並びと一致させること
+    const char* const sourceIDs[] = {
+        IDs::formantRatio, IDs::nasalAmt, IDs::nasalNotch, IDs::rbFocusHz,
+        IDs::eq1Freq, IDs::eq1Gain, IDs::eq1Q,
+        IDs::eq2Freq, IDs::eq2Gain, IDs::eq2Q,
+        IDs::eq3Freq, IDs::eq3Gain, IDs::eq3Q
+    };
+}
+
+FilterCoefficientEngine::FilterCoefficientEngine (juce::AudioProcessorValueTreeState& state)
+: apvts (state)
+{
+    static_assert (std::size (sourceIDs) == numSources, "sourceIDs と Source の並びがずれている");
+
+    const juce::uint32 sourceBands[numSources] = {
+        bit (formant1) | bit (formant2) | bit (formant3),
+        bit (nasal1k) | bit (nasal3k),
+        bit (notch1k) | bit (notch3k),
+        bit (rbassFocus),
+        bit (eq1) | bit (dynamic1), bit (eq1), bit (eq1) | bit (dynamic1),
+        bit (eq2) | bit (dynamic2), bit (eq2), bit (eq2) | bit (dynamic2),
+        bit (eq3) | bit (dynamic3), bit (eq3), bit (eq3) | bit (dynamic3)
+    };
+
+    for (int s = 0; s < numSources; ++s)
+    {
+        auto& src = sources[(size_t) s];
+        src.raw      = apvts.getRawParameterValue (sourceIDs[s]);
+        src.bands    = sourceBands[s];
+        src.logScale = s == rbassFocusHz || s == eq1Freq || s == eq2Freq || s == eq3Freq;
+
+        apvts.addParameterListener (sourceIDs[s], this);
+    }
+}
+
+FilterCoefficientEngine::~FilterCoefficientEngine()
+{
+    for (auto* id : sourceIDs)
+        apvts.removeParameterListener (id, this);
+}
+
+void FilterCoefficientEngine::prepare (double sampleRate, double rampSeconds)
+{
+    sr = sampleRate;
+
+    for (auto& src : sources)
+    {
+        src.value.reset (sampleRate, rampSeconds);
+        src.value.setCurrentAndTargetValue (src.toSmoothed (src.rawValue()));
+    }
+
+    smoothingMask = 0;
+    sourceDirty.store (0);
+    markDirty (allBands);
+}
+
+int FilterCoefficientEngine::findSource (const juce::String& parameterID) noexcept
+{
+    for (int s = 0; s < numSources; ++s)
+        if (parameterID == sourceIDs[s])
+            return s;
+    return -1;
+}
+
+void FilterCoefficientEngine::parameterChanged (const juce::String& parameterID, float)
+{
+    // ホストのオートメーションではオーディオスレッドから呼ばれることもある。ビットを立てるだけ。
+    if (const int s = findSource (parameterID); s >= 0)
+        sourceDirty.fetch_or (sourceBit (s), std::memory_order_release);
+}
+
+void FilterCoefficientEngine::retarget (int source, float plainValue, juce::uint32& jumped) noexcept
+{
+    auto& src = sources[(size_t) source];
+    src.value.setTargetValue (src.toSmoothed (plainValue));
+
+    if (src.value.isSmoothing())
+        smoothingMask |= sourceBit (source);
+    else
+        jumped |= src.bands; // ランプなしで値が変わった場合
+}
+
+void FilterCoefficientEngine::pullTargets (juce::uint32 exceptSources) noexcept
+{
+    const auto mask = sourceDirty.fetch_and (exceptSources, std::memory_order_acquire) & ~exceptSources;
+    if (mask == 0)
+        return;
+
+    juce::uint32 jumped = 0;
+
+    for (int s = 0; s < numSources; ++s)
+        if ((mask & sourceBit (s)) != 0)
+            retarget (s, sources[(size_t) s].rawValue(), jumped);
+
+    if (jumped != 0)
+        markDirty (jumped);
+}
+
+void FilterCoefficientEngine::setTarget (int source, float plainValue) noexcept
+{
+    jassert (juce::isPositiveAndBelow (source, (int) numSources));
+
+    juce::uint32 jumped = 0;
+    retarget (source, plainValue, jumped);
+
+    if (jumped != 0)
+        markDirty (jumped);
+}
+
+void FilterCoefficientEngine::setTrackedFormants (const float* hz, float voicing) noexcept
+{
+    // 推定値は 10 ms ごとに少しずつ動くので、約 0.5 % / 有声度 0.02 未満の変化では係数を作り直さない
+    constexpr float hzTolerance = 0.005f, voicingTolerance = 0.02f;
+
+    bool changed = (hz != nullptr) != tracking;
+
+    if (hz != nullptr)
+    {
+        for (size_t k = 0; k < trackedHz.size(); ++k)
+            changed = changed || std::abs (hz[k] - trackedHz[k]) > hzTolerance * trackedHz[k];
+        changed = changed || std::abs (voicing - trackedVoicing) > voicingTolerance;
+    }
+
+    if (! changed)
+        return;
+
+    tracking = hz != nullptr;
+    if (tracking)
+    {
+        std::copy (hz, hz + trackedHz.size(), trackedHz.begin());
+        trackedVoicing = juce::jlimit (0.0f, 1.0f, voicing);
+    }
+
+    markDirty (bit (formant1) | bit (formant2) | bit (formant3));
+}
+
+juce::uint32 FilterCoefficientEngine::update (int numSamples) noexcept
+{
+    auto mask = bandDirty.exchange (0, std::memory_order_acquire);
+
+    if (smoothingMask != 0)
+    {
+        for (int s = 0; s < numSources; ++s)
+        {
+            if ((smoothingMask & (1u << (juce::uint32) s)) == 0)
+                continue;
+
+            auto& src = sources[(size_t) s];
+            src.value.skip (numSamples);
+            mask |= src.bands;
+
+            if (! src.value.isSmoothing())
+                smoothingMask &= ~(1u << (juce::uint32) s);
+        }
+    }
+
+    if (mask != 0)
+        for (int b = 0; b < numBands; ++b)
+            if ((mask & bit ((Band) b)) != 0)
+                computeBand ((Band) b);
+
+    return mask;
+}
+
+BiquadCoeffs FilterCoefficientEngine::design (CoefficientCache::Shape shape, double freq, double q, double gainFactor) noexcept
+{
+    return cache != nullptr ? cache->get (shape, sr, freq, q, gainFactor)
+                            : CoefficientCache::compute (shape, sr, freq, q, gainFactor);
+}
+
+void FilterCoefficientEngine::computeBand (Band b) noexcept
+{
+    using Shape = CoefficientCache::Shape;
+    auto& c = coeffs[(size_t) b];
+
+    switch (b)
+    {
+        case hpf:
+            // HPF（20～30Hz 目安）
+            c = design (Shape::highPass, 25.0, juce::MathConstants<double>::sqrt2 * 0.5);
+            break;
+
+        case formant1:
+        case formant2:
+        case formant3:
+        {
+            // フォルマント基準（500/1500/2500 Hz、Adaptive なら追跡値 × ratio）
+            static constexpr float baseHz[] = { 500.0f, 1500.0f, 2500.0f };
+            static constexpr float slope[]  = { 2.0f, 1.5f, 1.0f };
+            const int k = (int) b - (int) formant1;
+
+            // 無声・無音の間は追跡値が当てにならないので、ゲインを 0 dB へ寄せる
+            const float centre = tracking ? trackedHz[(size_t) k] : baseHz[k];
+            const float depth  = tracking ? trackedVoicing : 1.0f;
+
+            const float ratio = value (formantRatio); // 0.7–1.4
+            const float G = juce::Decibels::decibelsToGain (depth * slope[k] * (ratio - 1.0f));
+            c = design (Shape::peak, juce::jmin (centre * ratio, (float) (0.45 * sr)), 1.2, juce::jlimit (0.5f, 1.5f, G));
+            break;
+        }
+
+        case nasal1k:
+        case nasal3k:
+        {
+            // 鼻腔レゾナンス
+            const float nasalGainDb = juce::jmap (value (nasalAmt), 0.0f, 100.0f, 0.0f, 8.0f);
+            c = b == nasal1k ? design (Shape::peak, 1000.0, 2.0, juce::Decibels::decibelsToGain (nasalGainDb))
+                             : design (Shape::peak, 3000.0, 2.5, juce::Decibels::decibelsToGain (nasalGainDb * 0.7f));
+            break;
+        }
+
+        case notch1k:
+        case notch3k:
+        {
+            // 反共鳴ノッチ（=負ゲインのピーク）
+            const float notchDepthDb = -juce::jmap (value (nasalNotch), 0.0f, 100.0f, 0.0f, 12.0f);
+            c = b == notch1k ? design (Shape::peak, 1000.0, 2.0, juce::Decibels::decibelsToGain (notchDepthDb))
+                             : design (Shape::peak, 3000.0, 2.5, juce::Decibels::decibelsToGain (notchDepthDb * 0.8f));
+            break;
+        }
+
+        case eq1:
+        case eq2:
+        case eq3:
+        {
+            // 3-band EQ
+            const int k = ((int) b - (int) eq1) * 3;
+            c = design (Shape::peak,
+                        juce::jlimit (20.0f, 18000.0f, value ((Source) (eq1Freq + k))),
+                        juce::jlimit (0.3f, 5.0f,      value ((Source) (eq1Q + k))),
+                        juce::Decibels::decibelsToGain (juce::jlimit (-18.0f, 18.0f, value ((Source) (eq1Gain + k)))));
+            break;
+        }
+
+        case rbassFocus:
+        {
+            // RBass BPF
+            const float focus = juce::jlimit (40.0f, 240.0f, value (rbassFocusHz));
+            c = design (Shape::bandPass, focus, 1.0);
+            break;
+        }
+
+        case dynamic1:
+        case dynamic2:
+        case dynamic3:
+        {
+            // 動的 EQ：ピーク 0 dB の BPF（1 + (g - 1) × BPF が中心で g 倍のピークになる）
+            const int k = ((int) b - (int) dynamic1) * 3;
+            c = design (Shape::bandPass,
+                        juce::jlimit (20.0f, juce::jmin (18000.0f, (float) (0.45 * sr)), value ((Source) (eq1Freq + k))),
+                        juce::jlimit (0.3f, 5.0f, value ((Source) (eq1Q + k))));
+            break;
+        }
+
+        case numBands:
+            break;
+    }
+}
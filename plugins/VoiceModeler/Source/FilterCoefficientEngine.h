@@ -0,0 +1,110 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "BiquadCoefficients.h"
+#include "SharedResources.h"
+#include <array>
+
+// パラメータ変更をリスナーで検知し、影響するバンドだけ係数を再計算する。
+// 係数は事前確保した BiquadCoeffs 配列に書くだけで、オーディオスレッドでは確保しない。
+//
+// 係数に効くパラメータはサンプル単位でスムージングし、呼び出し側が
+// コントロールレート（例：32 サンプル）ごとに update() で進める。
+// 動いているバンドだけがその都度再計算される。
+class FilterCoefficientEngine : private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+    enum Band
+    {
+        hpf,
+        formant1, formant2, formant3,
+        nasal1k, nasal3k,
+        notch1k, notch3k,
+        eq1, eq2, eq3,
+        rbassFocus,
+        dynamic1, dynamic2, dynamic3,   // 動的 EQ の帯域分割（EQ1–3 と同じ中心・Q の BPF。チェインには入らない）
+        numBands
+    };
+
+    static constexpr juce::uint32 bit (Band b) noexcept { return 1u << (juce::uint32) b; }
+    static constexpr juce::uint32 allBands = (1u << (juce::uint32) numBands) - 1u;
+
+    explicit FilterCoefficientEngine (juce::AudioProcessorValueTreeState&);
+    ~FilterCoefficientEngine() override;
+
+    // サンプルレート変更時：スムーザーを現在値に揃え、全バンドを dirty にする
+    void prepare (double sampleRate, double rampSeconds = 0.05);
+
+    // オーディオスレッド用：ブロック先頭でリスナーが立てたフラグを拾い、スムーザーの目標値を更新。
+    // exceptSources のソースはフラグを残して読まない（ブロック内のオートメーション点で setTarget する）
+    void pullTargets (juce::uint32 exceptSources = 0) noexcept;
+
+    // サンプル精度のオートメーション用：パラメータ ID → ソース番号（係数に効かなければ -1）と、目標値の直接設定（実値）
+    static int findSource (const juce::String& parameterID) noexcept;
+    static constexpr juce::uint32 sourceBit (int source) noexcept { return 1u << (juce::uint32) source; }
+    void setTarget (int source, float plainValue) noexcept;
+
+    // いずれかのパラメータがまだ目標値へ移動中か
+    bool isSmoothing() const noexcept { return smoothingMask != 0; }
+
+    // スムーザーを numSamples 進め、値が動いた／dirty なバンドだけ再計算。更新したバンドのマスクを返す
+    juce::uint32 update (int numSamples) noexcept;
+
+    const BiquadCoeffs& get (Band b) const noexcept { return coeffs[(size_t) b]; }
+
+    void markDirty (juce::uint32 mask) noexcept { bandDirty.fetch_or (mask, std::memory_order_release); }
+
+    // Adaptive フォルマント（オーディオスレッド）：F1–F3 の中心を追跡値（Hz）× ratio にし、ゲインを有声度で絞る。
+    // nullptr で固定の 500/1500/2500 Hz に戻す。許容差を超えて動いたときだけフォルマント段を dirty にする
+    void setTrackedFormants (const float* hz, float voicing) noexcept;
+
+    // 係数を全インスタンス共有のキャッシュ経由で作る（nullptr で直接計算）。prepare の前に設定すること
+    void setCoefficientCache (CoefficientCache* sharedCache) noexcept { cache = sharedCache; }
+
+private:
+    // スムージング単位（係数に効くパラメータ）
+    enum Source
+    {
+        formantRatio, nasalAmt, nasalNotch, rbassFocusHz,
+        eq1Freq, eq1Gain, eq1Q,
+        eq2Freq, eq2Gain, eq2Q,
+        eq3Freq, eq3Gain, eq3Q,
+        numSources
+    };
+
+    struct SmoothedSource
+    {
+        std::atomic<float>* raw = nullptr;
+        juce::uint32 bands = 0;
+        bool logScale = false;   // 周波数は対数領域で補間
+        juce::SmoothedValue<float> value;
+
+        float toSmoothed (float v) const noexcept   { return logScale ? std::log (juce::jmax (v, 1.0e-3f)) : v; }
+        float current() const noexcept              { return logScale ? std::exp (value.getCurrentValue()) : value.getCurrentValue(); }
+        float rawValue() const noexcept             { return raw != nullptr ? raw->load (std::memory_order_relaxed) : 0.0f; }
+    };
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void retarget (int source, float plainValue, juce::uint32& jumped) noexcept;
+    void computeBand (Band b) noexcept;
+    BiquadCoeffs design (CoefficientCache::Shape, double freq, double q, double gainFactor = 1.0) noexcept;
+
+    float value (Source s) const noexcept { return sources[(size_t) s].current(); }
+
+    juce::AudioProcessorValueTreeState& apvts;
+
+    std::array<SmoothedSource, numSources> sources;
+    std::array<BiquadCoeffs, numBands> coeffs {};
+
+    std::atomic<juce::uint32> sourceDirty { 0 };          // 目標値が変わったパラメータ
+    std::atomic<juce::uint32> bandDirty   { allBands };   // 強制再計算するバンド
+    juce::uint32 smoothingMask = 0;                        // 移動中のパラメータ（オーディオスレッド専用）
+    double sr = 48000.0;
+    CoefficientCache* cache = nullptr;
+
+    // 追跡したフォルマント（オーディオスレッド専用）
+    bool tracking = false;
+    std::array<float, 3> trackedHz { 500.0f, 1500.0f, 2500.0f };
+    float trackedVoicing = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE (FilterCoefficientEngine)
+};
@@ -0,0 +1,144 @@
+#include "FormantShifter.h"
+
+void FormantShifter::prepare (double sampleRate, int numChannelsToUse, ScratchArena& arena)
+{
+    // 48 kHz で 1024（≒21 ms）。高いサンプルレートでも時間分解能をそろえる
+    int order = 10;
+    while (order < 13 && (double) (1 << order) < sampleRate * 0.02)
+        ++order;
+
+    frameSize = 1 << order;
+    hopSize   = frameSize / 4;
+    mask      = frameSize - 1;
+
+    // 1.5 ms 未満のケフレンシを包絡とみなす（基本周期 ≒ 2.5 ms @400 Hz より短く）
+    lifterLength = juce::jlimit (8, frameSize / 2 - 1, juce::roundToInt (sampleRate * 0.0015));
+
+    if (fft == nullptr || fft->getSize() != frameSize)
+        fft = std::make_unique<juce::dsp::FFT> (order);
+    window = resources->getWindow (SharedResources::Window::hannPeriodic, frameSize);
+
+    // 数えるパスではどれも nullptr（process は何もしない）
+    numChannels = juce::jmax (1, numChannelsToUse);
+    input       = arena.take<float> ((size_t) (numChannels * frameSize));
+    output      = arena.take<float> ((size_t) (numChannels * frameSize));
+    spectrum    = arena.take<float> ((size_t) (2 * frameSize));
+    cepstrum    = arena.take<float> ((size_t) (2 * frameSize));
+    logEnvelope = arena.take<float> ((size_t) (frameSize / 2 + 1));
+
+    reset();
+}
+
+void FormantShifter::reset() noexcept
+{
+    if (input != nullptr)
+    {
+        std::fill (input, input + numChannels * frameSize, 0.0f);
+        std::fill (output, output + numChannels * frameSize, 0.0f);
+    }
+
+    ringPos = 0;
+    hopCounter = 0;
+}
+
+template <typename SampleType>
+void FormantShifter::process (SampleType* const* data, int numChannelsToProcess, int startSample, int numSamples) noexcept
+{
+    if (fft == nullptr || input == nullptr)
+        return;
+
+    const int chs = juce::jmin (numChannelsToProcess, numChannels);
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        // 次のフレーム境界までをまとめて入出力
+        const int len = juce::jmin (numSamples - pos, hopSize - hopCounter);
+
+        for (int c = 0; c < chs; ++c)
+        {
+            auto* in  = input  + c * frameSize;
+            auto* out = output + c * frameSize;
+            auto* io = data[c] + startSample + pos;
+            int rp = ringPos;
+
+            for (int i = 0; i < len; ++i)
+            {
+                in[rp] = (float) io[i];
+                io[i] = (SampleType) out[rp];
+                out[rp] = 0.0f;
+                rp = (rp + 1) & mask;
+            }
+        }
+
+        ringPos = (ringPos + len) & mask;
+        hopCounter += len;
+        pos += len;
+
+        if (hopCounter == hopSize)
+        {
+            hopCounter = 0;
+            for (int c = 0; c < chs; ++c)
+                processFrame (c);
+        }
+    }
+}
+
+template void FormantShifter::process<float>  (float* const*,  int, int, int) noexcept;
+template void FormantShifter::process<double> (double* const*, int, int, int) noexcept;
+
+void FormantShifter::processFrame (int channel) noexcept
+{
+    const int half = frameSize / 2;
+    const auto* in = input + channel * frameSize;
+    auto* out = output + channel * frameSize;
+    auto* X = spectrum;
+    auto* C = cepstrum;
+    const auto* win = window->data();
+
+    // 1) 窓掛け → FFT（ringPos が最古のサンプル）
+    for (int i = 0; i < frameSize; ++i)
+        X[i] = in[(ringPos + i) & mask] * win[i];
+    std::fill (X + frameSize, X + 2 * frameSize, 0.0f);
+    fft->performRealOnlyForwardTransform (X, true);
+
+    // 2) 対数振幅 → 実ケプストラム → リフタ → 包絡（対数振幅の平滑）
+    for (int k = 0; k <= half; ++k)
+    {
+        const float re = X[2 * k], im = X[2 * k + 1];
+        C[2 * k]     = 0.5f * std::log (re * re + im * im + 1.0e-20f);
+        C[2 * k + 1] = 0.0f;
+    }
+    std::fill (C + frameSize + 2, C + 2 * frameSize, 0.0f);
+    fft->performRealOnlyInverseTransform (C);
+
+    std::fill (C + lifterLength + 1, C + frameSize - lifterLength, 0.0f);
+    std::fill (C + frameSize, C + 2 * frameSize, 0.0f);
+    fft->performRealOnlyForwardTransform (C, true);
+
+    for (int k = 0; k <= half; ++k)
+        logEnvelope[k] = C[2 * k];
+
+    // 3) 包絡を周波数方向に ratio 倍した包絡との比をゲインに（-30〜+18 dB に制限）
+    const float invRatio = 1.0f / juce::jlimit (0.5f, 2.0f, ratio);
+
+    for (int k = 0; k <= half; ++k)
+    {
+        const float src = (float) k * invRatio;
+        const int k0 = (int) src;
+
+        const float warped = k0 >= half ? logEnvelope[half]
+                                        : logEnvelope[k0] + (src - (float) k0) * (logEnvelope[k0 + 1] - logEnvelope[k0]);
+
+        const float g = std::exp (juce::jlimit (-3.45f, 2.07f, warped - logEnvelope[k]));
+        X[2 * k]     *= g;
+        X[2 * k + 1] *= g;
+    }
+
+    // 4) IFFT → 合成窓 → 重畳加算（Hann² を 1/4 ホップで重ねると 1.5 になるので 2/3 倍）
+    std::fill (X + frameSize + 2, X + 2 * frameSize, 0.0f);
+    fft->performRealOnlyInverseTransform (X);
+
+    constexpr float olaGain = 2.0f / 3.0f;
+    for (int i = 0; i < frameSize; ++i)
+        out[(ringPos + i) & mask] += X[i] * win[i] * olaGain;
+}
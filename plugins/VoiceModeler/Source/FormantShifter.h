@@ -0,0 +1,53 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "ScratchArena.h"
+#include "SharedResources.h"
+#include <memory>
+#include <vector>
+
+// ケプストラム包絡の周波数軸ワープによるフォルマントシフト（STFT 重畳加算）。
+//
+// フレームごとに
+//   1) Hann 窓 → FFT
+//   2) 対数振幅 → 実ケプストラム → 低ケフレンシだけ残して（リフタ）包絡を推定
+//   3) 包絡を ratio 倍に伸縮した包絡との比を各ビンのゲインとして掛ける（位相はそのまま）
+//   4) IFFT → Hann 窓 → 重畳加算
+// ピッチ（調波の間隔）は変わらず、声道の共鳴だけが移動する。
+//
+// フレーム長は約 21 ms になる 2 のべき乗（48 kHz で 1024）、ホップはその 1/4。
+// レイテンシはフレーム長ぶんで、ホストのブロック長には依存しない。
+// リングと FFT の作業域は prepare で ScratchArena から切り出し、処理中は確保しない。窓は全インスタンスで共有（SharedResources）、FFT は各自。
+class FormantShifter
+{
+public:
+    void prepare (double sampleRate, int numChannels, ScratchArena& arena);
+    void reset() noexcept;
+
+    // 0.7–1.4（>1 でフォルマントを上へ）。フレーム境界で反映
+    void setRatio (float newRatio) noexcept { ratio = newRatio; }
+
+    int getLatencySamples() const noexcept { return frameSize; }
+    int getFrameSize() const noexcept      { return frameSize; }
+
+    // in-place で [startSample, startSample + numSamples) を処理（float / double。内部は float）
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannelsToProcess, int startSample, int numSamples) noexcept;
+
+private:
+    void processFrame (int channel) noexcept;
+
+    juce::SharedResourcePointer<SharedResources> resources;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::shared_ptr<const std::vector<float>> window; // Hann（周期版）
+    // ScratchArena の領域
+    float* input = nullptr;          // 直近 frameSize サンプルのリング [ch][frameSize]
+    float* output = nullptr;         // 重畳加算の出力リング [ch][frameSize]
+    float* spectrum = nullptr;       // FFT 作業域（2 × frameSize）
+    float* cepstrum = nullptr;       // 同上（包絡推定用）
+    float* logEnvelope = nullptr;    // frameSize/2 + 1 ビン
+
+    int numChannels = 1, frameSize = 1024, hopSize = 256, mask = 1023;
+    float ratio = 1.0f;
+    int lifterLength = 72;           // 残すケフレンシ（サンプル）
+    int ringPos = 0, hopCounter = 0; // 全チャンネル共通（同じ区間を処理するため）
+};
@@ -0,0 +1,408 @@
+#include "FormantTracker.h"
+
+namespace
+{
+    // 1 フレームの長さ・ホップと、根を F1–F3 として受け入れる範囲
+    constexpr double frameSeconds = 0.025;
+    constexpr double hopSeconds   = 0.010;
+    // F1 はラグ窓とプリエンファシスで帯域幅が広めに出る。F2 以降は狭くして、声門の傾きが作る広い根を拾わない
+    constexpr float minHz[] = { 200.0f,  550.0f, 1400.0f };
+    constexpr float maxHz[] = { 1100.0f, 3000.0f, 4200.0f };
+    constexpr float maxBandwidthHz[] = { 800.0f, 500.0f, 600.0f };
+
+    // 有声判定：-50 dBFS 以上で、1 次の自己相関（正規化）が高い＝低域が優勢
+    constexpr double voicedEnergy = 1.0e-5;
+    constexpr double voicedCorrelation = 0.6;
+
+    // 1 ホップあたりの追従（有声のとき 10 ms ごとに差の半分）。直前の有声フレームとこの比率以内で
+    // 揃ったときだけ追従する（有声／無声の境目で 1 フレームだけ混ざった外れ値を拾わない）
+    constexpr float formantFollow = 0.5f;
+    constexpr float confirmRatio  = 0.15f;
+    constexpr float voicingFollow = 0.3f;
+
+    constexpr int maxRootIterations = 40;
+}
+
+//==============================================================================
+// 間引いた信号を FIFO から取り出して解析するスレッド（オーディオスレッドからは起こさず、短い間隔で見に行く）
+class FormantTracker::Worker : public juce::Thread
+{
+public:
+    explicit Worker (FormantTracker& t) : juce::Thread ("FormantTracker"), owner (t) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            drain();
+            wait (5);
+        }
+    }
+
+    void drain() noexcept
+    {
+        if (owner.resetRequested.exchange (false))
+            owner.resetAnalysis();
+
+        auto& fifo = *owner.fifo;
+        const auto scope = fifo.read (fifo.getNumReady());
+        for (int i = 0; i < scope.blockSize1; ++i) owner.consume (owner.fifoBuffer[(size_t) (scope.startIndex1 + i)]);
+        for (int i = 0; i < scope.blockSize2; ++i) owner.consume (owner.fifoBuffer[(size_t) (scope.startIndex2 + i)]);
+    }
+
+private:
+    FormantTracker& owner;
+};
+
+//==============================================================================
+FormantTracker::FormantTracker()
+{
+    const Estimate defaults;
+    for (int k = 0; k < numFormants; ++k)
+        outHz[(size_t) k].store (defaults.hz[(size_t) k]);
+}
+
+FormantTracker::~FormantTracker()
+{
+    release();
+}
+
+void FormantTracker::prepare (double sampleRate, bool useBackgroundThread)
+{
+    release();
+
+    // 約 10–12 kHz（F3 の上限 4.2 kHz より十分上）に間引く。LPF は新しいナイキストの 8 割
+    decimation   = juce::jmax (1, (int) (sampleRate / 10000.0));
+    analysisRate = sampleRate / decimation;
+
+    const double cutoff = juce::jmin (0.4 * analysisRate, 0.45 * sampleRate);
+    aaCoeffs[0] = BiquadDesign::lowPass (sampleRate, cutoff, 0.54119610);
+    aaCoeffs[1] = BiquadDesign::lowPass (sampleRate, cutoff, 1.30656296);
+
+    frameLength = juce::roundToInt (frameSeconds * analysisRate);
+    hopLength   = juce::roundToInt (hopSeconds * analysisRate);
+    emphasis    = std::exp (-juce::MathConstants<double>::twoPi * 50.0 / analysisRate);
+
+    ring.assign ((size_t) frameLength, 0.0f);
+    frame.assign ((size_t) frameLength, 0.0f);
+    window = resources->getWindow (SharedResources::Window::hammingSymmetric, frameLength);
+
+    tracked = {};
+    for (int k = 0; k < numFormants; ++k)
+        outHz[(size_t) k].store (tracked.hz[(size_t) k]);
+    outVoicing.store (0.0f);
+
+    reset();
+    resetAnalysis();
+
+    if (useBackgroundThread)
+    {
+        // 約 0.3 秒ぶん。ワーカーが遅れて溢れたら、その分は解析しない
+        const int capacity = juce::nextPowerOfTwo ((int) (analysisRate * 0.3));
+        fifo = std::make_unique<juce::AbstractFifo> (capacity);
+        fifoBuffer.assign ((size_t) capacity, 0.0f);
+
+        worker = std::make_unique<Worker> (*this);
+        worker->startThread();
+    }
+}
+
+void FormantTracker::release()
+{
+    if (worker != nullptr)
+    {
+        worker->stopThread (1000);
+        worker.reset();
+    }
+
+    fifo.reset();
+}
+
+void FormantTracker::reset() noexcept
+{
+    for (auto& s : aaState)
+        s = {};
+    decimationPhase = 0;
+
+    // 解析側の状態はワーカーが持っているので、ワーカーがいればそちらで捨てる
+    if (worker != nullptr)
+        resetRequested.store (true);
+    else
+        resetAnalysis();
+}
+
+void FormantTracker::resetAnalysis() noexcept
+{
+    std::fill (ring.begin(), ring.end(), 0.0f);
+    ringPos = 0;
+    hopCounter = 0;
+    rootsValid = false;
+    previousValid = false;
+    tracked.voicing = 0.0f;
+    outVoicing.store (0.0f);
+}
+
+FormantTracker::Estimate FormantTracker::getEstimate() const noexcept
+{
+    Estimate e;
+    for (int k = 0; k < numFormants; ++k)
+        e.hz[(size_t) k] = outHz[(size_t) k].load (std::memory_order_relaxed);
+    e.voicing = outVoicing.load (std::memory_order_relaxed);
+    return e;
+}
+
+template <typename SampleType>
+void FormantTracker::push (const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    if (ring.empty() || numChannels <= 0)
+        return;
+
+    const double gain = 1.0 / numChannels;
+    const auto& c0 = aaCoeffs[0];
+    const auto& c1 = aaCoeffs[1];
+    auto& s0 = aaState[0];
+    auto& s1 = aaState[1];
+
+    for (int i = startSample; i < startSample + numSamples; ++i)
+    {
+        double x = 0.0;
+        for (int ch = 0; ch < numChannels; ++ch)
+            x += (double) channels[ch][i];
+        x *= gain;
+
+        // 転置直接形 II の 2 段
+        double y = c0.b0 * x + s0[0];
+        s0[0] = c0.b1 * x - c0.a1 * y + s0[1];
+        s0[1] = c0.b2 * x - c0.a2 * y;
+
+        x = y;
+        y = c1.b0 * x + s1[0];
+        s1[0] = c1.b1 * x - c1.a1 * y + s1[1];
+        s1[1] = c1.b2 * x - c1.a2 * y;
+
+        if (++decimationPhase < decimation)
+            continue;
+        decimationPhase = 0;
+
+        if (fifo == nullptr)
+        {
+            consume ((float) y);
+        }
+        else
+        {
+            const auto scope = fifo->write (1);
+            if (scope.blockSize1 > 0)
+                fifoBuffer[(size_t) scope.startIndex1] = (float) y;
+        }
+    }
+}
+
+void FormantTracker::consume (float decimated) noexcept
+{
+    ring[(size_t) ringPos] = decimated;
+    if (++ringPos == frameLength)
+        ringPos = 0;
+
+    if (++hopCounter < hopLength)
+        return;
+
+    hopCounter = 0;
+    analyseFrame();
+}
+
+void FormantTracker::analyseFrame() noexcept
+{
+    // 古い順に並べ、有声判定用の自己相関（生の信号）を取ってからプリエンファシスと窓
+    double r0 = 0.0, r1 = 0.0;
+    float prev = 0.0f;
+    const auto* win = window->data();
+    for (int i = 0, pos = ringPos; i < frameLength; ++i, pos = (pos + 1 == frameLength ? 0 : pos + 1))
+    {
+        const float x = ring[(size_t) pos];
+        r0 += (double) x * x;
+        r1 += (double) x * prev;
+        frame[(size_t) i] = (x - (float) emphasis * prev) * win[i];
+        prev = x;
+    }
+
+    const bool voiced = r0 / frameLength > voicedEnergy && r1 > voicedCorrelation * r0;
+    tracked.voicing += voicingFollow * ((voiced ? 1.0f : 0.0f) - tracked.voicing);
+    outVoicing.store (tracked.voicing, std::memory_order_relaxed);
+
+    if (! voiced)
+    {
+        previousValid = false;
+        return;
+    }
+
+    // 自己相関（ラグ窓と白色雑音補正で Levinson を安定させる）
+    std::array<double, lpcOrder + 1> r {};
+    for (int lag = 0; lag <= lpcOrder; ++lag)
+    {
+        // 加算の依存を切るために 4 本に分けて足す
+        const float* x = frame.data();
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        int i = lag;
+        for (; i + 3 < frameLength; i += 4)
+        {
+            s0 += (double) (x[i]     * x[i - lag]);
+            s1 += (double) (x[i + 1] * x[i + 1 - lag]);
+            s2 += (double) (x[i + 2] * x[i + 2 - lag]);
+            s3 += (double) (x[i + 3] * x[i + 3 - lag]);
+        }
+        for (; i < frameLength; ++i)
+            s0 += (double) (x[i] * x[i - lag]);
+
+        const double sum = (s0 + s1) + (s2 + s3);
+
+        const double w = (double) lag * 60.0 / analysisRate; // 約 60 Hz のガウス窓
+        r[(size_t) lag] = sum * std::exp (-0.5 * juce::MathConstants<double>::twoPi * juce::MathConstants<double>::twoPi * w * w);
+    }
+    r[0] *= 1.0001;
+
+    if (r[0] <= 0.0)
+        return;
+
+    // Levinson-Durbin：A(z) = 1 + a1 z^-1 + … + ap z^-p
+    std::array<double, lpcOrder + 1> a {}, tmp {};
+    a[0] = 1.0;
+    double err = r[0];
+
+    for (int i = 1; i <= lpcOrder; ++i)
+    {
+        double acc = r[(size_t) i];
+        for (int j = 1; j < i; ++j)
+            acc += a[(size_t) j] * r[(size_t) (i - j)];
+
+        const double k = -acc / err;
+        tmp = a;
+        for (int j = 1; j < i; ++j)
+            a[(size_t) j] = tmp[(size_t) j] + k * tmp[(size_t) (i - j)];
+        a[(size_t) i] = k;
+
+        err *= 1.0 - k * k;
+        if (err <= 0.0)
+            return;
+    }
+
+    if (! findRoots (a))
+        return;
+
+    // 上半平面の根のうち帯域幅が狭いものを周波数順に（多くても lpcOrder / 2 個なので挿入ソート）
+    struct Candidate { float hz, bw; };
+    std::array<Candidate, lpcOrder> candidates {};
+    int numCandidates = 0;
+
+    for (auto& z : roots)
+    {
+        if (z.imag() <= 0.0)
+            continue;
+
+        const double hz = std::arg (z) * analysisRate / juce::MathConstants<double>::twoPi;
+        const double bw = -std::log (juce::jmax (1.0e-9, std::abs (z))) * analysisRate / juce::MathConstants<double>::pi;
+        if (bw > maxBandwidthHz[0] || hz < minHz[0])
+            continue;
+
+        int pos = numCandidates++;
+        for (; pos > 0 && candidates[(size_t) pos - 1].hz > (float) hz; --pos)
+            candidates[(size_t) pos] = candidates[(size_t) pos - 1];
+        candidates[(size_t) pos] = { (float) hz, (float) bw };
+    }
+
+    // 低い順に、各フォルマントの範囲に入る最初の候補を割り当てる（3 つ揃わないフレームは捨てる）
+    std::array<float, numFormants> found {};
+    int k = 0;
+    for (int c = 0; c < numCandidates && k < numFormants; ++c)
+    {
+        const auto [hz, bw] = candidates[(size_t) c];
+        if (hz >= minHz[k] && hz <= maxHz[k] && bw <= maxBandwidthHz[k] && (k == 0 || hz > found[(size_t) k - 1] + 150.0f))
+            found[(size_t) k++] = hz;
+    }
+
+    if (k < numFormants)
+    {
+        previousValid = false;
+        return;
+    }
+
+    bool confirmed = previousValid;
+    for (int f = 0; f < numFormants; ++f)
+        confirmed = confirmed && std::abs (found[(size_t) f] - previous[(size_t) f]) <= confirmRatio * previous[(size_t) f];
+
+    previous = found;
+    previousValid = true;
+
+    if (! confirmed)
+        return;
+
+    for (int f = 0; f < numFormants; ++f)
+    {
+        tracked.hz[(size_t) f] += formantFollow * (found[(size_t) f] - tracked.hz[(size_t) f]);
+        outHz[(size_t) f].store (tracked.hz[(size_t) f], std::memory_order_relaxed);
+    }
+}
+
+bool FormantTracker::findRoots (const std::array<double, lpcOrder + 1>& a) noexcept
+{
+    // z^p + a1 z^(p-1) + … + ap の根（Durand–Kerner）。前フレームの根から始めて数回で収束させる
+    using Complex = std::complex<double>;
+
+    if (! rootsValid)
+        for (int i = 0; i < lpcOrder; ++i)
+            roots[(size_t) i] = std::pow (Complex (0.4, 0.9), i);
+
+    // std::complex の乗除算は inf/NaN の扱いで遅いので、実部・虚部で展開する
+    for (int iteration = 0; iteration < maxRootIterations; ++iteration)
+    {
+        double maxStep = 0.0;
+
+        for (int i = 0; i < lpcOrder; ++i)
+        {
+            const double zr = roots[(size_t) i].real(), zi = roots[(size_t) i].imag();
+
+            double nr = 1.0, ni = 0.0;
+            for (int j = 1; j <= lpcOrder; ++j)
+            {
+                const double t = nr * zr - ni * zi + a[(size_t) j];
+                ni = nr * zi + ni * zr;
+                nr = t;
+            }
+
+            double dr = 1.0, di = 0.0;
+            for (int j = 0; j < lpcOrder; ++j)
+            {
+                if (j == i)
+                    continue;
+                const double er = zr - roots[(size_t) j].real(), ei = zi - roots[(size_t) j].imag();
+                const double t = dr * er - di * ei;
+                di = dr * ei + di * er;
+                dr = t;
+            }
+
+            double dn = dr * dr + di * di;
+            if (dn < 1.0e-24)
+            {
+                dr = 1.0e-12; di = 0.0; dn = 1.0e-24;
+            }
+
+            const double sr = (nr * dr + ni * di) / dn;
+            const double si = (ni * dr - nr * di) / dn;
+            roots[(size_t) i] = Complex (zr - sr, zi - si);
+            maxStep = juce::jmax (maxStep, sr * sr + si * si);
+        }
+
+        if (maxStep < 1.0e-18)
+            break;
+    }
+
+    // 発散したら次のフレームは初期値からやり直す
+    rootsValid = true;
+    for (auto& z : roots)
+        if (! std::isfinite (z.real()) || ! std::isfinite (z.imag()) || std::abs (z) > 2.0)
+            rootsValid = false;
+
+    return rootsValid;
+}
+
+template void FormantTracker::push<float>  (const float* const*,  int, int, int) noexcept;
+template void FormantTracker::push<double> (const double* const*, int, int, int) noexcept;
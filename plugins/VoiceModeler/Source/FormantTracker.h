@@ -0,0 +1,90 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "BiquadCoefficients.h"
+#include "SharedResources.h"
+#include <array>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+// 入力の声の F1–F3 を推定する（Adaptive フォルマントモード用）。
+//
+//   1) 全チャンネル平均 → 4 次 Butterworth LPF → 約 10–12 kHz に間引き
+//   2) 25 ms 窓（Hamming）／10 ms ホップでプリエンファシス → 自己相関 → Levinson-Durbin（12 次）
+//   3) 予測多項式の根を Durand–Kerner で求め（前フレームの根から始めるので数回で収束）、
+//      帯域幅の狭い根を低い順に F1–F3 へ割り当てる
+//   4) 有声（エネルギーと 1 次の自己相関）で、直前の有声フレームと割り当てが揃ったときだけ推定値を追従させ、
+//      無声の間は保持
+//
+// 解析は間引いた後のホップごとなので、ホスト側の 1 サンプルあたりのコストは LPF 2 段＋α。
+// バッファは prepare で確保し、push / 解析は確保なし。解析側のバッファと FIFO はワーカーと共有するので、
+// プロセッサの ScratchArena（prepareToPlay で割り付け直す）には置かずに自分で持つ。
+// useBackgroundThread なら間引いた信号をロックなしの FIFO でワーカースレッドへ渡して解析する
+// （オーディオスレッドは LPF と間引きだけ。推定値は atomic で受け取る）。
+class FormantTracker
+{
+public:
+    static constexpr int numFormants = 3;
+    static constexpr int lpcOrder = 12;
+
+    struct Estimate
+    {
+        std::array<float, numFormants> hz { 500.0f, 1500.0f, 2500.0f };
+        float voicing = 0.0f;                       // 0 = 無声・無音 … 1 = 有声
+    };
+
+    FormantTracker();
+    ~FormantTracker();
+
+    void prepare (double sampleRate, bool useBackgroundThread);
+    void release();                                 // ワーカーを止める
+
+    // 信号の状態だけ捨てる（推定値は保持。話者は変わらないので）
+    void reset() noexcept;
+
+    // オーディオスレッド：[startSample, startSample + numSamples) を解析へ送る（float / double）
+    template <typename SampleType>
+    void push (const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+
+    Estimate getEstimate() const noexcept;
+    double getAnalysisRate() const noexcept         { return analysisRate; }
+
+private:
+    class Worker;
+
+    void consume (float decimated) noexcept;        // 解析側（インラインならオーディオスレッド、でなければワーカー）
+    void analyseFrame() noexcept;
+    bool findRoots (const std::array<double, lpcOrder + 1>& a) noexcept;
+    void resetAnalysis() noexcept;
+
+    // 間引き（オーディオスレッド）
+    std::array<BiquadCoeffs, 2> aaCoeffs {};
+    std::array<std::array<double, 2>, 2> aaState {};
+    int decimation = 4, decimationPhase = 0;
+    double analysisRate = 12000.0;
+
+    // 解析フレーム（解析側）
+    std::vector<float> ring, frame;
+    juce::SharedResourcePointer<SharedResources> resources;
+    std::shared_ptr<const std::vector<float>> window;   // Hamming（全インスタンスで共有）
+    int frameLength = 300, hopLength = 120, ringPos = 0, hopCounter = 0;
+    double emphasis = 0.97;
+    std::array<std::complex<double>, lpcOrder> roots {};
+    bool rootsValid = false;
+    std::array<float, numFormants> previous {};      // 直前の有声フレームの割り当て
+    bool previousValid = false;
+    Estimate tracked;
+
+    // 推定値（解析側 → 読み手）
+    std::array<std::atomic<float>, numFormants> outHz;
+    std::atomic<float> outVoicing { 0.0f };
+
+    // バックグラウンド解析
+    std::unique_ptr<juce::AbstractFifo> fifo;
+    std::vector<float> fifoBuffer;
+    std::unique_ptr<Worker> worker;
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE (FormantTracker)
+};
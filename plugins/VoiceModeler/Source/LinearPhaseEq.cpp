@@ -0,0 +1,199 @@
+#include "LinearPhaseEq.h"
+
+namespace
+{
+    // FIR の長さ（2 のべき乗に切り上げ）。短いほど低域のピークがなまる（48 kHz の 2048 で約 ±50 Hz）
+    constexpr double firSeconds = 0.04;
+
+    // 段の振幅 |H(e^jw)|
+    double stageMagnitude (const BiquadCoeffs& c, double w) noexcept
+    {
+        const double c1 = std::cos (w), s1 = std::sin (w);
+        const double c2 = std::cos (2.0 * w), s2 = std::sin (2.0 * w);
+
+        const double nr = c.b0 + c.b1 * c1 + c.b2 * c2, ni = c.b1 * s1 + c.b2 * s2;
+        const double dr = 1.0  + c.a1 * c1 + c.a2 * c2, di = c.a1 * s1 + c.a2 * s2;
+        return std::sqrt ((nr * nr + ni * ni) / juce::jmax (1.0e-30, dr * dr + di * di));
+    }
+}
+
+//==============================================================================
+// 段が変わっていたら FIR を設計して畳み込みへ渡すスレッド
+class LinearPhaseEq::Worker : public juce::Thread
+{
+public:
+    explicit Worker (LinearPhaseEq& e) : juce::Thread ("LinearPhaseEq"), owner (e) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (owner.pending.exchange (false, std::memory_order_acquire))
+                owner.designAndLoad();
+            wait (5);
+        }
+    }
+
+private:
+    LinearPhaseEq& owner;
+};
+
+//==============================================================================
+LinearPhaseEq::LinearPhaseEq() = default;
+
+LinearPhaseEq::~LinearPhaseEq()
+{
+    release();
+}
+
+void LinearPhaseEq::prepare (double sampleRate, int numChannels, int partitionSize, bool zeroLatencyHead)
+{
+    release();
+
+    sr = sampleRate;
+    firLength = juce::nextPowerOfTwo (juce::roundToInt (sampleRate * firSeconds));
+    convolver.prepare (numChannels, partitionSize, firLength, zeroLatencyHead);
+
+    // 設計は 2L 点（振幅を L より細かい格子で取ってから窓で L に切る）
+    int order = 1;
+    while ((1 << order) < 2 * firLength)
+        ++order;
+
+    if (designFft == nullptr || designFft->getSize() != (1 << order))
+        designFft = std::make_unique<juce::dsp::FFT> (order);
+    window = resources->getWindow (SharedResources::Window::hannPeriodic, firLength);
+    spectrum.assign ((size_t) (4 * firLength), 0.0f);
+    impulse.assign ((size_t) firLength, 0.0f);
+
+    numSentStages = -1;
+    numDesignStages = 0;
+    pending.store (false);
+    loadedSequence.store (sequence.load() - 2);     // 今の段はまだ読み込んでいない
+}
+
+void LinearPhaseEq::start()
+{
+    release();
+
+    // 最初の FIR はここで設計して即座に使う（再生開始の直後から正しい特性で鳴らす）
+    if (pending.exchange (false) && pullStages())
+    {
+        designImpulse (designStages.data(), numDesignStages, impulse.data());
+        if (convolver.loadImpulseResponse (impulse.data(), firLength))
+            loadedSequence.store (designSequence, std::memory_order_release);
+    }
+    convolver.reset();
+
+    resume();
+}
+
+void LinearPhaseEq::resume()
+{
+    if (worker != nullptr)
+        return;
+
+    worker = std::make_unique<Worker> (*this);
+    worker->startThread();
+}
+
+void LinearPhaseEq::release()
+{
+    if (worker != nullptr)
+    {
+        worker->stopThread (1000);
+        worker.reset();
+    }
+}
+
+void LinearPhaseEq::reset() noexcept
+{
+    convolver.reset();
+}
+
+void LinearPhaseEq::setStages (const BiquadCoeffs* stages, int numStages) noexcept
+{
+    numStages = juce::jlimit (0, maxStages, numStages);
+    if (numStages == numSentStages && std::equal (stages, stages + numStages, sentStages.begin()))
+        return;
+
+    std::copy (stages, stages + numStages, sentStages.begin());
+    numSentStages = numStages;
+
+    sequence.fetch_add (1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        const auto& c = stages[s];
+        auto* dst = shared.data() + s * 5;
+        dst[0].store (c.b0, std::memory_order_relaxed);
+        dst[1].store (c.b1, std::memory_order_relaxed);
+        dst[2].store (c.b2, std::memory_order_relaxed);
+        dst[3].store (c.a1, std::memory_order_relaxed);
+        dst[4].store (c.a2, std::memory_order_relaxed);
+    }
+    sharedCount.store (numStages, std::memory_order_relaxed);
+
+    sequence.fetch_add (1, std::memory_order_release);
+    pending.store (true, std::memory_order_release);
+}
+
+bool LinearPhaseEq::pullStages() noexcept
+{
+    const auto seq = sequence.load (std::memory_order_acquire);
+    if ((seq & 1u) != 0)
+        return false;
+
+    numDesignStages = juce::jlimit (0, maxStages, sharedCount.load (std::memory_order_relaxed));
+    for (int s = 0; s < numDesignStages; ++s)
+    {
+        const auto* src = shared.data() + s * 5;
+        designStages[(size_t) s] = { src[0].load (std::memory_order_relaxed), src[1].load (std::memory_order_relaxed),
+                                     src[2].load (std::memory_order_relaxed), src[3].load (std::memory_order_relaxed),
+                                     src[4].load (std::memory_order_relaxed) };
+    }
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    designSequence = seq;
+    return sequence.load (std::memory_order_relaxed) == seq;
+}
+
+void LinearPhaseEq::designAndLoad() noexcept
+{
+    // 書き込み中に読んだ／前の差し替えのクロスフェード中なら、次の周回で最新の段からやり直す
+    if (! pullStages())
+    {
+        pending.store (true);
+        return;
+    }
+
+    designImpulse (designStages.data(), numDesignStages, impulse.data());
+
+    if (convolver.loadImpulseResponse (impulse.data(), firLength))
+        loadedSequence.store (designSequence, std::memory_order_release);
+    else
+        pending.store (true);
+}
+
+void LinearPhaseEq::designImpulse (const BiquadCoeffs* stages, int numStages, float* dest) noexcept
+{
+    const int size = 2 * firLength;
+
+    // ゼロ位相（実数）のスペクトル：各段の振幅の積
+    std::fill (spectrum.begin(), spectrum.end(), 0.0f);
+    for (int k = 0; k <= size / 2; ++k)
+    {
+        const double w = juce::MathConstants<double>::twoPi * k / size;
+        double g = 1.0;
+        for (int s = 0; s < numStages; ++s)
+            g *= stageMagnitude (stages[s], w);
+        spectrum[(size_t) (2 * k)] = (float) g;
+    }
+
+    designFft->performRealOnlyInverseTransform (spectrum.data());
+
+    // 0 を中心に循環している応答を L/2 遅らせ、窓で L に切る（n = L/2 を中心に対称 = 線形位相）
+    const auto* win = window->data();
+    for (int n = 0; n < firLength; ++n)
+        dest[n] = spectrum[(size_t) ((n - firLength / 2 + size) % size)] * win[n];
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "BiquadCoefficients.h"
+#include "PartitionedConvolver.h"
+#include "SharedResources.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// 線形位相 EQ：チェインの段（フォルマント〜EQ）の振幅特性の積を 1 本の FIR にして畳み込む。
+//
+//   設計：2L 点の格子で各段の |H| を掛け合わせ → 実数スペクトルとして IFFT → L/2 だけ回して Hann 窓（長さ L）
+//   処理：PartitionedConvolver（一様分割。zeroLatencyHead なら先頭分割だけ直接畳み込み）
+//
+// L は約 40 ms（48 kHz で 2048）。レイテンシは L/2（＋ zeroLatencyHead でなければ分割長）。
+// 段の係数はオーディオスレッドが setStages で渡し（シーケンスロック、確保なし）、ワーカースレッドが設計して
+// 畳み込みの空きスロットへ読み込む（差し替えはクロスフェード）。ワーカーはオーディオスレッドからは起こさず、短い間隔で見に行く。
+// ワーカーは線形位相で処理している間だけ動かす（Minimum の間は start / resume せず、setStages も呼ばない）。
+// 切替直後は isLoaded で IR が畳み込みへ渡ったのを確かめてから段を受け持つ（それまでは呼ぶ側の IIR が鳴らす）。
+class LinearPhaseEq
+{
+public:
+    static constexpr int maxStages = 10;
+
+    LinearPhaseEq();
+    ~LinearPhaseEq();
+
+    void prepare (double sampleRate, int numChannels, int partitionSize, bool zeroLatencyHead);
+    void start();                                   // 渡されている段で最初の FIR を設計してからワーカーを起動（処理を止めて呼ぶ）
+    void resume();                                  // ワーカーだけを起動（処理中でも可。待っている段はワーカーが設計する）
+    void release();                                 // ワーカーを止める
+    bool isRunning() const noexcept                 { return worker != nullptr; }
+    void reset() noexcept;                          // オーディオスレッド：信号の状態を捨てる
+
+    // オーディオスレッド：段の係数（恒等も可）。前回と同じなら何もしない
+    void setStages (const BiquadCoeffs* stages, int numStages) noexcept;
+
+    // オーディオスレッド：直近に渡した段の番号と、その番号以降の段で設計した IR が畳み込みへ渡っているか
+    juce::uint32 getStagesSequence() const noexcept  { return sequence.load (std::memory_order_relaxed); }
+    bool isLoaded (juce::uint32 stagesSequence) const noexcept
+    {
+        return (juce::int32) (loadedSequence.load (std::memory_order_acquire) - stagesSequence) >= 0;
+    }
+
+    // in-place で [startSample, startSample + numSamples) を処理（float / double）
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        convolver.process (channels, numChannels, startSample, numSamples);
+    }
+
+    int getFirLength() const noexcept               { return firLength; }
+    int getLatencySamples() const noexcept          { return firLength / 2 + convolver.getLatencySamples(); }
+    int getPartitionSize() const noexcept           { return convolver.getPartitionSize(); }
+
+    // 段の積から FIR（長さ getFirLength()）を設計する。ワーカーが動いている間は呼ばないこと（作業域を共有）
+    void designImpulse (const BiquadCoeffs* stages, int numStages, float* dest) noexcept;
+
+private:
+    class Worker;
+
+    bool pullStages() noexcept;                     // ワーカー：共有領域から段を読む（書き込み中なら false）
+    void designAndLoad() noexcept;
+
+    double sr = 48000.0;
+    int firLength = 2048;
+    PartitionedConvolver convolver;
+
+    // 設計（ワーカー）
+    juce::SharedResourcePointer<SharedResources> resources;
+    std::unique_ptr<juce::dsp::FFT> designFft;
+    std::shared_ptr<const std::vector<float>> window;  // 周期 Hann（n = L/2 を中心に対称）
+    std::vector<float> spectrum, impulse;
+    std::array<BiquadCoeffs, maxStages> designStages {};
+    int numDesignStages = 0;
+    juce::uint32 designSequence = 0;                // 読んだ段の番号
+
+    // オーディオスレッド → ワーカー（シーケンスが奇数の間は書き込み中）
+    std::array<BiquadCoeffs, maxStages> sentStages {};
+    int numSentStages = -1;
+    std::array<std::atomic<double>, maxStages * 5> shared {};
+    std::atomic<int> sharedCount { 0 };
+    std::atomic<juce::uint32> sequence { 0 };
+    std::atomic<bool> pending { false };
+    std::atomic<juce::uint32> loadedSequence { 0 }; // ワーカー → オーディオスレッド：畳み込みへ渡した IR の段の番号
+
+    std::unique_ptr<Worker> worker;
+
+    JUCE_DECLARE_NON_COPYABLE (LinearPhaseEq)
+};
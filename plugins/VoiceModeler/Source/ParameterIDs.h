@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+
+// パラメータ ID（プロセッサと係数エンジンで共有）
+namespace IDs {
+    // 基本
+    static constexpr auto gainDb        = "gain";          // 出力ゲイン(dB)
+    static constexpr auto bypass        = "bypass";        // バイパス（クロスフェード、getBypassParameter）
+    static constexpr auto formantRatio  = "formantRatio";  // 0.7–1.4
+    static constexpr auto formantMode   = "formantMode";   // 0=Peak（ピークEQ）, 1=Spectral（包絡ワープ）, 2=Adaptive（追跡したピークEQ）
+    static constexpr auto nasalAmt      = "nasalAmt";      // 0–100%
+
+    // ピッチ
+    static constexpr auto pitchSemis    = "pitchSemis";    // -12〜+12 半音
+    static constexpr auto pitchMode     = "pitchMode";     // 0=Off, 1=Delay, 2=PSOLA
+
+    // 反共鳴
+    static constexpr auto nasalNotch    = "nasalNotch";    // 0–100%
+
+    // RBass
+    static constexpr auto rbDriveDb     = "rbDriveDb";
+    static constexpr auto rbFocusHz     = "rbFocusHz";
+    static constexpr auto rbMix         = "rbMix";
+
+    // 非線形部のオーバーサンプリング（Off/2x/4x/8x）
+    static constexpr auto oversampling  = "oversampling";
+    // tanh 近似の精度（Fast/Balanced/Accurate）
+    static constexpr auto satQuality    = "satQuality";
+    // 内部の演算精度（Host/Float/Double）
+    static constexpr auto precision     = "precision";
+    // フォルマント〜EQ の段の位相（0=Minimum：IIR, 1=Linear：FIR、レイテンシあり）
+    static constexpr auto eqPhase       = "eqPhase";
+
+    // 出力リミッター（真のピーク、先読み付き）
+    static constexpr auto limCeilingDb   = "limCeilingDb";   // -12〜0 dBTP
+    static constexpr auto limReleaseMs   = "limReleaseMs";   // 10–500 ms
+    static constexpr auto limLookaheadMs = "limLookaheadMs"; // 0.5–10 ms（レイテンシ）
+
+    // 3-band EQ
+    static constexpr auto eq1Freq = "eq1Freq"; static constexpr auto eq1Gain = "eq1Gain"; static constexpr auto eq1Q = "eq1Q";
+    static constexpr auto eq2Freq = "eq2Freq"; static constexpr auto eq2Gain = "eq2Gain"; static constexpr auto eq2Q = "eq2Q";
+    static constexpr auto eq3Freq = "eq3Freq"; static constexpr auto eq3Gain = "eq3Gain"; static constexpr auto eq3Q = "eq3Q";
+
+    // 動的 EQ／RBass ダッキング（キーの包絡で EQ1–3 のゲインと RBass Mix を動かす）
+    static constexpr auto dynKey        = "dynKey";        // 0=Off（静的）, 1=Input, 2=Sidechain
+    static constexpr auto dynAttackMs   = "dynAttackMs";   // 0.1–50 ms
+    static constexpr auto dynReleaseMs  = "dynReleaseMs";  // 10–1000 ms
+    static constexpr auto eq1DynThreshDb = "eq1DynThreshDb"; static constexpr auto eq1DynRangeDb = "eq1DynRangeDb";
+    static constexpr auto eq2DynThreshDb = "eq2DynThreshDb"; static constexpr auto eq2DynRangeDb = "eq2DynRangeDb";
+    static constexpr auto eq3DynThreshDb = "eq3DynThreshDb"; static constexpr auto eq3DynRangeDb = "eq3DynRangeDb";
+    static constexpr auto rbDuckThreshDb = "rbDuckThreshDb"; static constexpr auto rbDuckRangeDb = "rbDuckRangeDb";
+
+    // 全パラメータの ID（状態の鍵の衝突をコンパイル時に調べる。パラメータを足したらここにも足す）
+    static constexpr const char* all[] = {
+        gainDb, bypass, formantRatio, formantMode, nasalAmt, pitchSemis, pitchMode, nasalNotch,
+        rbDriveDb, rbFocusHz, rbMix, oversampling, satQuality, precision, eqPhase,
+        limCeilingDb, limReleaseMs, limLookaheadMs,
+        eq1Freq, eq1Gain, eq1Q, eq2Freq, eq2Gain, eq2Q, eq3Freq, eq3Gain, eq3Q,
+        dynKey, dynAttackMs, dynReleaseMs,
+        eq1DynThreshDb, eq1DynRangeDb, eq2DynThreshDb, eq2DynRangeDb, eq3DynThreshDb, eq3DynRangeDb,
+        rbDuckThreshDb, rbDuckRangeDb
+    };
+
+    // 保存する状態の鍵：ID の FNV-1a（32 bit）。JUCE の実装に依らないので、版をまたいでも変わらない
+    constexpr std::uint32_t hash (const char* id) noexcept
+    {
+        std::uint32_t h = 2166136261u;
+        for (; *id != 0; ++id)
+            h = (h ^ (std::uint32_t) (unsigned char) *id) * 16777619u;
+        return h;
+    }
+
+    constexpr bool hashesAreUnique() noexcept
+    {
+        for (std::size_t i = 0; i < std::size (all); ++i)
+            for (std::size_t j = i + 1; j < std::size (all); ++j)
+                if (hash (all[i]) == hash (all[j]))
+                    return false;
+        return true;
+    }
+
+    static_assert (hashesAreUnique(), "パラメータ ID のハッシュが衝突している（状態の鍵が重なる）");
+}
@@ -0,0 +1,257 @@
+#include "PartitionedConvolver.h"
+
+void PartitionedConvolver::prepare (int numChannels, int newPartitionSize, int maxImpulseLength, bool zeroLatencyHead)
+{
+    int order = 4;
+    while ((1 << order) < newPartitionSize && order < 14)
+        ++order;
+
+    partitionSize = 1 << order;
+    spectrumSize  = 2 * (partitionSize + 1);        // 0 … B ビン（複素のインターリーブ）
+    maxPartitions = juce::jmax (1, (maxImpulseLength + partitionSize - 1) / partitionSize);
+    zeroLatency   = zeroLatencyHead;
+
+    // FFT は 2B 点。読み込み側は別スレッドなので FFT も作業域も分けておく
+    if (fft == nullptr || fft->getSize() != 2 * partitionSize)
+    {
+        fft = std::make_unique<juce::dsp::FFT> (order + 1);
+        loadFft = std::make_unique<juce::dsp::FFT> (order + 1);
+    }
+    fftBuffer.assign ((size_t) (4 * partitionSize), 0.0f);
+    loadBuffer.assign ((size_t) (4 * partitionSize), 0.0f);
+    accumulator.assign ((size_t) spectrumSize, 0.0f);
+
+    for (auto& slot : slots)
+    {
+        slot.spectra.assign ((size_t) (spectrumSize * maxPartitions), 0.0f);
+        slot.head.assign ((size_t) partitionSize, 0.0f);
+        slot.numPartitions = 1;
+    }
+
+    channels.resize ((size_t) juce::jmax (1, numChannels));
+    for (auto& ch : channels)
+    {
+        ch.frame.assign ((size_t) (2 * partitionSize), 0.0f);
+        ch.delayLine.assign ((size_t) (spectrumSize * maxPartitions), 0.0f);
+        for (auto& t : ch.tail)
+            t.assign ((size_t) partitionSize, 0.0f);
+    }
+    numActiveChannels = (int) channels.size();
+
+    // クロスフェードは 512 サンプル（分割がそれより長ければ 1 分割）
+    fadeLength = juce::jmax (partitionSize, 512);
+
+    // 最初の IR は単位インパルス（素通し）。通常の読み込みと同じ経路でスロット 0 に入れて使う
+    current = 1;
+    previous = -1;
+    fadeRemaining = 0;
+    freeSlot.store (0);
+    readySlot.store (-1);
+
+    const float unit = 1.0f;
+    loadImpulseResponse (&unit, 1);
+    reset();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    for (auto& ch : channels)
+    {
+        std::fill (ch.frame.begin(), ch.frame.end(), 0.0f);
+        std::fill (ch.delayLine.begin(), ch.delayLine.end(), 0.0f);
+        for (auto& t : ch.tail)
+            std::fill (t.begin(), t.end(), 0.0f);
+    }
+
+    blockPos = 0;
+    delayPos = 0;
+
+    // 続きの音はないので、クロスフェードせずに切り替える
+    if (previous >= 0)
+    {
+        freeSlot.store (previous, std::memory_order_release);
+        previous = -1;
+    }
+    fadeRemaining = 0;
+
+    if (const int ready = readySlot.exchange (-1, std::memory_order_acquire); ready >= 0)
+    {
+        freeSlot.store (current, std::memory_order_release);
+        current = ready;
+    }
+}
+
+bool PartitionedConvolver::loadImpulseResponse (const float* impulse, int length) noexcept
+{
+    const int s = freeSlot.exchange (-1, std::memory_order_acquire);
+    if (s < 0 || loadFft == nullptr)
+        return false;
+
+    auto& slot = slots[(size_t) s];
+    const int B = partitionSize;
+    length = juce::jlimit (1, maxPartitions * B, length);
+    slot.numPartitions = (length + B - 1) / B;
+
+    // 先頭の分割：時間領域で掛けるぶん（時間反転して、入力の古い順と内積を取れるようにする）
+    std::fill (slot.head.begin(), slot.head.end(), 0.0f);
+    if (zeroLatency)
+        for (int k = 0; k < juce::jmin (B, length); ++k)
+            slot.head[(size_t) (B - 1 - k)] = impulse[k];
+
+    for (int p = zeroLatency ? 1 : 0; p < slot.numPartitions; ++p)
+    {
+        std::fill (loadBuffer.begin(), loadBuffer.end(), 0.0f);
+        std::copy (impulse + p * B, impulse + juce::jmin (length, (p + 1) * B), loadBuffer.begin());
+        loadFft->performRealOnlyForwardTransform (loadBuffer.data(), true);
+        std::copy (loadBuffer.begin(), loadBuffer.begin() + spectrumSize, slot.spectra.begin() + p * spectrumSize);
+    }
+
+    readySlot.store (s, std::memory_order_release);
+    return true;
+}
+
+float PartitionedConvolver::headSample (const Slot& slot, const Channel& ch, int index) const noexcept
+{
+    // 直近 B サンプル（frame[index + 1 … B + index]）と時間反転した係数の内積
+    const float* x = ch.frame.data() + index + 1;
+    const float* h = slot.head.data();
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+    for (int k = 0; k < partitionSize; k += 4)
+    {
+        s0 += h[k]     * x[k];
+        s1 += h[k + 1] * x[k + 1];
+        s2 += h[k + 2] * x[k + 2];
+        s3 += h[k + 3] * x[k + 3];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+void PartitionedConvolver::computeTail (const Slot& slot, const Channel& ch, std::vector<float>& out) noexcept
+{
+    // 次のブロックの出力 = Σ 遅延線[q] × IR[q + first]（zeroLatencyHead なら first = 1）
+    const int first = zeroLatency ? 1 : 0;
+    std::fill (accumulator.begin(), accumulator.end(), 0.0f);
+    float* acc = accumulator.data();
+
+    for (int q = 0; q < slot.numPartitions - first; ++q)
+    {
+        const float* x = ch.delayLine.data() + ((delayPos - q + maxPartitions) % maxPartitions) * spectrumSize;
+        const float* h = slot.spectra.data() + (q + first) * spectrumSize;
+
+        for (int k = 0; k < spectrumSize; k += 2)
+        {
+            acc[k]     += x[k] * h[k]     - x[k + 1] * h[k + 1];
+            acc[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+        }
+    }
+
+    // overlap-save：IFFT の後半 B サンプルが有効
+    std::copy (accumulator.begin(), accumulator.end(), fftBuffer.begin());
+    fft->performRealOnlyInverseTransform (fftBuffer.data());
+    std::copy (fftBuffer.begin() + partitionSize, fftBuffer.begin() + 2 * partitionSize, out.begin());
+}
+
+void PartitionedConvolver::processPartition() noexcept
+{
+    // クロスフェードが終わったら前のスロットを返す。終わるまでは次の IR を拾わない
+    if (previous >= 0 && fadeRemaining == 0)
+    {
+        freeSlot.store (previous, std::memory_order_release);
+        previous = -1;
+    }
+
+    if (previous < 0)
+    {
+        if (const int ready = readySlot.exchange (-1, std::memory_order_acquire); ready >= 0)
+        {
+            previous = current;
+            current = ready;
+            fadeRemaining = fadeLength;
+        }
+    }
+
+    delayPos = (delayPos + 1) % maxPartitions;
+    const int B = partitionSize;
+
+    for (int c = 0; c < numActiveChannels; ++c)
+    {
+        auto& ch = channels[(size_t) c];
+
+        std::copy (ch.frame.begin(), ch.frame.end(), fftBuffer.begin());
+        std::fill (fftBuffer.begin() + 2 * B, fftBuffer.end(), 0.0f);
+        fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+        std::copy (fftBuffer.begin(), fftBuffer.begin() + spectrumSize, ch.delayLine.begin() + delayPos * spectrumSize);
+
+        // いまのブロックを次の「前のブロック」へ
+        std::copy (ch.frame.begin() + B, ch.frame.end(), ch.frame.begin());
+
+        computeTail (slots[(size_t) current], ch, ch.tail[0]);
+        if (previous >= 0)
+            computeTail (slots[(size_t) previous], ch, ch.tail[1]);
+    }
+}
+
+template <typename SampleType>
+void PartitionedConvolver::process (SampleType* const* data, int numChannelsToProcess, int startSample, int numSamples) noexcept
+{
+    if (fft == nullptr)
+        return;
+
+    const int chs = juce::jmin (numChannelsToProcess, (int) channels.size());
+    numActiveChannels = chs;
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        // 次の分割境界までをまとめて入出力
+        const int len = juce::jmin (numSamples - pos, partitionSize - blockPos);
+        const auto& now = slots[(size_t) current];
+
+        for (int c = 0; c < chs; ++c)
+        {
+            auto& ch = channels[(size_t) c];
+            auto* io = data[c] + startSample + pos;
+
+            float* in = ch.frame.data() + partitionSize + blockPos;
+            for (int i = 0; i < len; ++i)
+                in[i] = (float) io[i];
+
+            for (int i = 0; i < len; ++i)
+            {
+                const int index = blockPos + i;
+                float y = ch.tail[0][(size_t) index];
+                if (zeroLatency)
+                    y += headSample (now, ch, index);
+
+                if (previous >= 0)
+                {
+                    float old = ch.tail[1][(size_t) index];
+                    if (zeroLatency)
+                        old += headSample (slots[(size_t) previous], ch, index);
+
+                    const int remaining = fadeRemaining - i;
+                    const float g = remaining <= 0 ? 1.0f : 1.0f - (float) remaining / (float) fadeLength;
+                    y = old + g * (y - old);
+                }
+
+                io[i] = (SampleType) y;
+            }
+        }
+
+        if (previous >= 0)
+            fadeRemaining = juce::jmax (0, fadeRemaining - len);
+
+        blockPos += len;
+        pos += len;
+
+        if (blockPos == partitionSize)
+        {
+            processPartition();
+            blockPos = 0;
+        }
+    }
+}
+
+template void PartitionedConvolver::process<float>  (float* const*,  int, int, int) noexcept;
+template void PartitionedConvolver::process<double> (double* const*, int, int, int) noexcept;
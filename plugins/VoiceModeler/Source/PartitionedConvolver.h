@@ -0,0 +1,76 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// 一様分割の FFT 畳み込み（overlap-save ＋ 周波数領域の遅延線）。
+//
+// 長さ L の IR をブロック長 B ごとに分割し、B サンプルたまるごとに
+//   1) [前のブロック | いまのブロック]（2B）を FFT して遅延線へ
+//   2) 遅延線の各スペクトルと IR の各分割のスペクトルの積和
+//   3) IFFT の後半 B サンプルが次のブロックの出力
+// を行う。1 サンプルあたりのコストはほぼ (FFT 2 回 + 分割数 × (B+1) 回の複素積和) / B。
+//
+// レイテンシは B。zeroLatencyHead なら先頭の分割だけ時間領域で直接畳み込み（1 サンプルあたり B 回の積和）、
+// 残りの分割は 1 ブロック先の出力を境界で計算しておくので、レイテンシ 0 になる。
+//
+// IR は 2 つのスロットに持つ。別スレッド（1 つ）が loadImpulseResponse で空いている方へ書き、
+// オーディオスレッドが分割境界で拾って新旧の出力をクロスフェードする（ロックなし）。
+// バッファは prepare で確保し、処理中は確保しない（IR のスロットは読み込み側と共有し、単体でも使うので ScratchArena には置かない）。
+// FFT はオーディオスレッド用と読み込み側用を別々に持つ。内部は float。
+class PartitionedConvolver
+{
+public:
+    void prepare (int numChannels, int partitionSize, int maxImpulseLength, bool zeroLatencyHead);
+    void reset() noexcept;                          // オーディオスレッド：信号の状態を捨て、待っている IR があれば即座に使う
+
+    int getPartitionSize() const noexcept           { return partitionSize; }
+    int getLatencySamples() const noexcept          { return zeroLatency ? 0 : partitionSize; }
+    bool hasZeroLatencyHead() const noexcept        { return zeroLatency; }
+
+    // IR を空いているスロットへ読み込み、次の分割境界から使わせる（読み込む側のスレッドは 1 つだけ）。
+    // 前の差し替えのクロスフェード中で空きがなければ false（あとで再試行する）
+    bool loadImpulseResponse (const float* impulse, int length) noexcept;
+
+    // in-place で [startSample, startSample + numSamples) を処理（float / double）
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannelsToProcess, int startSample, int numSamples) noexcept;
+
+private:
+    struct Slot
+    {
+        std::vector<float> spectra;                 // 分割ごとの IR スペクトル（(B+1) 複素 × 分割数）
+        std::vector<float> head;                    // 先頭分割の係数（時間反転。zeroLatencyHead のとき）
+        int numPartitions = 1;
+    };
+
+    struct Channel
+    {
+        std::vector<float> frame;                   // [前のブロック | いまのブロック]（2B）
+        std::vector<float> delayLine;               // 入力スペクトルのリング（(B+1) 複素 × maxPartitions）
+        std::array<std::vector<float>, 2> tail;     // このブロックで出す FFT 側の出力（いまの IR／前の IR）
+    };
+
+    void processPartition() noexcept;               // 分割境界
+    void computeTail (const Slot&, const Channel&, std::vector<float>& out) noexcept;
+    float headSample (const Slot&, const Channel&, int index) const noexcept;
+
+    std::unique_ptr<juce::dsp::FFT> fft, loadFft;  // オーディオスレッド用／読み込み側用（エンジンの作業域を取り合わない）
+    std::vector<float> fftBuffer, accumulator;      // オーディオスレッドの作業域
+    std::vector<float> loadBuffer;                  // 読み込み側の作業域
+    std::array<Slot, 2> slots;
+    std::vector<Channel> channels;
+
+    int partitionSize = 128, spectrumSize = 258, maxPartitions = 1;
+    int blockPos = 0, delayPos = 0;
+    int numActiveChannels = 1;                      // 直近の process のチャンネル数（分割境界で FFT する数）
+    bool zeroLatency = false;
+
+    // スロットの受け渡し：読み込み側が freeSlot を取って書き、readySlot で渡す。
+    // オーディオスレッドはクロスフェードが終わった前のスロットを freeSlot に返す
+    std::atomic<int> freeSlot { 1 }, readySlot { -1 };
+    int current = 0, previous = -1;
+    int fadeLength = 512, fadeRemaining = 0;
+};
@@ -1,21 +1,166 @@
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
 
+namespace
+{
+    // -60〜0 dBFS を 0〜1 に
+    float dbFraction (float gain) noexcept
+    {
+        return juce::jlimit (0.0f, 1.0f, (juce::Decibels::gainToDecibels (gain, -60.0f) + 60.0f) / 60.0f);
+    }
+
+    juce::String dbText (float gain)
+    {
+        return juce::String (juce::Decibels::gainToDecibels (gain, -120.0f), 1) + " dB";
+    }
+}
+
 VoiceModelerAudioProcessorEditor::VoiceModelerAudioProcessorEditor (VoiceModelerAudioProcessor& p)
-: AudioProcessorEditor (&p), processorRef (p)
+: AudioProcessorEditor (&p), processorRef (p), params (p)
+{
+    addAndMakeVisible (params);
+    addAndMakeVisible (resetButton);
+    addAndMakeVisible (csvButton);
+
+    resetButton.onClick = [this] { processorRef.getTelemetry().resetPeaks(); };
+    csvButton.onClick   = [this] { toggleCsv(); };
+
+    // プリセット（ホストのプログラムと同じ）と A/B
+    for (int i = 0; i < PluginState::getNumPresets(); ++i)
+        presetBox.addItem (PluginState::getPresetName (i), i + 1);
+    presetBox.setSelectedId (processorRef.getPluginState().getCurrentPreset() + 1, juce::dontSendNotification);
+    presetBox.onChange = [this] { processorRef.getPluginState().loadPreset (presetBox.getSelectedId() - 1); };
+
+    for (auto* b : { &slotAButton, &slotBButton })
+    {
+        b->setClickingTogglesState (false);
+        b->setColour (juce::TextButton::buttonOnColourId, juce::Colours::darkorange);
+    }
+    slotAButton.onClick    = [this] { processorRef.getPluginState().selectSlot (PluginState::Slot::a); };
+    slotBButton.onClick    = [this] { processorRef.getPluginState().selectSlot (PluginState::Slot::b); };
+    copySlotButton.onClick = [this] { processorRef.getPluginState().copyActiveToOther(); };
+    copySlotButton.setTooltip ("Copy the current settings to the other slot");
+
+    for (auto* c : { (juce::Component*) &presetBox, (juce::Component*) &slotAButton,
+                     (juce::Component*) &slotBButton, (juce::Component*) &copySlotButton })
+        addAndMakeVisible (c);
+
+    processorRef.getTelemetry().startCollecting();
+    startTimerHz (30);
+
+    setResizable (true, false);
+    setSize (520, 640);
+}
+
+void VoiceModelerAudioProcessorEditor::resized()
 {
-    setSize (400, 240);
+    auto r = getLocalBounds();
+    meterArea = r.removeFromBottom (meterHeight).reduced (8);
+    params.setBounds (r);
+
+    auto buttons = meterArea.removeFromBottom (24);
+    csvButton.setBounds (buttons.removeFromRight (140));
+    buttons.removeFromRight (6);
+    resetButton.setBounds (buttons.removeFromRight (100));
+
+    presetBox.setBounds (buttons.removeFromLeft (140));
+    buttons.removeFromLeft (6);
+    slotAButton.setBounds (buttons.removeFromLeft (28));
+    slotBButton.setBounds (buttons.removeFromLeft (28));
+    buttons.removeFromLeft (4);
+    copySlotButton.setBounds (buttons.removeFromLeft (48));
+}
+
+void VoiceModelerAudioProcessorEditor::timerCallback()
+{
+    const bool logging = processorRef.getTelemetry().isLoggingCsv();
+    csvButton.setButtonText (logging ? "Stop CSV log" : "Start CSV log...");
+
+    // ホスト側でプログラムや状態が変わった場合も表示を合わせる
+    auto& state = processorRef.getPluginState();
+    slotAButton.setToggleState (state.getActiveSlot() == PluginState::Slot::a, juce::dontSendNotification);
+    slotBButton.setToggleState (state.getActiveSlot() == PluginState::Slot::b, juce::dontSendNotification);
+    presetBox.setSelectedId (state.getCurrentPreset() + 1, juce::dontSendNotification);
+    repaint (meterArea.expanded (8));
+}
+
+void VoiceModelerAudioProcessorEditor::toggleCsv()
+{
+    auto& telemetry = processorRef.getTelemetry();
+
+    if (telemetry.isLoggingCsv())
+    {
+        telemetry.stopCsv();
+        return;
+    }
+
+    const auto defaultFile = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                                 .getChildFile ("VoiceModeler-telemetry.csv");
+
+    chooser = std::make_unique<juce::FileChooser> ("Write telemetry CSV", defaultFile, "*.csv");
+    chooser->launchAsync (juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                            | juce::FileBrowserComponent::warnAboutOverwriting,
+                          [this] (const juce::FileChooser& fc)
+                          {
+                              const auto file = fc.getResult();
+                              if (file != juce::File() && ! processorRef.getTelemetry().startCsv (file))
+                                  juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon,
+                                                                          "VoiceModeler", "Could not open " + file.getFullPathName());
+                          });
 }
 
 void VoiceModelerAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    g.fillAll (juce::Colours::black);
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+
+    auto& telemetry = processorRef.getTelemetry();
+    const auto& s = telemetry.getLatest();
+
+    auto area = meterArea;
+    g.setColour (juce::Colours::black.withAlpha (0.35f));
+    g.fillRoundedRectangle (meterArea.expanded (4).toFloat(), 4.0f);
+
+    const int row = 20;
+    drawMeter (g, area.removeFromTop (row), "In",    dbFraction (s.rmsIn),  dbFraction (s.peakIn),  dbText (s.peakIn));
+    drawMeter (g, area.removeFromTop (row), "Out",   dbFraction (s.rmsOut), dbFraction (s.peakOut), dbText (s.peakOut));
+    drawMeter (g, area.removeFromTop (row), "GR",    juce::jlimit (0.0f, 1.0f, -s.gainReductionDb / 24.0f), 0.0f,
+               juce::String (s.gainReductionDb, 1) + " dB");
+    drawMeter (g, area.removeFromTop (row), "RBass", dbFraction (s.rbassRms), 0.0f, dbText (s.rbassRms));
+    drawMeter (g, area.removeFromTop (row), "CPU",   juce::jlimit (0.0f, 1.0f, s.load), juce::jlimit (0.0f, 1.0f, telemetry.getPeakLoad()),
+               juce::String (s.load * 100.0f, 1) + " %");
+
+    area.removeFromTop (6);
     g.setColour (juce::Colours::white);
-    g.setFont (18.0f);
-    g.drawFittedText ("VoiceModeler (Generic UI)\nUse host parameter view to adjust gain.",
-                      getLocalBounds(), juce::Justification::centred, 3);
+    g.setFont (13.0f);
+    g.drawFittedText ("block " + juce::String (s.numSamples) + " smp, " + juce::String (s.blockMs, 3) + " ms"
+                        + "  (peak " + juce::String (telemetry.getPeakBlockMs(), 3) + " ms, "
+                        + juce::String (telemetry.getPeakLoad() * 100.0f, 1) + " %)\n"
+                        + "overloads " + juce::String (telemetry.getNumOverloads())
+                        + ", dropped " + juce::String (telemetry.getNumDropped())
+                        + ", latency " + juce::String (processorRef.getLatencySamples()) + " smp"
+                        + (s.bypassed ? ", bypassed" : (s.idle ? ", idle" : ""))
+                        + (telemetry.isLoggingCsv() ? "\nlogging to " + telemetry.getCsvFile().getFileName() : juce::String()),
+                      area.removeFromTop (48), juce::Justification::topLeft, 3);
 }
 
-void VoiceModelerAudioProcessorEditor::resized()
+void VoiceModelerAudioProcessorEditor::drawMeter (juce::Graphics& g, juce::Rectangle<int> area, const juce::String& label,
+                                                  float fraction, float holdFraction, const juce::String& value) const
 {
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    g.drawText (label, area.removeFromLeft (48), juce::Justification::centredLeft);
+    g.drawText (value, area.removeFromRight (80), juce::Justification::centredRight);
+
+    auto bar = area.reduced (4, 4).toFloat();
+    g.setColour (juce::Colours::darkgrey);
+    g.fillRect (bar);
+
+    g.setColour (fraction > 0.95f ? juce::Colours::red : juce::Colours::limegreen);
+    g.fillRect (bar.withWidth (bar.getWidth() * fraction));
+
+    if (holdFraction > 0.0f)
+    {
+        g.setColour (juce::Colours::yellow);
+        g.fillRect (bar.getX() + bar.getWidth() * holdFraction - 1.0f, bar.getY(), 2.0f, bar.getHeight());
+    }
 }
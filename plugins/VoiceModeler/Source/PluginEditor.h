@@ -1,9 +1,13 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <memory>
 
 class VoiceModelerAudioProcessor;
 
-class VoiceModelerAudioProcessorEditor : public juce::AudioProcessorEditor
+// 上：Generic のパラメータ一覧、下：テレメトリのメーター（CPU 負荷・レベル・GR・RBass）と CSV ログ、
+// プリセットと A/B の切替
+class VoiceModelerAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                         private juce::Timer
 {
 public:
     explicit VoiceModelerAudioProcessorEditor (VoiceModelerAudioProcessor&);
@@ -13,6 +17,21 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+    void toggleCsv();
+    void drawMeter (juce::Graphics&, juce::Rectangle<int> area, const juce::String& label,
+                    float fraction, float holdFraction, const juce::String& value) const;
+
     VoiceModelerAudioProcessor& processorRef;
+
+    juce::GenericAudioProcessorEditor params;
+    juce::TextButton resetButton { "Reset peaks" }, csvButton { "Start CSV log..." };
+    juce::ComboBox presetBox;
+    juce::TextButton slotAButton { "A" }, slotBButton { "B" }, copySlotButton { "Copy" };
+    std::unique_ptr<juce::FileChooser> chooser;
+    juce::Rectangle<int> meterArea;
+
+    static constexpr int meterHeight = 190;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceModelerAudioProcessorEditor)
 };
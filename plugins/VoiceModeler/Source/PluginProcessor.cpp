@@ -1,274 +1,1105 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ParameterIDs.h"
+#include "AllocationTrap.h"
 
-namespace IDs {
-    // 基本
-    static constexpr auto gainDb        = "gain";          // 出力ゲイン(dB)
-    static constexpr auto formantRatio  = "formantRatio";  // 0.7–1.4
-    static constexpr auto nasalAmt      = "nasalAmt";      // 0–100%
-
-    // 反共鳴
-    static constexpr auto nasalNotch    = "nasalNotch";    // 0–100%
-
-    // RBass
-    static constexpr auto rbDriveDb     = "rbDriveDb";
-    static constexpr auto rbFocusHz     = "rbFocusHz";
-    static constexpr auto rbMix         = "rbMix";
-
-    // 3-band EQ
-    static constexpr auto eq1Freq = "eq1Freq"; static constexpr auto eq1Gain = "eq1Gain"; static constexpr auto eq1Q = "eq1Q";
-    static constexpr auto eq2Freq = "eq2Freq"; static constexpr auto eq2Gain = "eq2Gain"; static constexpr auto eq2Q = "eq2Q";
-    static constexpr auto eq3Freq = "eq3Freq"; static constexpr auto eq3Gain = "eq3Gain"; static constexpr auto eq3Q = "eq3Q";
+namespace
+{
+    // サンプル精度のオートメーション対象（AutomationQueue のインデックス順。先頭 7 つは BlockParams の項目）
+    const char* const automationIDs[] = {
+        IDs::gainDb, IDs::rbMix, IDs::rbDriveDb, IDs::pitchSemis, IDs::formantRatio,
+        IDs::limCeilingDb, IDs::limReleaseMs,
+        IDs::nasalAmt, IDs::nasalNotch, IDs::rbFocusHz,
+        IDs::eq1Freq, IDs::eq1Gain, IDs::eq1Q,
+        IDs::eq2Freq, IDs::eq2Gain, IDs::eq2Q,
+        IDs::eq3Freq, IDs::eq3Gain, IDs::eq3Q
+    };
 }
 
 VoiceModelerAudioProcessor::VoiceModelerAudioProcessor()
 : AudioProcessor (BusesProperties()
     .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-    .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-  apvts (*this, nullptr, "PARAMS", createParameterLayout())
+    .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+    .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)),
+  apvts (*this, nullptr, "PARAMS", createParameterLayout()),
+  coeffEngine (apvts),
+  pluginState (apvts)
 {
-    // Raw param pointers
+    // Raw param pointers（フィルタ係数系は coeffEngine が保持）
     pGainDb        = apvts.getRawParameterValue (IDs::gainDb);
+
     pFormantRatio  = apvts.getRawParameterValue (IDs::formantRatio);
-    pNasalAmt      = apvts.getRawParameterValue (IDs::nasalAmt);
+    pFormantMode   = apvts.getRawParameterValue (IDs::formantMode);
 
-    pNasalNotch    = apvts.getRawParameterValue (IDs::nasalNotch);
+    pPitchSemis    = apvts.getRawParameterValue (IDs::pitchSemis);
+    pPitchMode     = apvts.getRawParameterValue (IDs::pitchMode);
 
     pRBassDriveDb  = apvts.getRawParameterValue (IDs::rbDriveDb);
-    pRBassFocusHz  = apvts.getRawParameterValue (IDs::rbFocusHz);
     pRBassMix      = apvts.getRawParameterValue (IDs::rbMix);
 
-    pEQ1Freq = apvts.getRawParameterValue (IDs::eq1Freq);
-    pEQ1Gain = apvts.getRawParameterValue (IDs::eq1Gain);
-    pEQ1Q    = apvts.getRawParameterValue (IDs::eq1Q);
-    pEQ2Freq = apvts.getRawParameterValue (IDs::eq2Freq);
-    pEQ2Gain = apvts.getRawParameterValue (IDs::eq2Gain);
-    pEQ2Q    = apvts.getRawParameterValue (IDs::eq2Q);
-    pEQ3Freq = apvts.getRawParameterValue (IDs::eq3Freq);
-    pEQ3Gain = apvts.getRawParameterValue (IDs::eq3Gain);
-    pEQ3Q    = apvts.getRawParameterValue (IDs::eq3Q);
+    pOversampling  = apvts.getRawParameterValue (IDs::oversampling);
+    pSatQuality    = apvts.getRawParameterValue (IDs::satQuality);
+    pPrecision     = apvts.getRawParameterValue (IDs::precision);
+    pEqPhase       = apvts.getRawParameterValue (IDs::eqPhase);
+
+    pLimCeilingDb  = apvts.getRawParameterValue (IDs::limCeilingDb);
+    pLimReleaseMs  = apvts.getRawParameterValue (IDs::limReleaseMs);
+    pLimLookahead  = apvts.getRawParameterValue (IDs::limLookaheadMs);
+
+    pBypass        = apvts.getRawParameterValue (IDs::bypass);
+
+    pDynKey        = apvts.getRawParameterValue (IDs::dynKey);
+    pDynAttackMs   = apvts.getRawParameterValue (IDs::dynAttackMs);
+    pDynReleaseMs  = apvts.getRawParameterValue (IDs::dynReleaseMs);
+    pDynThresholdDb = { apvts.getRawParameterValue (IDs::eq1DynThreshDb), apvts.getRawParameterValue (IDs::eq2DynThreshDb),
+                        apvts.getRawParameterValue (IDs::eq3DynThreshDb), apvts.getRawParameterValue (IDs::rbDuckThreshDb) };
+    pDynRangeDb     = { apvts.getRawParameterValue (IDs::eq1DynRangeDb), apvts.getRawParameterValue (IDs::eq2DynRangeDb),
+                        apvts.getRawParameterValue (IDs::eq3DynRangeDb), apvts.getRawParameterValue (IDs::rbDuckRangeDb) };
+
+    // サンプル精度のオートメーション（キューはサンプルレートに依らないのでここで確保）
+    static_assert (std::size (automationIDs) == numAutomationTargets, "automationIDs と numAutomationTargets がずれている");
+    for (int i = 0; i < numAutomationTargets; ++i)
+    {
+        automationParams[(size_t) i]  = dynamic_cast<juce::RangedAudioParameter*> (apvts.getParameter (automationIDs[i]));
+        automationSources[(size_t) i] = FilterCoefficientEngine::findSource (automationIDs[i]);
+    }
+    automation.prepare (numAutomationTargets, automationQueueCapacity);
+
+    // レイテンシ・内部精度の変更をメッセージスレッドで拾う
+    startTimerHz (20);
 }
 
-void VoiceModelerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+template <typename SampleType>
+void VoiceModelerAudioProcessor::ProcessingCore<SampleType>::prepare (double sampleRate, int blockSize, int numChannels)
 {
-    sr = sampleRate;
-    maxBlock = samplesPerBlock;
-
-    auto specStereo = juce::dsp::ProcessSpec{ sampleRate, (juce::uint32)samplesPerBlock, 2 };
-    auto specMono   = juce::dsp::ProcessSpec{ sampleRate, (juce::uint32)samplesPerBlock, 1 };
-
-    // フィルタ群
-    formantF1.reset(); formantF1.prepare (specStereo);
-    formantF2.reset(); formantF2.prepare (specStereo);
-    formantF3.reset(); formantF3.prepare (specStereo);
-    nasal1k.reset();   nasal1k.prepare (specStereo);
-    nasal3k.reset();   nasal3k.prepare (specStereo);
-    nasalNotch1k.reset(); nasalNotch1k.prepare (specStereo);
-    nasalNotch3k.reset(); nasalNotch3k.prepare (specStereo);
-    eq1.reset(); eq1.prepare (specStereo);
-    eq2.reset(); eq2.prepare (specStereo);
-    eq3.reset(); eq3.prepare (specStereo);
-    hpf20.reset(); hpf20.prepare (specStereo);
+    auto specMono = juce::dsp::ProcessSpec{ sampleRate, (juce::uint32)blockSize, 1 };
 
-    // 出力ゲイン
-    outGain.reset(); outGain.prepare (specStereo);
-    outGain.setGainLinear (1.0f);
+    // フィルタ群（融合カスケード）
+    chain.prepare (numChannels, blockSize);
+    chain.setNumStages (numChainStages);
+    chain.reset();
 
-    // リミッター
-    limiter.reset(); limiter.prepare (specStereo);
-    limiter.setThreshold (-1.0f); // dBFS
-    limiter.setRatio (20.0f);     // ほぼリミッター
-    limiter.setAttack (2.0f);
-    limiter.setRelease (50.0f);
+    // RBass BPF（係数オブジェクトは 2 次で確保しておき、以後は値だけ書き換える）
+    *rbassBand.state = juce::dsp::IIR::Coefficients<SampleType> (1, 0, 0, 1, 0, 0);
 
     // RBass
     rbassBand.reset(); rbassBand.prepare (specMono);
-    rbassMono.setSize (1, samplesPerBlock);
 
     // スムージング
     smoothOutGain.reset (sampleRate, 0.02);
     smoothRBassMix.reset (sampleRate, 0.05);
+    smoothRBassDrive.reset (sampleRate, 0.05);
+    smoothWet.reset (sampleRate, bypassFadeSeconds);
+
+    // 非線形部のオーバーサンプリング（整数レイテンシの polyphase IIR ハーフバンド。内部のバッファは JUCE が持つ）
+    for (int k = 0; k < numOversamplingFactors; ++k)
+    {
+        rbassOS[(size_t) k] = std::make_unique<Oversampler> (1, (size_t) (k + 1),
+                                  Oversampler::filterHalfBandPolyphaseIIR, true, true);
+        rbassOS[(size_t) k]->initProcessing ((size_t) blockSize);
+    }
+
+    rbassIdle = false;
+
+    // 動的 EQ の帯域分割（係数は updateFilters で入る）
+    for (auto& band : dynamicBands)
+    {
+        band.prepare (numChannels, blockSize);
+        band.setNumStages (1);
+        band.reset();
+    }
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::ProcessingCore<SampleType>::prepareScratch (ScratchArena& arena, double sampleRate, int blockSize,
+                                                                            int numChannels, int numKeyChannels)
+{
+    // リミッター（先読みは上限ぶん確保。値は prepareCore で入れる）
+    limiter.prepare (sampleRate, numChannels, blockSize,
+                     (int) std::ceil (maxLimiterLookaheadMs * 0.001 * sampleRate), arena);
+
+    // RBass のモノ和と動的 EQ の帯域の作業域、バイパス用のドライ
+    arena.take (rbassMono, 1, blockSize);
+    arena.take (dynamicBand, numChannels, blockSize);
+    arena.take (dry, numChannels, blockSize);
+
+    // 変換バッファはサイドチェインのチャンネルも運ぶ（メインの後ろ）
+    arena.take (conversion, numChannels + numKeyChannels, blockSize);
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::ProcessingCore<SampleType>::release()
+{
+    // limiter・遅延線の領域はプロセッサの ScratchArena のもの（使う方のコアが割り付け直すので、prepare し直すまで触らない）
+    for (auto& os : rbassOS) os.reset();
+
+    rbassMono.setSize (0, 0);
+    dynamicBand.setSize (0, 0);
+    dry.setSize (0, 0);
+    conversion.setSize (0, 0);
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::ProcessingCore<SampleType>::selectOversampling (int index, int alignDelay)
+{
+    if (index > 0)
+        rbassOS[(size_t) (index - 1)]->reset();
+
+    rbassAlign.reset();
+    rbassAlign.setDelay (alignDelay);
+}
+
+void VoiceModelerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    sr = sampleRate;
+    maxBlock = samplesPerBlock;
+
+    // モノ〜maxChannels の任意チャンネル数（入出力同数）
+    numChannels = juce::jlimit (1, maxChannels, getTotalNumOutputChannels());
+
+    // サイドチェイン（任意。処理用バッファではメインの入力の後ろに並ぶ）
+    const auto* sidechain = getBus (true, 1);
+    numKeyChannels = sidechain != nullptr && sidechain->isEnabled()
+                   ? juce::jmin (maxKeyChannels, sidechain->getNumberOfChannels()) : 0;
+
+    // 処理は止まっているので、シーケンスを見ずにそのまま取り込む
+    params = readParameters();
+
+    // ピッチシフタ・フォルマントシフタ（Spectral モード）のリングは prepareCore で作業域と一緒に切り出す
+    formantShifter.setRatio (params.formantRatio);
+    formantTracker.prepare (sampleRate, backgroundFormantAnalysis);
+    formantMode = (FormantMode) params.formantMode;
+    coeffEngine.setTrackedFormants (nullptr, 0.0f);
+
+    // 線形位相 EQ（FIR は係数を渡した後の start で設計する）
+    linearEq.prepare (sampleRate, numChannels, linearPhasePartition, linearPhaseZeroLatency);
+    linearPhase = params.eqPhase == 1;
+    firActive = linearPhase;                      // 最初の FIR は start で設計してから処理を始める
+    linearWorkerWanted.store (linearPhase);
+
+    // 動的 EQ／RBass ダッキングの検出器は作業域と一緒に prepareCore で準備（帯域の係数は updateFilters で入る）
+    dynamicLanes = 0;
+
+    // 内部精度（Host ならホストの処理精度に合わせる）。使わない方のコアは解放
+    useDouble = wantsDoubleCore();
+    if (useDouble)
+    {
+        coreF.release();
+        prepareCore (coreD);
+    }
+    else
+    {
+        coreD.release();
+        prepareCore (coreF);
+    }
+
+    // モードの切り替えはシフタのリセットを伴うので、領域を割り付けた後で
+    pitchMode = -1;
+    selectPitchMode (params.pitchMode);
+
+    activeOS = -1;
+    selectOversampling (params.oversampling);
+    setLatencySamples (computeLatency());
+
+    coeffEngine.setCoefficientCache (sharedCoefficientCache ? &sharedResources->getCoefficientCache() : nullptr);
+    coeffEngine.prepare (sampleRate);
+    if (useDouble) updateFilters (coreD, 0);
+    else           updateFilters (coreF, 0);
+
+    // FIR の設計スレッドは Linear の間だけ（切り替えは timerCallback で起動・停止）
+    if (linearPhase)
+        linearEq.start();
+
+    automation.clear();
+    samplesProcessed = 0;
+    silentSamples = 0;
+    lastOutPeak = 0.0f;
+    idle = false;
+    wetSuspended = false;
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::prepareCore (ProcessingCore<SampleType>& core)
+{
+    core.prepare (sr, maxBlock, numChannels);
+
+    core.smoothOutGain.setCurrentAndTargetValue (juce::Decibels::decibelsToGain ((SampleType) params.gainDb));
+    core.smoothRBassMix.setCurrentAndTargetValue ((SampleType) params.rbMix / 100);
+    core.smoothRBassDrive.setCurrentAndTargetValue (juce::Decibels::decibelsToGain ((SampleType) params.rbDriveDb));
+
+    for (int k = 0; k < numOversamplingFactors; ++k)
+        rbassOSLatency[(size_t) k] = juce::roundToInt (core.rbassOS[(size_t) k]->getLatencyInSamples());
+
+    // 作業域・遅延線・先読みのバッファをまとめて 1 回で確保（大きさを数えてから割り付ける）
+    const int maxRBassLatency = *std::max_element (rbassOSLatency.begin(), rbassOSLatency.end());
+    scratch.layout ([&]
+    {
+        core.prepareScratch (scratch, sr, maxBlock, numChannels, numKeyChannels);
+        core.rbassAlign.prepare (numChannels, maxRBassLatency, scratch);
+
+        pitchShifter.prepare (sr, maxBlock, numChannels, scratch);
+        formantShifter.prepare (sr, numChannels, scratch);
+
+        // バイパス：ドライはどのモードの組み合わせのレイテンシにも合わせられる長さで確保
+        // （シフタのレイテンシを使うので、シフタの後で準備する）
+        const int maxLatency = formantShifter.getLatencySamples() + pitchShifter.getMaxLatencySamples()
+                             + maxRBassLatency + core.limiter.getMaxLatencySamples() + linearEq.getLatencySamples();
+        core.dryAlign.prepare (numChannels, maxLatency, scratch);
+
+        dynamics.prepare (sr, maxBlock, scratch);
+    });
+
+    updateLimiter (core);
+    core.smoothWet.setCurrentAndTargetValue (params.bypass ? SampleType (0) : SampleType (1));
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::resetWet (ProcessingCore<SampleType>& core)
+{
+    // 無音／バイパスで止めていたウェット側の状態を捨てる（再開時に古いテールを出さない）
+    core.chain.reset();
+    core.limiter.reset();
+    core.rbassBand.reset();
+    core.rbassAlign.reset();
+    for (auto& os : core.rbassOS)
+        if (os != nullptr)
+            os->reset();
+
+    core.smoothOutGain.setCurrentAndTargetValue (core.smoothOutGain.getTargetValue());
+    core.smoothRBassMix.setCurrentAndTargetValue (core.smoothRBassMix.getTargetValue());
+    core.smoothRBassDrive.setCurrentAndTargetValue (core.smoothRBassDrive.getTargetValue());
+
+    for (auto& band : core.dynamicBands)
+        band.reset();
+
+    pitchShifter.reset();
+    formantShifter.reset();
+    formantTracker.reset();
+    linearEq.reset();
+    dynamics.reset();
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::updateLimiter (ProcessingCore<SampleType>& core)
+{
+    // 先読みが変わったときだけ状態をリセット（レイテンシも変わる）。ceiling / release は毎ブロック
+    if (const int lookahead = limiterLookaheadSamples(); lookahead != core.limiter.getLookahead())
+        core.limiter.setLookahead (lookahead);
+
+    core.limiter.setCeilingDb (params.limCeilingDb);
+    core.limiter.setReleaseMs (params.limReleaseMs);
+}
+
+int VoiceModelerAudioProcessor::limiterLookaheadSamples() const noexcept
+{
+    const double ms = juce::jlimit (0.5, maxLimiterLookaheadMs, (double) params.limLookaheadMs);
+    return juce::jmax (1, juce::roundToInt (ms * 0.001 * sr));
+}
+
+VoiceModelerAudioProcessor::BlockParams VoiceModelerAudioProcessor::readParameters() const noexcept
+{
+    BlockParams p;
+    p.gainDb          = pGainDb->load();
+    p.rbMix           = juce::jlimit (0.0f, 100.0f, pRBassMix->load());
+    p.rbDriveDb       = pRBassDriveDb->load();
+    p.pitchSemis      = pPitchSemis->load();
+    p.formantRatio    = pFormantRatio->load();
+    p.limCeilingDb    = pLimCeilingDb->load();
+    p.limReleaseMs    = pLimReleaseMs->load();
+    p.limLookaheadMs  = pLimLookahead->load();
+    p.oversampling    = juce::roundToInt (pOversampling->load());
+    p.satQuality      = juce::jlimit (0, 2, juce::roundToInt (pSatQuality->load()));
+    p.pitchMode       = juce::roundToInt (pPitchMode->load());
+    p.formantMode     = juce::jlimit (0, 2, juce::roundToInt (pFormantMode->load()));
+    p.eqPhase         = juce::jlimit (0, 1, juce::roundToInt (pEqPhase->load()));
+    p.bypass          = pBypass->load() >= 0.5f;
+    p.dynKey          = juce::jlimit (0, 2, juce::roundToInt (pDynKey->load()));
+    p.dynAttackMs     = pDynAttackMs->load();
+    p.dynReleaseMs    = pDynReleaseMs->load();
+    for (size_t l = 0; l < (size_t) DynamicsDetector::numLanes; ++l)
+    {
+        p.dynThresholdDb[l] = pDynThresholdDb[l]->load();
+        p.dynRangeDb[l]     = pDynRangeDb[l]->load();
+    }
+    return p;
+}
+
+void VoiceModelerAudioProcessor::latchParameters() noexcept
+{
+    // A/B・プリセット・状態の復元中（シーケンスが奇数）は前のブロックの値で処理し、
+    // 読んでいる間に復元が始まった値も捨てる（切替は必ずブロック境界で、全パラメータまとめて効く）
+    const auto seq = pluginState.beginRead();
+    if (! PluginState::isStable (seq))
+        return;
+
+    auto p = readParameters();
+    if (! pluginState.endRead (seq))
+        return;
+
+    // ブロック内にオートメーション点があるパラメータは、パラメータ自体がもうブロック末尾の値なので
+    // 前の値から始め、点の位置で切り替える（係数系は点の位置で setTarget）
+    juce::uint32 automatedSources = 0;
+    if (! automation.isEmpty())
+    {
+        for (int i = 0; i < numAutomationTargets; ++i)
+        {
+            if (! automation.hasEvents (i))
+                continue;
+
+            if (auto* field = blockParamField (p, i))
+                *field = *blockParamField (params, i);
+            if (automationSources[(size_t) i] >= 0)
+                automatedSources |= FilterCoefficientEngine::sourceBit (automationSources[(size_t) i]);
+        }
+    }
+
+    params = p;
+
+    // 係数パラメータの目標値（こちらはスムーザーでランプするので、読んだ直後に復元が始まっても次のブロックで揃う）
+    coeffEngine.pullTargets (automatedSources);
+}
+
+float* VoiceModelerAudioProcessor::blockParamField (BlockParams& p, int automationIndex) noexcept
+{
+    switch (automationIndex)
+    {
+        case 0:  return &p.gainDb;
+        case 1:  return &p.rbMix;
+        case 2:  return &p.rbDriveDb;
+        case 3:  return &p.pitchSemis;
+        case 4:  return &p.formantRatio;
+        case 5:  return &p.limCeilingDb;
+        case 6:  return &p.limReleaseMs;
+        default: return nullptr;
+    }
+}
+
+int VoiceModelerAudioProcessor::getAutomationIndex (const juce::String& paramID) noexcept
+{
+    for (int i = 0; i < numAutomationTargets; ++i)
+        if (paramID == automationIDs[i])
+            return i;
+    return -1;
+}
+
+bool VoiceModelerAudioProcessor::pushAutomation (int index, int sampleOffset, float plainValue) noexcept
+{
+    if (! juce::isPositiveAndBelow (index, numAutomationTargets))
+        return false;
+
+    const auto& range = automationParams[(size_t) index]->getNormalisableRange();
+    return automation.push (index, sampleOffset, juce::jlimit (range.start, range.end, plainValue));
+}
+
+void VoiceModelerAudioProcessor::pushAutomationCurve (int index, const float* plainValues, int numSamples) noexcept
+{
+    // サンプルごとの曲線はコントロールレートに間引いて積む（区間数の上限でさらにまとめられる）
+    for (int i = 0; i < numSamples; i += controlInterval)
+        if (i == 0 || plainValues[i] != plainValues[i - controlInterval])
+            pushAutomation (index, i, plainValues[i]);
+}
+
+void VoiceModelerAudioProcessor::applyAutomation (int index, float plainValue) noexcept
+{
+    if (auto* field = blockParamField (params, index))
+        *field = index == 1 ? juce::jlimit (0.0f, 100.0f, plainValue) : plainValue;
+
+    if (const int source = automationSources[(size_t) index]; source >= 0)
+        coeffEngine.setTarget (source, plainValue);
+}
+
+bool VoiceModelerAudioProcessor::wantsDoubleCore() const noexcept
+{
+    const int precision = juce::roundToInt (pPrecision->load());
+    return precision == 2 || (precision == 0 && isUsingDoublePrecision());
+}
+
+void VoiceModelerAudioProcessor::selectFormantMode (FormantMode mode)
+{
+    if (mode == formantMode)
+        return;
+
+    formantMode = mode;
+    formantShifter.reset();
+
+    // Adaptive 以外では固定の中心に戻す（推定値は次に Adaptive にしたときの初期値として残る）
+    if (formantMode != FormantMode::adaptive)
+        coeffEngine.setTrackedFormants (nullptr, 0.0f);
+
+    // F1–F3 の段を Peak 係数／素通しに差し替える
+    coeffEngine.markDirty (FilterCoefficientEngine::bit (FilterCoefficientEngine::formant1)
+                         | FilterCoefficientEngine::bit (FilterCoefficientEngine::formant2)
+                         | FilterCoefficientEngine::bit (FilterCoefficientEngine::formant3));
+}
+
+void VoiceModelerAudioProcessor::selectEqPhase (bool linear)
+{
+    if (linear != linearPhase)
+    {
+        linearPhase = linear;
+
+        // Minimum：FIR が受け持っていた段を IIR 側へ戻す
+        if (firActive)
+            coeffEngine.markDirty (firStageMask);
+        firActive = false;
+
+        // Linear：段を FIR 側へ渡すだけで、IR が入るまでは IIR のまま鳴らす
+        // （ワーカーの起動はメッセージスレッドで。起動・設計の間に前回の FIR や単位インパルスを鳴らさない）
+        if (linear)
+        {
+            sendFirStages();
+            firSequence = linearEq.getStagesSequence();
+        }
+
+        linearWorkerWanted.store (linear);
+        updatePending.store (true);
+    }
+
+    // 渡した段の IR が畳み込みに入ったら、IIR 側の段を素通しにして FIR へ受け渡す。
+    // 畳み込みは Minimum の間の入力を持たないので、クロスフェードせずに新しい IR で始める（レイテンシはここで変わる）
+    if (linearPhase && ! firActive && linearEq.isLoaded (firSequence))
+    {
+        firActive = true;
+        linearEq.reset();
+        coeffEngine.markDirty (firStageMask);
+    }
+}
+
+void VoiceModelerAudioProcessor::sendFirStages() noexcept
+{
+    // FIR の段（受け持たない段は恒等）。同じ係数なら setStages は何もしない
+    std::array<BiquadCoeffs, LinearPhaseEq::maxStages> firStages {};
+    for (int b = FilterCoefficientEngine::formant1; b < numChainStages; ++b)
+        if (isFirStage (b))
+            firStages[(size_t) (b - FilterCoefficientEngine::formant1)] = stageCoefficients (b);
+
+    linearEq.setStages (firStages.data(), (int) firStages.size());
+}
+
+bool VoiceModelerAudioProcessor::isFirStage (int band) const noexcept
+{
+    // Linear で FIR が受け持つ段。HPF と、10 ms ごとに動く Adaptive のフォルマント段は IIR のまま
+    const bool formantStage = band >= FilterCoefficientEngine::formant1 && band <= FilterCoefficientEngine::formant3;
+    return band > FilterCoefficientEngine::hpf && band < numChainStages
+        && ! (formantStage && formantMode == FormantMode::adaptive);
+}
+
+BiquadCoeffs VoiceModelerAudioProcessor::stageCoefficients (int band) const noexcept
+{
+    // Spectral モードではフォルマント段は素通し（係数 = 恒等）
+    const bool formantStage = band >= FilterCoefficientEngine::formant1 && band <= FilterCoefficientEngine::formant3;
+    return formantStage && formantMode == FormantMode::spectral ? BiquadCoeffs {}
+                                                                : coeffEngine.get ((FilterCoefficientEngine::Band) band);
+}
+
+void VoiceModelerAudioProcessor::selectOversampling (int index)
+{
+    index = juce::jlimit (0, numOversamplingFactors, index);
+    if (index == activeOS)
+        return;
+
+    activeOS = index;
+    const int alignDelay = activeOS > 0 ? rbassOSLatency[(size_t) (activeOS - 1)] : 0;
+
+    if (useDouble) coreD.selectOversampling (activeOS, alignDelay);
+    else           coreF.selectOversampling (activeOS, alignDelay);
+}
+
+void VoiceModelerAudioProcessor::selectPitchMode (int index)
+{
+    index = juce::jlimit (0, 2, index);
+    if (index == pitchMode)
+        return;
+
+    pitchMode = index;
+    pitchShifter.setMode (pitchMode == 2 ? SimplePitchShifter::Mode::psola : SimplePitchShifter::Mode::delay);
+    pitchShifter.reset();
+}
+
+int VoiceModelerAudioProcessor::computeLatency() const noexcept
+{
+    int latency = formantMode == FormantMode::spectral ? formantShifter.getLatencySamples() : 0;
+
+    if (pitchMode > 0)
+        latency += pitchShifter.getLatencySamples();
+
+    // RBass 側の遅延はドライも揃えて遅らせるので、直列に足し合わせる
+    if (activeOS > 0)
+        latency += rbassOSLatency[(size_t) (activeOS - 1)];
+
+    // 線形位相 EQ（FIR の半分＋畳み込みの分割）。FIR へ受け渡すまでは足さない
+    if (firActive)
+        latency += linearEq.getLatencySamples();
+
+    // リミッターの先読み＋真のピーク検出の遅れ
+    latency += useDouble ? coreD.limiter.getLatencySamples() : coreF.limiter.getLatencySamples();
+
+    return latency;
+}
+
+void VoiceModelerAudioProcessor::timerCallback()
+{
+    // オーディオスレッドはフラグを立てるだけ（AsyncUpdater の投函はメッセージキューのロックを取るので使わない）
+    if (! updatePending.exchange (false))
+        return;
+
+    // 内部精度の切替はコアの確保を伴うので、処理を止めてメッセージスレッドで準備し直す
+    // （それまでオーディオスレッドは確保済みのコアで処理を続ける）
+    if (maxBlock > 0 && wantsDoubleCore() != useDouble)
+    {
+        suspendProcessing (true);
+        prepareToPlay (sr, maxBlock);
+        suspendProcessing (false);
+        return;
+    }
 
-    updateFilters();
+    // 線形位相 EQ の設計スレッドは Linear の間だけ動かす（待っている段は起動したワーカーが設計する）
+    if (const bool wanted = linearWorkerWanted.load(); wanted != linearEq.isRunning())
+    {
+        if (wanted) linearEq.resume();
+        else        linearEq.release();
+    }
+
+    // オーディオスレッドで切り替えたレイテンシをメッセージスレッドからホストへ通知
+    setLatencySamples (pendingLatency.load());
 }
 
 bool VoiceModelerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    return layouts.getMainInputChannelSet()  == juce::AudioChannelSet::stereo()
-        && layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    // モノ／ステレオ／サラウンド・アンビソニックス等、入出力が同じ 1〜maxChannels ch なら受け付ける。
+    // サイドチェインは無効か 1〜maxKeyChannels ch（動的 EQ のキーにはモノ和を使う）
+    const auto& in  = layouts.getMainInputChannelSet();
+    const auto& out = layouts.getMainOutputChannelSet();
+    const auto sidechain = layouts.inputBuses.size() > 1 ? layouts.getChannelSet (true, 1) : juce::AudioChannelSet::disabled();
+
+    return ! out.isDisabled()
+        && in == out
+        && out.size() >= 1 && out.size() <= maxChannels
+        && (sidechain.isDisabled() || sidechain.size() <= maxKeyChannels);
 }
 
-void VoiceModelerAudioProcessor::processRBass (juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void VoiceModelerAudioProcessor::processRBass (juce::AudioBuffer<SampleType>& buffer, ProcessingCore<SampleType>& core,
+                                               int startSample, int numSamples)
 {
-    // Monoにサム
-    rbassMono.setSize (1, buffer.getNumSamples(), true, false, true);
+    using FVO = juce::FloatVectorOperations;
+    const int chs = juce::jmin (numChannels, buffer.getNumChannels());
+
+    // Mix 0 % なら倍音生成ごと省く（ドライの位相合わせだけは続ける）
+    auto& mix = core.smoothRBassMix;
+    if (! mix.isSmoothing() && mix.getTargetValue() <= (SampleType) 0.0001)
+    {
+        core.smoothRBassDrive.skip (numSamples);
+        core.rbassAlign.process (buffer.getArrayOfWritePointers(), chs, startSample, numSamples);
+        core.rbassIdle = true;
+        return;
+    }
+
+    if (core.rbassIdle)
+    {
+        // 止めていた間の BPF／OS の状態は古いので捨てる（Mix は 0 からランプするので継ぎ目は出ない）
+        core.rbassBand.reset();
+        if (activeOS > 0)
+            core.rbassOS[(size_t) (activeOS - 1)]->reset();
+        core.rbassIdle = false;
+    }
+
+    // Monoにサム（全チャンネルの平均。モノラル入力はコピーのみ）
+    // 作業域は maxBlock ぶん（processBlockImpl が分割しているので足りる。ここでは確保し直さない）
+    auto& rbassMono = core.rbassMono;
+    jassert (numSamples <= rbassMono.getNumSamples());
     auto* mono = rbassMono.getWritePointer (0);
-    auto* L = buffer.getReadPointer (0);
-    auto* R = buffer.getNumChannels() > 1 ? buffer.getReadPointer (1) : L;
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
-        mono[i] = 0.5f * (L[i] + R[i]);
+
+    FVO::copy (mono, buffer.getReadPointer (0, startSample), numSamples);
+    if (chs > 1)
+    {
+        for (int ch = 1; ch < chs; ++ch)
+            FVO::add (mono, buffer.getReadPointer (ch, startSample), numSamples);
+        FVO::multiply (mono, SampleType (1) / (SampleType) chs, numSamples);
+    }
 
     // Focus帯域のBPF
-    juce::dsp::AudioBlock<float> monoBlock (rbassMono);
-    juce::dsp::ProcessContextReplacing<float> monoCtx (monoBlock);
-    rbassBand.process (monoCtx);
+    auto monoBlock = juce::dsp::AudioBlock<SampleType> (rbassMono).getSubBlock (0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<SampleType> monoCtx (monoBlock);
+    core.rbassBand.process (monoCtx);
+
+    // Drive -> tanh で倍音生成（drive はサンプル単位でランプ）
+    core.smoothRBassDrive.applyGain (mono, numSamples);
 
-    // Drive -> tanh で倍音生成
-    const float drive = juce::Decibels::decibelsToGain (pRBassDriveDb ? pRBassDriveDb->load() : 0.0f);
-    for (int i = 0; i < rbassMono.getNumSamples(); ++i)
+    if (activeOS == 0)
     {
-        float x = mono[i] * drive;
-        x = 0.6f * softClip (x) + 0.4f * softClip (x * 0.5f); // 2/3次混合
-        mono[i] = x;
+        Saturation::rbassShape (mono, numSamples, satQuality); // 2/3次混合
     }
-
-    // ミックス
-    const float mix = smoothRBassMix.getNextValue(); // 0..1
-    if (mix > 0.0001f)
+    else
     {
-        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        // 帯域制限済みのモノ信号だけをアップサンプルして非線形処理
+        auto& os = *core.rbassOS[(size_t) (activeOS - 1)];
+        for (int pos = 0; pos < numSamples; pos += maxBlock)
         {
-            auto* dst = buffer.getWritePointer (ch);
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
-                dst[i] += mono[i] * mix;
+            auto sub = monoBlock.getSubBlock ((size_t) pos, (size_t) juce::jmin (maxBlock, numSamples - pos));
+            auto up  = os.processSamplesUp (sub);
+            Saturation::rbassShape (up.getChannelPointer (0), (int) up.getNumSamples(), satQuality);
+            os.processSamplesDown (sub);
         }
     }
+
+    // ミックス（0..1、サンプル単位でランプ）。OS の遅延分だけドライを遅らせて位相を揃える
+    core.rbassAlign.process (buffer.getArrayOfWritePointers(), chs, startSample, numSamples);
+
+    mix.applyGain (mono, numSamples);
+
+    // ダッキング（キーの包絡から、このブロックの検出で求めたゲイン）
+    if ((dynamicLanes & (1u << DynamicsDetector::rbass)) != 0)
+    {
+        const float* duck = dynamics.getGains (DynamicsDetector::rbass) + startSample;
+        for (int i = 0; i < numSamples; ++i)
+            mono[i] *= (SampleType) duck[i];
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        rbassSumSq += (double) mono[i] * mono[i];
+
+    for (int ch = 0; ch < chs; ++ch)
+        FVO::add (buffer.getWritePointer (ch, startSample), mono, numSamples);
 }
 
 void VoiceModelerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
 {
     juce::ignoreUnused (midi);
-    juce::ScopedNoDenormals noDenormals;
+    const AllocationTrap::ScopedAudioThread audioThread;   // VOICEMODELER_TRAP_ALLOCATIONS のときだけ有効
+
+    if (useDouble) processConverted (buffer, coreD);
+    else           processBlockImpl (buffer, coreF);
+}
+
+void VoiceModelerAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midi)
+{
+    juce::ignoreUnused (midi);
+    const AllocationTrap::ScopedAudioThread audioThread;
+
+    if (useDouble) processBlockImpl (buffer, coreD);
+    else           processConverted (buffer, coreF);
+}
+
+void VoiceModelerAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    const juce::ScopedValueSetter<bool> bypassed (hostBypassed, true);
+    processBlock (buffer, midi);
+}
+
+void VoiceModelerAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midi)
+{
+    const juce::ScopedValueSetter<bool> bypassed (hostBypassed, true);
+    processBlock (buffer, midi);
+}
+
+juce::AudioProcessorParameter* VoiceModelerAudioProcessor::getBypassParameter() const
+{
+    return apvts.getParameter (IDs::bypass);
+}
+
+template <typename HostType, typename SampleType>
+void VoiceModelerAudioProcessor::processConverted (juce::AudioBuffer<HostType>& buffer, ProcessingCore<SampleType>& core)
+{
+    // ホストと内部の精度が違うとき：確保済みの変換バッファへ maxBlock ずつ写して処理し、書き戻す
+    auto& tmp = core.conversion;
+    const int chs = juce::jmin (buffer.getNumChannels(), tmp.getNumChannels());
+    const int numSamples = buffer.getNumSamples();
+
+    for (int pos = 0; pos < numSamples; pos += tmp.getNumSamples())
+    {
+        const int len = juce::jmin (tmp.getNumSamples(), numSamples - pos);
+
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            const auto* src = buffer.getReadPointer (ch, pos);
+            auto* dst = tmp.getWritePointer (ch);
+            for (int i = 0; i < len; ++i)
+                dst[i] = (SampleType) src[i];
+        }
+
+        juce::AudioBuffer<SampleType> view (tmp.getArrayOfWritePointers(), chs, len); // 参照のみ（確保なし）
+        processBlockImpl (view, core);
+
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            const auto* src = tmp.getReadPointer (ch);
+            auto* dst = buffer.getWritePointer (ch, pos);
+            for (int i = 0; i < len; ++i)
+                dst[i] = (HostType) src[i];
+        }
+    }
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::processBlockImpl (juce::AudioBuffer<SampleType>& buffer, ProcessingCore<SampleType>& core)
+{
     const int numSamples = buffer.getNumSamples();
 
-    // === HPF ===
+    // 作業域（ドライ・RBass・動的 EQ・検出器）は maxBlock ぶんなので、それより長いブロックは分割して処理（確保し直さない）
+    if (numSamples > core.dry.getNumSamples() && core.dry.getNumSamples() > 0)
     {
-        juce::dsp::AudioBlock<float> b (buffer);
-        juce::dsp::ProcessContextReplacing<float> c (b);
-        hpf20.process (c);
+        for (int pos = 0; pos < numSamples; pos += core.dry.getNumSamples())
+        {
+            juce::AudioBuffer<SampleType> view (buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                                pos, juce::jmin (core.dry.getNumSamples(), numSamples - pos));
+            processBlockImpl (view, core);
+        }
+        return;
     }
 
+    juce::ScopedNoDenormals noDenormals;
+
+    // テレメトリ（計測は確保なし、publish はロックなしの SPSC リング）
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    TelemetrySnapshot snap;
+    snap.samplePosition = samplesProcessed;
+    snap.numSamples = numSamples;
+    measureLevels (buffer, snap.peakIn, snap.rmsIn);
+    rbassSumSq = 0.0;
+
+    // パラメータと係数の目標値を取り込み
+    latchParameters();
+
+    if (automation.isEmpty())
+    {
+        processSegment (buffer, core, snap, snap.peakIn);
+    }
+    else
+    {
+        // === サンプル精度のオートメーション ===
+        // 点の位置で区間に分け、区間の先頭でそこまでの点を反映する。区間は maxAutomationSegments 個まで、
+        // minAutomationSegment サンプル以上（近い点はまとめる）なので、1 ブロックの再計算の回数には上限がある
+        const auto apply = [this] (int index, float value) { applyAutomation (index, value); };
+        const int chs = juce::jmin (numChannels, buffer.getNumChannels());
+        int segments = 0;
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            int end = ++segments < maxAutomationSegments ? automation.nextOffset (pos, numSamples) : numSamples;
+            end = juce::jlimit (juce::jmin (pos + minAutomationSegment, numSamples), numSamples, end);
+
+            // この区間に入る点（まとめた分を含む）は区間の先頭で効かせる
+            automation.popUntil (end - 1, apply);
+
+            juce::AudioBuffer<SampleType> view (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), pos, end - pos);
+
+            float peak = 0.0f;
+            for (int ch = 0; ch < chs; ++ch)
+                peak = juce::jmax (peak, (float) view.getMagnitude (ch, 0, end - pos));
+
+            processSegment (view, core, snap, peak);
+            pos = end;
+        }
+
+        // ブロックより先の点は次のブロックへ繰り越す
+        automation.endBlock (numSamples);
+    }
+
+    measureLevels (buffer, snap.peakOut, snap.rmsOut);
+    lastOutPeak = snap.peakOut;
+    snap.rbassRms = numSamples > 0 ? (float) std::sqrt (rbassSumSq / numSamples) : 0.0f;
+    snap.idle = idle;
+
+    const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    snap.blockMs = (float) (elapsed * 1000.0);
+    snap.load    = numSamples > 0 ? (float) (elapsed * sr / numSamples) : 0.0f;
+    snap.wallMs  = juce::Time::getMillisecondCounterHiRes();
+    telemetryFifo.push (snap);
+
+    samplesProcessed += numSamples;
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::processSegment (juce::AudioBuffer<SampleType>& buffer, ProcessingCore<SampleType>& core,
+                                                 TelemetrySnapshot& snap, float inputPeak)
+{
+    // ブロック（オートメーション点があればその区間）1 つぶんの処理。パラメータは params から読む
+    const int numSamples = buffer.getNumSamples();
+
     // スムージング対象
-    const float outDb = pGainDb ? pGainDb->load() : 0.0f;
-    smoothOutGain.setTargetValue (juce::Decibels::decibelsToGain (outDb));
-    const float rbMix01 = juce::jlimit (0.0f, 100.0f, pRBassMix ? pRBassMix->load() : 0.0f) / 100.0f;
-    smoothRBassMix.setTargetValue (rbMix01);
+    core.smoothOutGain.setTargetValue (juce::Decibels::decibelsToGain ((SampleType) params.gainDb));
+    core.smoothRBassMix.setTargetValue ((SampleType) params.rbMix / 100);
+    core.smoothRBassDrive.setTargetValue (juce::Decibels::decibelsToGain ((SampleType) params.rbDriveDb));
 
-    // 係数更新
-    updateFilters();
+    satQuality = (Saturation::Quality) params.satQuality;
 
-    // === フィルタチェイン（フォルマント→鼻腔→ノッチ→EQ） ===
-    juce::dsp::AudioBlock<float> block (buffer);
-    juce::dsp::ProcessContextReplacing<float> ctx (block);
+    // オーバーサンプリング倍率／ピッチ・フォルマント・EQ 位相モード／リミッター先読みの切替（確保なし。レイテンシ通知は非同期）
+    const int latencyBefore = computeLatency();
+    selectOversampling (params.oversampling);
+    updateLimiter (core);
+    selectPitchMode (params.pitchMode);
+    selectFormantMode ((FormantMode) params.formantMode);
+    selectEqPhase (params.eqPhase == 1);
 
-    formantF1.process (ctx);
-    formantF2.process (ctx);
-    formantF3.process (ctx);
+    const int latency = computeLatency();
+    if (latency != latencyBefore)
+    {
+        pendingLatency.store (latency);
+        updatePending.store (true);
+    }
+
+    // 内部精度が変わったら timerCallback で準備し直す（ここでは確保しない）
+    if (wantsDoubleCore() != useDouble)
+        updatePending.store (true);
+
+    const int chs = juce::jmin (numChannels, buffer.getNumChannels());
+
+    // === バイパス ===
+    // ドライは常にレイテンシぶん遅らせて持っておき、切替の瞬間からウェットと時間軸を揃えて混ぜる
+    const bool bypassed = hostBypassed || params.bypass;
+    core.smoothWet.setTargetValue (bypassed ? SampleType (0) : SampleType (1));
+    snap.bypassed = bypassed;
+
+    for (int ch = 0; ch < chs; ++ch)
+        juce::FloatVectorOperations::copy (core.dry.getWritePointer (ch), buffer.getReadPointer (ch), numSamples);
+    core.dryAlign.setDelay (latency);
+    core.dryAlign.process (core.dry.getArrayOfWritePointers(), chs, 0, numSamples);
+
+    if (! core.smoothWet.isSmoothing() && core.smoothWet.getTargetValue() == SampleType (0))
+    {
+        // 完全にバイパス：ウェットは処理しない（戻るときに状態をリセット）
+        for (int ch = 0; ch < chs; ++ch)
+            juce::FloatVectorOperations::copy (buffer.getWritePointer (ch), core.dry.getReadPointer (ch), numSamples);
+
+        wetSuspended = true;
+        idle = false;
+        return;
+    }
+
+    if (wetSuspended)
+    {
+        resetWet (core);
+        wetSuspended = false;
+    }
 
-    nasal1k.process (ctx);
-    nasal3k.process (ctx);
+    // === アイドル（無音入力でテールも抜けたら処理を省く） ===
+    silentSamples = inputPeak <= silenceThreshold ? silentSamples + numSamples : 0;
 
-    nasalNotch1k.process (ctx);
-    nasalNotch3k.process (ctx);
+    if (silentSamples >= latency + (juce::int64) (idleHoldSeconds * sr) && lastOutPeak <= silenceThreshold)
+    {
+        if (! idle)
+        {
+            resetWet (core);
+            idle = true;
+        }
 
-    eq1.process (ctx);
-    eq2.process (ctx);
-    eq3.process (ctx);
+        // ドライも無音なので、バイパスのフェード中でも出力は無音
+        buffer.clear (0, numSamples);
+        core.smoothWet.skip (numSamples);
+        return;
+    }
 
-    // === RBass 合成 ===
-    processRBass (buffer);
+    idle = false;
 
-    // === Output Gain ===
-    outGain.setGainLinear (smoothOutGain.getNextValue());
-    outGain.process (ctx);
+    // === ピッチシフト ===
+    if (pitchMode > 0)
+    {
+        pitchShifter.setSemitone (params.pitchSemis);
+        pitchShifter.process (buffer.getArrayOfWritePointers(), chs, 0, numSamples);
+    }
 
-    // === Limiter（安全マージン） ===
-    limiter.process (ctx);
+    // === フォルマント（Spectral モード：包絡ワープ） ===
+    if (formantMode == FormantMode::spectral)
+    {
+        formantShifter.setRatio (params.formantRatio);
+        formantShifter.process (buffer.getArrayOfWritePointers(), chs, 0, numSamples);
+    }
 
-    // 仕上げにソフトクリップ（彩度を少し）
-    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    // === フォルマント（Adaptive モード：チェインに入る信号の F1–F3 を追跡して Peak の中心へ） ===
+    // バックグラウンド解析では推定値が 1 ホップ程度遅れて届く
+    if (formantMode == FormantMode::adaptive)
+    {
+        formantTracker.push (buffer.getArrayOfReadPointers(), chs, 0, numSamples);
+        const auto estimate = formantTracker.getEstimate();
+        coeffEngine.setTrackedFormants (estimate.hz.data(), estimate.voicing);
+    }
+
+    // === 動的 EQ／RBass ダッキングの検出（区間に 1 回、4 レーンまとめて） ===
+    // キーは Input ならチェインに入る信号、Sidechain ならサイドチェイン入力（バスが無効ならキーは無音でゲインは 1）
+    if (updateDynamics (core))
+    {
+        if (params.dynKey == 2)
+            dynamics.process (buffer.getArrayOfReadPointers() + chs,
+                              juce::jlimit (0, numKeyChannels, buffer.getNumChannels() - numChannels), 0, numSamples);
+        else
+            dynamics.process (buffer.getArrayOfReadPointers(), chs, 0, numSamples);
+    }
+
+    // === 線形位相 EQ（FIR。受け持つ段はチェイン側で素通しになっている） ===
+    // 係数の変化はワーカーが設計し直して数 ms 後にクロスフェードで入る
+    if (firActive)
+        linearEq.process (buffer.getArrayOfWritePointers(), chs, 0, numSamples);
+
+    // === フィルタチェイン（HPF→フォルマント→鼻腔→ノッチ→EQ、1 パス。恒等の段は省く）＋ RBass 合成 ===
+    // 係数がランプ中はコントロールレートでブロックを分割し、区間ごとに係数を進める。
+    for (int pos = 0; pos < numSamples;)
+    {
+        const int len = coeffEngine.isSmoothing() ? juce::jmin (controlInterval, numSamples - pos)
+                                                  : numSamples - pos;
+        updateFilters (core, len);
+        core.chain.process (buffer.getArrayOfWritePointers(), chs, pos, len);
+        if ((dynamicLanes & 7u) != 0)
+            processDynamicEq (buffer, core, pos, len);
+        processRBass (buffer, core, pos, len);
+        pos += len;
+    }
+
+    // === Output Gain（サンプル単位のランプ） ===
+    core.smoothOutGain.applyGain (buffer, numSamples);
+
+    // === Limiter（先読みブリックウォール、4x 真のピーク） ===
+    core.limiter.process (buffer.getArrayOfWritePointers(), chs, 0, numSamples);
+    snap.gainReductionDb = juce::jmin (snap.gainReductionDb,
+                                       juce::Decibels::gainToDecibels (core.limiter.getMinGainAndReset(), -120.0f));
+
+    // === バイパスのクロスフェード（out = dry + wet 比 × (wet − dry)） ===
+    if (core.smoothWet.isSmoothing())
     {
-        auto* s = buffer.getWritePointer (ch);
         for (int i = 0; i < numSamples; ++i)
-            s[i] = softClip (s[i]);
+        {
+            const auto w = core.smoothWet.getNextValue();
+            for (int ch = 0; ch < chs; ++ch)
+            {
+                auto* out = buffer.getWritePointer (ch);
+                const auto d = core.dry.getReadPointer (ch)[i];
+                out[i] = d + w * (out[i] - d);
+            }
+        }
     }
 }
 
-void VoiceModelerAudioProcessor::updateFilters()
+template <typename SampleType>
+void VoiceModelerAudioProcessor::measureLevels (const juce::AudioBuffer<SampleType>& buffer, float& peak, float& rms) const noexcept
 {
-    const float ratio = pFormantRatio ? pFormantRatio->load() : 1.0f; // 0.7–1.4
-    const float nasal  = pNasalAmt ? pNasalAmt->load() : 0.0f;        // 0–100
-    const float nasalGainDb = juce::jmap (nasal, 0.0f, 100.0f, 0.0f, 8.0f);
+    // 全チャンネルのピーク最大値と、チャンネル平均の RMS
+    const int chs = juce::jmin (numChannels, buffer.getNumChannels());
+    const int n = buffer.getNumSamples();
+    double sumSq = 0.0;
+    peak = 0.0f;
 
-    // フォルマント基準
-    const float F1 = 500.0f  * ratio;
-    const float F2 = 1500.0f * ratio;
-    const float F3 = 2500.0f * ratio;
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (buffer.getReadPointer (ch), n);
+        peak = juce::jmax (peak, (float) -range.getStart(), (float) range.getEnd());
+
+        const double r = (double) buffer.getRMSLevel (ch, 0, n);
+        sumSq += r * r;
+    }
 
-    const float Qf = 1.2f;
-    const float G1 = juce::Decibels::decibelsToGain ( 2.0f * (ratio - 1.0f));
-    const float G2 = juce::Decibels::decibelsToGain ( 1.5f * (ratio - 1.0f));
-    const float G3 = juce::Decibels::decibelsToGain ( 1.0f * (ratio - 1.0f));
+    rms = chs > 0 ? (float) std::sqrt (sumSq / chs) : 0.0f;
+}
 
-    *formantF1.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, F1, Qf, juce::jlimit (0.5f, 1.5f, G1));
-    *formantF2.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, F2, Qf, juce::jlimit (0.5f, 1.5f, G2));
-    *formantF3.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, F3, Qf, juce::jlimit (0.5f, 1.5f, G3));
+template <typename SampleType>
+void VoiceModelerAudioProcessor::updateFilters (ProcessingCore<SampleType>& core, int numSamples)
+{
+    // スムーザーを numSamples 進め、動いたバンドだけ再計算してカスケードの段／RBass BPF へ反映（確保なし）
+    const auto changed = coeffEngine.update (numSamples);
+    if (changed == 0)
+        return;
 
-    // 鼻腔レゾナンス
-    *nasal1k.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, 1000.0f, 2.0f,
-                        juce::Decibels::decibelsToGain (nasalGainDb));
-    *nasal3k.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, 3000.0f, 2.5f,
-                        juce::Decibels::decibelsToGain (nasalGainDb * 0.7f));
+    for (int b = 0; b < numChainStages; ++b)
+    {
+        const auto band = (FilterCoefficientEngine::Band) b;
+        if ((changed & FilterCoefficientEngine::bit (band)) == 0)
+            continue;
 
-    // 反共鳴ノッチ（=負ゲインのピーク）
-    const float notchPct = pNasalNotch ? pNasalNotch->load() : 0.0f; // 0–100
-    const float notchDepthDb = -juce::jmap (notchPct, 0.0f, 100.0f, 0.0f, 12.0f);
-    *nasalNotch1k.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, 1000.0f, 2.0f,
-                            juce::Decibels::decibelsToGain (notchDepthDb));
-    *nasalNotch3k.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, 3000.0f, 2.5f,
-                            juce::Decibels::decibelsToGain (notchDepthDb * 0.8f));
+        // FIR が受け持っている段は素通しに
+        core.chain.setStage (b, firActive && isFirStage (b) ? BiquadCoeffs {} : stageCoefficients (b));
+    }
 
-    // 3-band EQ
-    const auto mkPeak = [this](float f, float q, float gDb)
+    // Minimum の間は FIR へ段を渡さない（ワーカーも止まっている）
+    if (linearPhase && (changed & firStageMask) != 0)
+        sendFirStages();
+
+    if ((changed & FilterCoefficientEngine::bit (FilterCoefficientEngine::rbassFocus)) != 0)
+        BiquadDesign::copyTo (coeffEngine.get (FilterCoefficientEngine::rbassFocus), *core.rbassBand.state);
+
+    // 動的 EQ の帯域（検出と帯域分割で同じ BPF）
+    for (int k = 0; k < 3; ++k)
     {
-        return juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, f, q,
-                juce::Decibels::decibelsToGain (gDb));
-    };
-    *eq1.state = *mkPeak (juce::jlimit (20.0f, 18000.0f, pEQ1Freq->load()),
-                          juce::jlimit (0.3f, 5.0f,    pEQ1Q->load()),
-                          juce::jlimit (-18.0f, 18.0f, pEQ1Gain->load()));
-    *eq2.state = *mkPeak (juce::jlimit (20.0f, 18000.0f, pEQ2Freq->load()),
-                          juce::jlimit (0.3f, 5.0f,    pEQ2Q->load()),
-                          juce::jlimit (-18.0f, 18.0f, pEQ2Gain->load()));
-    *eq3.state = *mkPeak (juce::jlimit (20.0f, 18000.0f, pEQ3Freq->load()),
-                          juce::jlimit (0.3f, 5.0f,    pEQ3Q->load()),
-                          juce::jlimit (-18.0f, 18.0f, pEQ3Gain->load()));
+        const auto band = (FilterCoefficientEngine::Band) (FilterCoefficientEngine::dynamic1 + k);
+        if ((changed & FilterCoefficientEngine::bit (band)) == 0)
+            continue;
+
+        core.dynamicBands[(size_t) k].setStage (0, coeffEngine.get (band));
+        dynamics.setBand (k, coeffEngine.get (band));
+    }
+}
+
+template <typename SampleType>
+bool VoiceModelerAudioProcessor::updateDynamics (ProcessingCore<SampleType>& core) noexcept
+{
+    // Off のときは range 0 として扱い、動いていたゲインが 1 に戻るまでは処理を続ける
+    juce::uint32 lanes = 0;
+    for (int l = 0; l < DynamicsDetector::numLanes; ++l)
+    {
+        dynamics.setLane (l, params.dynThresholdDb[(size_t) l], params.dynKey > 0 ? params.dynRangeDb[(size_t) l] : 0.0f);
+        if (dynamics.isEngaged (l))
+            lanes |= 1u << l;
+    }
+
+    // 動き始めたレーン：検出器と帯域分割の古い状態を捨てる（ゲインは 1 から始まる）
+    if (const auto started = lanes & ~dynamicLanes; started != 0)
+    {
+        if (dynamicLanes == 0)
+            dynamics.reset();
+
+        for (int k = 0; k < 3; ++k)
+            if ((started & (1u << k)) != 0)
+                core.dynamicBands[(size_t) k].reset();
+    }
 
-    // RBass BPF
-    const float focus = juce::jlimit (40.0f, 240.0f, pRBassFocusHz ? pRBassFocusHz->load() : 100.0f);
-    *rbassBand.state = *juce::dsp::IIR::Coefficients<float>::makeBandPass (sr, focus, 1.0f);
+    dynamicLanes = lanes;
+    if (lanes != 0)
+        dynamics.setTiming (params.dynAttackMs, params.dynReleaseMs);
 
-    // HPF（20～30Hz 目安）
-    *hpf20.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass (sr, 25.0f);
+    return lanes != 0;
+}
+
+template <typename SampleType>
+void VoiceModelerAudioProcessor::processDynamicEq (juce::AudioBuffer<SampleType>& buffer, ProcessingCore<SampleType>& core,
+                                                   int startSample, int numSamples)
+{
+    // 静的な EQ を通った信号から帯域を BPF で取り出し、(ゲイン - 1) 倍して足す。
+    // 1 + (g - 1) × BPF は中心で g 倍のピークなので、静的なゲインに動的なゲインが掛かる（係数はブロック内で動かさない）
+    const int chs = juce::jmin (numChannels, buffer.getNumChannels());
+    auto& band = core.dynamicBand;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        if ((dynamicLanes & (1u << k)) == 0)
+            continue;
+
+        for (int ch = 0; ch < chs; ++ch)
+            juce::FloatVectorOperations::copy (band.getWritePointer (ch), buffer.getReadPointer (ch, startSample), numSamples);
+        core.dynamicBands[(size_t) k].process (band.getArrayOfWritePointers(), chs, 0, numSamples);
+
+        const float* gain = dynamics.getGains (k) + startSample;
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            auto* out = buffer.getWritePointer (ch, startSample);
+            const auto* split = band.getReadPointer (ch);
+            for (int i = 0; i < numSamples; ++i)
+                out[i] += ((SampleType) gain[i] - SampleType (1)) * split[i];
+        }
+    }
 }
 
 juce::AudioProcessorEditor* VoiceModelerAudioProcessor::createEditor()
 {
-    // まずは Generic で全パラメータ操作可能に
-    return new juce::GenericAudioProcessorEditor (*this);
+    // パラメータは Generic、下にメーター（テレメトリ）
+    return new VoiceModelerAudioProcessorEditor (*this);
 }
 
 void VoiceModelerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    if (auto xml = state.createXml())
-        copyXmlToBinary (*xml, destData);
+    pluginState.save (destData);
 }
 
 void VoiceModelerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    if (auto xml = getXmlFromBinary (data, sizeInBytes))
-        apvts.replaceState (juce::ValueTree::fromXml (*xml));
+    pluginState.load (data, sizeInBytes);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout VoiceModelerAudioProcessor::createParameterLayout()
@@ -276,6 +1107,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout VoiceModelerAudioProcessor::
     using P = juce::AudioProcessorValueTreeState;
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> ps;
 
+    // バイパス（ホストのバイパスボタンもこれを使う）
+    ps.push_back (std::make_unique<juce::AudioParameterBool>(
+        IDs::bypass, "Bypass", false));
+
     // 出力ゲイン
     ps.push_back (std::make_unique<juce::AudioParameterFloat>(
         IDs::gainDb, "Output Gain",
@@ -294,6 +1129,52 @@ juce::AudioProcessorValueTreeState::ParameterLayout VoiceModelerAudioProcessor::
         IDs::nasalNotch, "Nasal Notch (%)",
         juce::NormalisableRange<float> (0.0f, 100.0f, 0.1f), 0.0f));
 
+    // ピッチ（半音）と方式：Delay（2 タップ、低遅延）／PSOLA（周期同期、フォルマント保持）
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::pitchSemis, "Pitch (st)",
+        juce::NormalisableRange<float> (-12.0f, 12.0f, 0.01f), 0.0f));
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::pitchMode, "Pitch Mode",
+        juce::StringArray { "Off", "Delay", "PSOLA" }, 0));
+
+    // フォルマント方式：Peak（固定 3 ピーク EQ、軽い）／Spectral（ケプストラム包絡ワープ、レイテンシあり）／
+    // Adaptive（入力の F1–F3 を追跡したピーク EQ、レイテンシなし）
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::formantMode, "Formant Mode",
+        juce::StringArray { "Peak", "Spectral", "Adaptive" }, 0));
+
+    // EQ の位相：Minimum（IIR、レイテンシなし）／Linear（FIR、約 20 ms のレイテンシ）。レイテンシが変わるのでオートメーション不可
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::eqPhase, "EQ Phase",
+        juce::StringArray { "Minimum", "Linear" }, 0,
+        juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+
+    // 非線形部（RBass）のオーバーサンプリング
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::oversampling, "Oversampling",
+        juce::StringArray { "Off", "2x", "4x", "8x" }, 0));
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::satQuality, "Saturation Quality",
+        juce::StringArray { "Fast", "Balanced", "Accurate" }, 1));
+
+    // 内部の演算精度（Host = ホストのバッファに合わせる）。切替時は処理を一瞬止めて準備し直すのでオートメーション不可
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::precision, "Precision",
+        juce::StringArray { "Host", "Float", "Double" }, 0,
+        juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+
+    // 出力リミッター：ceiling は真のピーク（dBTP）。先読みはレイテンシになるのでオートメーション不可
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::limCeilingDb, "Limiter Ceiling (dBTP)",
+        juce::NormalisableRange<float> (-12.0f, 0.0f, 0.01f), -1.0f));
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::limReleaseMs, "Limiter Release (ms)",
+        juce::NormalisableRange<float> (10.0f, 500.0f, 0.1f, 0.5f), 50.0f));
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::limLookaheadMs, "Limiter Lookahead (ms)",
+        juce::NormalisableRange<float> (0.5f, (float) maxLimiterLookaheadMs, 0.01f), 1.5f,
+        juce::AudioParameterFloatAttributes().withAutomatable (false)));
+
     // RBass ライク
     ps.push_back (std::make_unique<juce::AudioParameterFloat>(
         IDs::rbDriveDb, "RBass Drive (dB)",
@@ -319,6 +1200,30 @@ juce::AudioProcessorValueTreeState::ParameterLayout VoiceModelerAudioProcessor::
     addEq (IDs::eq2Freq, IDs::eq2Gain, IDs::eq2Q, "EQ2 Freq", "EQ2 Gain", "EQ2 Q", 1000.0f);
     addEq (IDs::eq3Freq, IDs::eq3Gain, IDs::eq3Q, "EQ3 Freq", "EQ3 Gain", "EQ3 Q", 3500.0f);
 
+    // 動的 EQ／RBass ダッキング：キー（Off = 静的、Input = チェインに入る信号、Sidechain = サイドチェイン入力）の
+    // 帯域の包絡がしきい値を超えた量に応じて、EQ1–3 のゲインと RBass Mix を Range まで動かす（しきい値 +12 dB でいっぱい）
+    ps.push_back (std::make_unique<juce::AudioParameterChoice>(
+        IDs::dynKey, "Dynamic Key",
+        juce::StringArray { "Off", "Input", "Sidechain" }, 0));
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::dynAttackMs, "Dynamic Attack (ms)",
+        juce::NormalisableRange<float> (0.1f, 50.0f, 0.01f, 0.5f), 5.0f));
+    ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+        IDs::dynReleaseMs, "Dynamic Release (ms)",
+        juce::NormalisableRange<float> (10.0f, 1000.0f, 0.1f, 0.5f), 120.0f));
+
+    auto addDynamic = [&ps](const char* tId, const char* rId, const char* tName, const char* rName, float minRange, float maxRange)
+    {
+        ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+            tId, tName, juce::NormalisableRange<float>(-60.0f, 0.0f, 0.01f), -30.0f));
+        ps.push_back (std::make_unique<juce::AudioParameterFloat>(
+            rId, rName, juce::NormalisableRange<float>(minRange, maxRange, 0.01f), 0.0f));
+    };
+    addDynamic (IDs::eq1DynThreshDb, IDs::eq1DynRangeDb, "EQ1 Dyn Threshold (dB)", "EQ1 Dyn Range (dB)", -18.0f, 18.0f);
+    addDynamic (IDs::eq2DynThreshDb, IDs::eq2DynRangeDb, "EQ2 Dyn Threshold (dB)", "EQ2 Dyn Range (dB)", -18.0f, 18.0f);
+    addDynamic (IDs::eq3DynThreshDb, IDs::eq3DynRangeDb, "EQ3 Dyn Threshold (dB)", "EQ3 Dyn Range (dB)", -18.0f, 18.0f);
+    addDynamic (IDs::rbDuckThreshDb, IDs::rbDuckRangeDb, "RBass Duck Threshold (dB)", "RBass Duck Range (dB)", -24.0f, 0.0f);
+
     return { ps.begin(), ps.end() };
 }
 
@@ -1,18 +1,45 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "FilterCoefficientEngine.h"
+#include "BiquadCascade.h"
+#include "SampleDelay.h"
+#include "ScratchArena.h"
+#include "TruePeakLimiter.h"
+#include "FormantShifter.h"
+#include "FormantTracker.h"
+#include "LinearPhaseEq.h"
+#include "DynamicsDetector.h"
+#include "SharedResources.h"
+#include "SimplePitchShifter.h"
+#include "Saturation.h"
+#include "Telemetry.h"
+#include "PluginState.h"
+#include "AutomationQueue.h"
 
-class VoiceModelerAudioProcessor : public juce::AudioProcessor
+class VoiceModelerAudioProcessor : public juce::AudioProcessor,
+                                   private juce::Timer
 {
 public:
     VoiceModelerAudioProcessor();
-    ~VoiceModelerAudioProcessor() override = default;
+    ~VoiceModelerAudioProcessor() override { stopTimer(); }
 
     //=== AudioProcessor overrides ===
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override {}
+    void releaseResources() override { formantTracker.release(); linearEq.release(); }
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // バイパス：ホストにはパラメータとして見せる。processBlockBypassed もウェット→ドライのクロスフェードで処理し、
+    // 切替の前後でレイテンシ（ドライも同じだけ遅らせる）は変わらない
+    juce::AudioProcessorParameter* getBypassParameter() const override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // 64bit ホストのバッファをそのまま受ける。内部精度は Precision パラメータ（Host/Float/Double）で選ぶ
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+    bool isUsingDoubleCore() const noexcept { return useDouble; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -23,64 +50,290 @@ public:
     bool isMidiEffect() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
 
-    int getNumPrograms() override { return 1; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram (int) override {}
-    const juce::String getProgramName (int) override { return {}; }
+    // ファクトリプリセットをホストのプログラムとして見せる（切替は prepareToPlay なし）
+    int getNumPrograms() override { return PluginState::getNumPresets(); }
+    int getCurrentProgram() override { return pluginState.getCurrentPreset(); }
+    void setCurrentProgram (int index) override { pluginState.loadPreset (index); }
+    const juce::String getProgramName (int index) override { return PluginState::getPresetName (index); }
     void changeProgramName (int, const juce::String&) override {}
 
+    // 状態はバイナリ（PluginState.h）。旧版の XML も読める
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    // 1 インスタンスで扱える最大チャンネル数（モノ／ステレオ／サラウンド／アンビソニックス）
+    static constexpr int maxChannels = 16;
+    // サイドチェインの最大チャンネル数（キーはモノ和。メインと合わせて AudioBuffer の参照が確保なしで済む数に収める）
+    static constexpr int maxKeyChannels = 8;
+
+    // 係数のコントロールレート（16–32 サンプル程度を想定）
+    static constexpr int defaultControlInterval = 32;
+    void setControlInterval (int numSamples) noexcept { controlInterval = juce::jlimit (1, 4096, numSamples); }
+
+    // Adaptive フォルマントの解析をワーカースレッドで行うか（次の prepareToPlay から）
+    void setBackgroundFormantAnalysis (bool shouldUseThread) noexcept { backgroundFormantAnalysis = shouldUseThread; }
+    FormantTracker::Estimate getFormantEstimate() const noexcept    { return formantTracker.getEstimate(); }
+
+    // prepareToPlay で確保した作業域（ScratchArena）のバイト数
+    size_t getScratchBytes() const noexcept { return scratch.getCapacityBytes(); }
+
+    // 線形位相 EQ の畳み込みの分割長と、先頭分割を直接畳み込んで分割ぶんのレイテンシをなくすか（次の prepareToPlay から）
+    static constexpr int defaultLinearPhasePartition = 128;
+    void setLinearPhasePartitionSize (int numSamples) noexcept    { linearPhasePartition = juce::jlimit (16, 4096, numSamples); }
+    void setLinearPhaseZeroLatency (bool shouldUseHead) noexcept  { linearPhaseZeroLatency = shouldUseHead; }
+    int getLinearPhaseLatencySamples() const noexcept             { return linearEq.getLatencySamples(); }
+
+    // メッセージループのないツール用：タイマーを待たずに、オーディオスレッドが頼んだ処理
+    // （レイテンシの通知、内部精度の切替、線形位相 EQ のワーカーの起動・停止）をこのスレッドで行う
+    void handlePendingUpdates()                                   { timerCallback(); }
+
+    // フィルタ係数をプロセス内の全インスタンスで共有するキャッシュ経由で作る（既定はオン。次の prepareToPlay から）。
+    // 周波数・Q・ゲインを相対 0.025 % に丸めてから計算するので、オフのときと係数がわずかに違う。
+    // 窓テーブルはこの設定に関係なく常に共有、FFT は共有しない（SharedResources.h）
+    void setSharedCoefficientCache (bool shouldShare) noexcept    { sharedCoefficientCache = shouldShare; }
+
     // Params
     juce::AudioProcessorValueTreeState apvts;
+
+    // テレメトリ：processBlock が毎ブロック push、コレクタ（メッセージスレッド）が吸い出す
+    TelemetryFifo& getTelemetryFifo() noexcept     { return telemetryFifo; }
+    TelemetryCollector& getTelemetry() noexcept    { return telemetry; }
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    // プリセット・A/B スナップショット（メッセージスレッド）
+    PluginState& getPluginState() noexcept         { return pluginState; }
+
+    // サンプル精度のオートメーション。JUCE のラッパーはブロック内の点を processBlock の前にまとめて反映するので、
+    // 点の位置が分かる呼び出し側（自前のラッパー・オフラインレンダラ・ベンチ）が processBlock の直前に同じスレッドで積む。
+    // 対象はゲイン・RBass・ピッチ量・フォルマント比・リミッター・係数系（モードの切替は従来どおりブロック先頭）。
+    // パラメータ自体も通常どおりブロック末尾の値に更新しておくこと（次のブロックはそこから始まる）。
+    static constexpr int numAutomationTargets = 19;
+    static int getAutomationIndex (const juce::String& paramID) noexcept;      // 対象外なら -1
+    bool pushAutomation (int index, int sampleOffset, float plainValue) noexcept;
+    void pushAutomationCurve (int index, const float* plainValues, int numSamples) noexcept; // サンプルごとの曲線
+
+    // 1 ブロックを分ける区間数の上限と最短の区間（これより近い点はまとめて区間の先頭で効かせる）
+    static constexpr int maxAutomationSegments = 16;
+    static constexpr int minAutomationSegment = 8;
+    static constexpr int automationQueueCapacity = 256;  // パラメータあたりの点の数
+
 private:
     //=== Params (raw pointers) ===
     std::atomic<float>* pGainDb        = nullptr; // 出力ゲイン(dB)
-    std::atomic<float>* pFormantRatio  = nullptr; // 0.7–1.4
-    std::atomic<float>* pNasalAmt      = nullptr; // 0–100 %
+
+    std::atomic<float>* pFormantRatio  = nullptr; // 0.7–1.4（Spectral モード用。Peak / Adaptive は coeffEngine 側）
+    std::atomic<float>* pFormantMode   = nullptr; // 0=Peak, 1=Spectral, 2=Adaptive
+
+    std::atomic<float>* pPitchSemis    = nullptr; // -12〜+12 半音
+    std::atomic<float>* pPitchMode     = nullptr; // 0=Off, 1=Delay, 2=PSOLA
 
     std::atomic<float>* pRBassDriveDb  = nullptr; // 0–24 dB
-    std::atomic<float>* pRBassFocusHz  = nullptr; // 60–160 Hz
     std::atomic<float>* pRBassMix      = nullptr; // 0–100 %
 
-    std::atomic<float>* pEQ1Freq = nullptr; std::atomic<float>* pEQ1Gain = nullptr; std::atomic<float>* pEQ1Q = nullptr;
-    std::atomic<float>* pEQ2Freq = nullptr; std::atomic<float>* pEQ2Gain = nullptr; std::atomic<float>* pEQ2Q = nullptr;
-    std::atomic<float>* pEQ3Freq = nullptr; std::atomic<float>* pEQ3Gain = nullptr; std::atomic<float>* pEQ3Q = nullptr;
+    std::atomic<float>* pOversampling  = nullptr; // 0=Off, 1=2x, 2=4x, 3=8x
+    std::atomic<float>* pSatQuality    = nullptr; // 0=Fast, 1=Balanced, 2=Accurate
+    std::atomic<float>* pPrecision     = nullptr; // 0=Host, 1=Float, 2=Double
+    std::atomic<float>* pEqPhase       = nullptr; // 0=Minimum, 1=Linear
+
+    std::atomic<float>* pLimCeilingDb  = nullptr; // -12〜0 dBTP
+    std::atomic<float>* pLimReleaseMs  = nullptr; // 10–500 ms
+    std::atomic<float>* pLimLookahead  = nullptr; // 0.5–10 ms
 
-    std::atomic<float>* pNasalNotch = nullptr;   // 0–100 %
+    std::atomic<float>* pBypass        = nullptr; // 0/1
+
+    std::atomic<float>* pDynKey        = nullptr; // 0=Off, 1=Input, 2=Sidechain
+    std::atomic<float>* pDynAttackMs   = nullptr; // 0.1–50 ms
+    std::atomic<float>* pDynReleaseMs  = nullptr; // 10–1000 ms
+    std::array<std::atomic<float>*, DynamicsDetector::numLanes> pDynThresholdDb {}, pDynRangeDb {}; // EQ1–3, RBass
+
+    // ブロック先頭でまとめて取り込むパラメータ（A/B・プリセットの切替中は前の値のまま。オーディオスレッド専用）
+    struct BlockParams
+    {
+        float gainDb = 0.0f, rbMix = 0.0f, rbDriveDb = 0.0f;
+        float pitchSemis = 0.0f, formantRatio = 1.0f;
+        float limCeilingDb = -1.0f, limReleaseMs = 50.0f, limLookaheadMs = 1.5f;
+        int oversampling = 0, satQuality = 1, pitchMode = 0, formantMode = 0, eqPhase = 0;
+        bool bypass = false;
+        int dynKey = 0;
+        float dynAttackMs = 5.0f, dynReleaseMs = 120.0f;
+        std::array<float, DynamicsDetector::numLanes> dynThresholdDb {}, dynRangeDb {};
+    };
+    BlockParams params;
+    static float* blockParamField (BlockParams&, int automationIndex) noexcept;
+
+    // ブロック内のオートメーション点（オーディオスレッド専用）
+    AutomationQueue automation;
+    std::array<juce::RangedAudioParameter*, numAutomationTargets> automationParams {};
+    std::array<int, numAutomationTargets> automationSources {};   // 係数エンジンのソース（なければ -1）
 
     //=== DSP blocks ===
-    using Peak = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>,
-                                                juce::dsp::IIR::Coefficients<float>>;
-    Peak formantF1, formantF2, formantF3;         // フォルマント模擬（ピーク）
-    Peak nasal1k, nasal3k;                         // 鼻腔レゾナンス（ピーク）
-    Peak nasalNotch1k, nasalNotch3k;               // 鼻腔反共鳴（ノッチ相当：負ゲインのピーク）
-    Peak eq1, eq2, eq3;                            // 3バンドEQ
-    Peak hpf20;                                    // サブソニックHPF
+    // HPF → フォルマント(F1–F3) → 鼻腔(1k/3k) → ノッチ(1k/3k) → EQ(1–3) の 11 段を 1 パスで処理。
+    // 段番号は FilterCoefficientEngine::Band（hpf … eq3）と一致。
+    static constexpr int numChainStages = FilterCoefficientEngine::eq3 + 1;
+    // 線形位相 EQ の FIR が受け持ちうる段（HPF 以外）
+    static constexpr juce::uint32 firStageMask = ((1u << numChainStages) - 1u)
+                                               & ~FilterCoefficientEngine::bit (FilterCoefficientEngine::hpf);
+
+    // 非線形部だけのオーバーサンプリング（RBass 倍音生成）。
+    // 2x/4x/8x を prepareToPlay で全部用意し、切替時は確保しない。
+    static constexpr int numOversamplingFactors = 3;
+
+    // リミッターの先読みの上限（この長さで prepare し、以後は確保なしで切り替える）
+    static constexpr double maxLimiterLookaheadMs = 10.0;
 
-    juce::dsp::Gain<float> outGain;                // 出力ゲイン
-    juce::dsp::Compressor<float> limiter;          // リミッター
+    // アイドル判定：入力がこのレベル以下（約 -120 dBFS）でレイテンシ＋保持時間続き、
+    // 直前の出力も同レベル以下なら処理を丸ごと省いて無音を出す
+    static constexpr float silenceThreshold = 1.0e-6f;
+    static constexpr double idleHoldSeconds = 0.05;
+    static constexpr double bypassFadeSeconds = 0.02;
 
-    // RBass 生成用：モノ抽出＋BPF
-    juce::AudioBuffer<float> rbassMono;
-    Peak rbassBand;
+    // サンプル型に依存する DSP 状態。float / double の 2 つを持ち、処理は processBlockImpl の
+    // 1 つの実装を共有する。prepareToPlay で使う方だけ確保し、もう一方は解放しておく。
+    // ブロック長に比例する作業域・遅延線はプロセッサの ScratchArena から切り出す（prepareScratch）。
+    template <typename SampleType>
+    struct ProcessingCore
+    {
+        using Peak = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<SampleType>,
+                                                    juce::dsp::IIR::Coefficients<SampleType>>;
+        using Oversampler = juce::dsp::Oversampling<SampleType>;
 
-    // Smoothers
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> smoothOutGain;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> smoothRBassMix;
+        void prepare (double sampleRate, int blockSize, int numChannels);
+        void prepareScratch (ScratchArena& arena, double sampleRate, int blockSize, int numChannels, int numKeyChannels);
+        void release();
+        void selectOversampling (int index, int alignDelay);
+
+        BiquadCascade<SampleType> chain;
+        TruePeakLimiter<SampleType> limiter;         // 出力段（先読み・真のピーク）
+
+        // RBass 生成用：モノ抽出＋BPF
+        juce::AudioBuffer<SampleType> rbassMono;
+        Peak rbassBand;
+
+        std::array<std::unique_ptr<Oversampler>, numOversamplingFactors> rbassOS;
+        SampleDelay<SampleType> rbassAlign;         // RBass 側の OS 遅延に合わせてドライを遅らせる
+        bool rbassIdle = false;                     // Mix 0 % で生成を止めている（再開時に BPF／OS をリセット）
+
+        // 動的 EQ：EQ1–3 を通った信号から帯域を取り出す BPF（1 段ずつ）と、その作業域
+        std::array<BiquadCascade<SampleType>, 3> dynamicBands;
+        juce::AudioBuffer<SampleType> dynamicBand;
+
+        // バイパス：入力をプラグインのレイテンシだけ遅らせたドライと、ウェットの比率（1 = 処理音）
+        juce::AudioBuffer<SampleType> dry;
+        SampleDelay<SampleType> dryAlign;
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> smoothWet;
+
+        // Smoothers（いずれもサンプル単位でランプ）
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> smoothOutGain;
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> smoothRBassMix;
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> smoothRBassDrive;
+
+        juce::AudioBuffer<SampleType> conversion;   // ホストのバッファと精度が違うときの受け渡し用
+    };
+
+    ProcessingCore<float>  coreF;
+    ProcessingCore<double> coreD;
+    bool useDouble = false;                       // prepareToPlay で確保した方（オーディオスレッドはこれだけ見る）
+
+    // 係数エンジン（パラメータリスナー＋dirty フラグ）
+    FilterCoefficientEngine coeffEngine;
+
+    // プロセス内で共有する窓・係数キャッシュ（参照カウント）
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    bool sharedCoefficientCache = true;
+
+    // 状態の保存・復元、プリセット、A/B（復元中はオーディオスレッドがパラメータを取り込まない）
+    PluginState pluginState;
+
+    // ピッチシフト（最前段。Off のときは処理もレイテンシもなし）
+    SimplePitchShifter pitchShifter;
+    int pitchMode = 0;                            // 0 = Off, 1 = Delay, 2 = PSOLA
+
+    // Spectral モード：チェインの前段で包絡ワープ（このとき F1–F3 の段は素通し）
+    // Adaptive モード：チェインに入る信号の F1–F3 を追跡し、Peak の中心をそこへ合わせる
+    enum class FormantMode { peak, spectral, adaptive };
+    FormantShifter formantShifter;
+    FormantTracker formantTracker;
+    FormantMode formantMode = FormantMode::peak;
+    bool backgroundFormantAnalysis = false;
+
+    // 線形位相 EQ：フォルマント〜EQ の段（Adaptive のフォルマント段を除く）をチェインの前段の FIR で受け持ち、
+    // IIR 側の同じ段は素通しにする。HPF は 25 Hz を表せる FIR が長すぎるので IIR のまま。
+    // Linear にしてから FIR が設計されて畳み込みに入るまでは、段は IIR 側で鳴らし、畳み込みもレイテンシも足さない
+    LinearPhaseEq linearEq;
+    bool linearPhase = false;                     // EQ Phase が Linear
+    bool firActive = false;                       // FIR が段を受け持っている（Linear にした後、IR が入ってから）
+    juce::uint32 firSequence = 0;                 // Linear にしたときに渡した段の番号（linearEq.isLoaded で待つ）
+    int linearPhasePartition = defaultLinearPhasePartition;
+    bool linearPhaseZeroLatency = false;
+
+    // 動的 EQ／RBass ダッキング：キー（入力 or サイドチェイン）の包絡をブロックに 1 回まとめて検出し、
+    // EQ1–3 は静的な EQ を通った信号の帯域成分を (ゲイン - 1) 倍して足す、RBass は生成した成分に掛ける。
+    // 係数はサンプルごとに計算し直さない。Off でゲインが 1 に戻ったレーンは処理しない（静的なときと同じ出力）
+    DynamicsDetector dynamics;
+    juce::uint32 dynamicLanes = 0;                // 処理中のレーン（DynamicsDetector::Lane のビット）
+    int numKeyChannels = 0;                       // サイドチェインのチャンネル数（バスが無効なら 0）
+
+    // オーバーサンプラの遅延（倍率ごと。float / double で同じ）
+    std::array<int, numOversamplingFactors> rbassOSLatency {};
+    int activeOS = 0;                             // 0 = Off, k = 2^k 倍
+    std::atomic<int> pendingLatency { 0 };
+    std::atomic<bool> updatePending { false };    // オーディオスレッド → timerCallback（レイテンシ通知／精度切替／FIR ワーカー）
+    std::atomic<bool> linearWorkerWanted { false }; // linearPhase の写し（timerCallback が線形位相 EQ のワーカーを起動・停止）
+
+    // tanh 近似の精度（ブロック先頭で取り込む）
+    Saturation::Quality satQuality = Saturation::Quality::balanced;
+
+    // アイドル／バイパス（オーディオスレッド専用）
+    juce::int64 silentSamples = 0;                // 入力が無音のまま続いたサンプル数
+    float lastOutPeak = 0.0f;                     // 直前ブロックの出力ピーク
+    bool idle = false;                            // 無音でウェット処理を省いている
+    bool wetSuspended = false;                    // 完全にバイパスしてウェット処理を省いている
+    bool hostBypassed = false;                    // processBlockBypassed から呼ばれている
+
+    // テレメトリ
+    TelemetryFifo telemetryFifo;
+    TelemetryCollector telemetry { telemetryFifo };
+    juce::int64 samplesProcessed = 0;
+    double rbassSumSq = 0.0;                      // このブロックで RBass が足した成分の二乗和
+
+    // 係数スムージング中にブロックを分割する間隔（サンプル）
+    int controlInterval = defaultControlInterval;
 
     double sr = 48000.0;
     int maxBlock = 0;
+    int numChannels = 2;
 
-    // ユーティリティ
-    inline float softClip (float x) noexcept { return juce::dsp::FastMathApproximations::tanh (x); }
+    // 作業域・遅延線・先読みのバッファ（prepareToPlay で 1 回確保。processBlock は maxBlock ずつに分けて処理し、確保しない）
+    ScratchArena scratch;
 
     // 内部処理
-    void updateFilters();
-    void processRBass (juce::AudioBuffer<float>& buffer);
+    void timerCallback() override;
+    BlockParams readParameters() const noexcept;
+    void latchParameters() noexcept;
+    void applyAutomation (int index, float plainValue) noexcept;
+    void selectOversampling (int index);
+    void selectFormantMode (FormantMode mode);
+    void selectPitchMode (int index);
+    void selectEqPhase (bool linear);
+    void sendFirStages() noexcept;
+    bool isFirStage (int band) const noexcept;
+    BiquadCoeffs stageCoefficients (int band) const noexcept;
+    bool wantsDoubleCore() const noexcept;
+    int computeLatency() const noexcept;
+    int limiterLookaheadSamples() const noexcept;
+
+    template <typename SampleType> void prepareCore (ProcessingCore<SampleType>&);
+    template <typename SampleType> void processBlockImpl (juce::AudioBuffer<SampleType>&, ProcessingCore<SampleType>&);
+    template <typename SampleType> void processSegment (juce::AudioBuffer<SampleType>&, ProcessingCore<SampleType>&,
+                                                        TelemetrySnapshot&, float inputPeak);
+    template <typename HostType, typename SampleType> void processConverted (juce::AudioBuffer<HostType>&, ProcessingCore<SampleType>&);
+    template <typename SampleType> void updateLimiter (ProcessingCore<SampleType>&);
+    template <typename SampleType> void resetWet (ProcessingCore<SampleType>&);
+    template <typename SampleType> void measureLevels (const juce::AudioBuffer<SampleType>& buffer, float& peak, float& rms) const noexcept;
+    template <typename SampleType> void updateFilters (ProcessingCore<SampleType>&, int numSamples);
+    template <typename SampleType> bool updateDynamics (ProcessingCore<SampleType>&) noexcept;
+    template <typename SampleType> void processDynamicEq (juce::AudioBuffer<SampleType>&, ProcessingCore<SampleType>&, int startSample, int numSamples);
+    template <typename SampleType> void processRBass (juce::AudioBuffer<SampleType>&, ProcessingCore<SampleType>&, int startSample, int numSamples);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceModelerAudioProcessor)
 };
@@ -0,0 +1,203 @@
+#include "PluginState.h"
+#include "ParameterIDs.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    // ファクトリプリセット：既定値からの差分だけを書く（実値。Choice はインデックス）
+    struct PresetValue { const char* id; float value; };
+    struct FactoryPreset { const char* name; std::initializer_list<PresetValue> values; };
+
+    const FactoryPreset factoryPresets[] =
+    {
+        { "Init", {} },
+        { "Warm Narrator", { { IDs::rbMix, 35.0f }, { IDs::rbDriveDb, 8.0f }, { IDs::rbFocusHz, 90.0f },
+                             { IDs::eq1Gain, 2.0f }, { IDs::eq3Gain, -1.5f } } },
+        { "Bright Presence", { { IDs::rbMix, 10.0f }, { IDs::eq2Freq, 400.0f }, { IDs::eq2Gain, -1.5f },
+                               { IDs::eq3Freq, 5000.0f }, { IDs::eq3Gain, 4.0f }, { IDs::eq3Q, 0.8f } } },
+        { "Telephone", { { IDs::rbMix, 0.0f }, { IDs::eq1Freq, 250.0f }, { IDs::eq1Gain, -18.0f }, { IDs::eq1Q, 0.5f },
+                         { IDs::eq2Freq, 1800.0f }, { IDs::eq2Gain, 6.0f }, { IDs::eq2Q, 0.7f },
+                         { IDs::eq3Freq, 4500.0f }, { IDs::eq3Gain, -18.0f }, { IDs::eq3Q, 0.5f },
+                         { IDs::limCeilingDb, -3.0f } } },
+        { "Deep Voice", { { IDs::pitchMode, 2.0f }, { IDs::pitchSemis, -4.0f },
+                          { IDs::formantMode, 1.0f }, { IDs::formantRatio, 0.85f }, { IDs::rbMix, 30.0f } } },
+        { "Small Character", { { IDs::pitchMode, 2.0f }, { IDs::pitchSemis, 5.0f },
+                               { IDs::formantMode, 1.0f }, { IDs::formantRatio, 1.25f },
+                               { IDs::nasalAmt, 30.0f }, { IDs::rbMix, 0.0f } } },
+        { "Nasal", { { IDs::nasalAmt, 70.0f }, { IDs::nasalNotch, 20.0f } } },
+    };
+}
+
+PluginState::PluginState (juce::AudioProcessorValueTreeState& state)
+: apvts (state)
+{
+    for (auto* p : apvts.processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (p))
+        {
+            const auto id = ranged->getParameterID();
+
+            // 衝突しないことを static_assert で確かめているのは IDs::all の ID だけ
+            jassert (std::any_of (std::begin (IDs::all), std::end (IDs::all), [&id] (const char* known) { return id == known; }));
+
+            entries.push_back ({ ranged, IDs::hash (id.toRawUTF8()), (juce::uint32) id.hashCode(),
+                                 id == IDs::bypass || id == IDs::precision });
+        }
+    }
+}
+
+int PluginState::indexOfHash (juce::uint32 idHash, bool legacy) const noexcept
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+        if ((legacy ? entries[i].legacyHash : entries[i].idHash) == idHash)
+            return (int) i;
+    return -1;
+}
+
+PluginState::Snapshot PluginState::defaults() const
+{
+    Snapshot s (entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        s[i] = entries[i].param->convertFrom0to1 (entries[i].param->getDefaultValue());
+    return s;
+}
+
+void PluginState::capture (Snapshot& s) const
+{
+    s.resize (entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        s[i] = entries[i].param->convertFrom0to1 (entries[i].param->getValue());
+}
+
+void PluginState::apply (const Snapshot& s, bool includeEngineSettings)
+{
+    jassert (s.size() == entries.size());
+    const ScopedWrite write (sequence);
+
+    for (size_t i = 0; i < juce::jmin (s.size(), entries.size()); ++i)
+    {
+        auto& e = entries[i];
+        if (e.engineSetting && ! includeEngineSettings)
+            continue;
+
+        // 変わらないパラメータはホストへ通知しない（リスナー・係数の再計算も起こさない）
+        const float normalised = e.param->convertTo0to1 (s[i]);
+        if (normalised != e.param->getValue())
+            e.param->setValueNotifyingHost (normalised);
+    }
+}
+
+void PluginState::save (juce::MemoryBlock& dest) const
+{
+    juce::MemoryOutputStream out (dest, false);
+    out.writeInt ((int) magic);
+    out.writeShort ((short) schemaVersion);
+    out.writeShort ((short) entries.size());
+
+    for (auto& e : entries)
+    {
+        out.writeInt ((int) e.idHash);
+        out.writeFloat (e.param->convertFrom0to1 (e.param->getValue()));
+    }
+}
+
+void PluginState::saveXml (juce::MemoryBlock& dest) const
+{
+    if (auto xml = apvts.copyState().createXml())
+        juce::AudioProcessor::copyXmlToBinary (*xml, dest);
+}
+
+bool PluginState::load (const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < 8)
+        return false;
+
+    juce::MemoryInputStream in (data, (size_t) sizeInBytes, false);
+
+    if ((juce::uint32) in.readInt() == magic)
+    {
+        // スキーマ版が新しくてもレコードの形は同じ（後ろに足したものは読み飛ばす）。版 1 は鍵の関数だけ違う
+        const bool legacyKeys = (juce::uint16) in.readShort() < 2;
+        const int count = (juce::uint16) in.readShort();
+        if (in.getNumBytesRemaining() < (juce::int64) count * 8)
+            return false;
+
+        auto s = defaults();
+        for (int r = 0; r < count; ++r)
+        {
+            const auto idHash = (juce::uint32) in.readInt();
+            const float value = in.readFloat();
+
+            if (const int i = indexOfHash (idHash, legacyKeys); i >= 0)
+                s[(size_t) i] = value;
+        }
+
+        apply (s, true);
+    }
+    else
+    {
+        // 旧形式：copyXmlToBinary した apvts の XML
+        auto xml = juce::AudioProcessor::getXmlFromBinary (data, sizeInBytes);
+        if (xml == nullptr || ! xml->hasTagName (apvts.state.getType().toString()))
+            return false;
+
+        const ScopedWrite write (sequence);
+        apvts.replaceState (juce::ValueTree::fromXml (*xml));
+    }
+
+    // 読み込んだ状態が A になり、B は次に切り替えたときに A から作る
+    slots[0].clear();
+    slots[1].clear();
+    activeSlot = Slot::a;
+    return true;
+}
+
+void PluginState::selectSlot (Slot slot)
+{
+    if (slot == activeSlot)
+        return;
+
+    auto& current = slots[activeSlot == Slot::a ? 0 : 1];
+    auto& target  = slots[slot == Slot::a ? 0 : 1];
+
+    capture (current);
+    if (target.empty())
+        target = current;
+
+    apply (target, false);
+    activeSlot = slot;
+}
+
+void PluginState::copyActiveToOther()
+{
+    capture (slots[activeSlot == Slot::a ? 1 : 0]);
+}
+
+int PluginState::getNumPresets() noexcept
+{
+    return (int) std::size (factoryPresets);
+}
+
+juce::String PluginState::getPresetName (int index)
+{
+    return juce::isPositiveAndBelow (index, getNumPresets()) ? juce::String (factoryPresets[index].name) : juce::String();
+}
+
+void PluginState::loadPreset (int index)
+{
+    if (! juce::isPositiveAndBelow (index, getNumPresets()))
+        return;
+
+    auto s = defaults();
+    for (auto& v : factoryPresets[index].values)
+    {
+        const int i = indexOfHash (IDs::hash (v.id));
+        jassert (i >= 0);
+        if (i >= 0)
+            s[(size_t) i] = v.value;
+    }
+
+    apply (s, false);
+    currentPreset = index;
+}
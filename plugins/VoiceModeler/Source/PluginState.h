@@ -0,0 +1,91 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <vector>
+
+// パラメータ状態の保存・復元（getStateInformation / setStateInformation）、ファクトリプリセット、A/B スナップショット。
+//
+// バイナリ形式（リトルエンディアン）：
+//   uint32 magic "VMST" / uint16 スキーマ版 / uint16 レコード数 / レコード数 × { uint32 ID のハッシュ, float 実値 }
+// ID のハッシュ（IDs::hash、FNV-1a。衝突は ParameterIDs.h の static_assert で調べる）で引くので、
+// パラメータの追加・並べ替えがあっても読める（状態にないパラメータは既定値、知らないハッシュは無視）。
+// スキーマ版 1 は鍵が juce::String::hashCode だったので、その版だけは同じ関数で引く。旧版の XML（apvts の copyState）もそのまま読む。
+//
+// 復元はメッセージスレッドで全パラメータを書き換える。その間はシーケンス番号を奇数にしておき、
+// オーディオスレッドは偶数で前後が一致したときだけ値を取り込む（途中まで書き換わった組み合わせを拾わない）。
+// どれも prepareToPlay は呼ばない（レイテンシが変わる切替は通常のパラメータ変更と同じく非同期に通知）。
+class PluginState
+{
+public:
+    explicit PluginState (juce::AudioProcessorValueTreeState&);
+
+    static constexpr juce::uint32 magic = 0x54534d56; // "VMST"
+    static constexpr int schemaVersion = 2;
+
+    //=== ホストの状態 ===
+    void save (juce::MemoryBlock& dest) const;
+    void saveXml (juce::MemoryBlock& dest) const;       // 旧形式（比較・書き出し用）
+    bool load (const void* data, int sizeInBytes);      // バイナリ／旧 XML。false = どちらでもない
+
+    //=== スナップショット（レイアウト順の実値） ===
+    using Snapshot = std::vector<float>;
+    void capture (Snapshot&) const;
+    // includeEngineSettings = false ならバイパスと内部精度は今の値のまま（A/B・プリセット用）
+    void apply (const Snapshot&, bool includeEngineSettings);
+
+    //=== A/B ===
+    enum class Slot { a, b };
+    Slot getActiveSlot() const noexcept { return activeSlot; }
+    void selectSlot (Slot);                             // 今の値を現在のスロットへ退避し、もう一方を適用
+    void copyActiveToOther();                           // 今の値をもう一方のスロットへ
+
+    //=== ファクトリプリセット（ホストのプログラムとしても見せる） ===
+    static int getNumPresets() noexcept;
+    static juce::String getPresetName (int index);
+    void loadPreset (int index);
+    int getCurrentPreset() const noexcept { return currentPreset; }
+
+    //=== オーディオスレッド ===
+    // beginRead が偶数を返したときだけ値を読み、endRead (同じ値) が true ならその値は一貫している
+    juce::uint32 beginRead() const noexcept             { return sequence.load (std::memory_order_acquire); }
+    static bool isStable (juce::uint32 seq) noexcept    { return (seq & 1u) == 0; }
+    bool endRead (juce::uint32 seq) const noexcept
+    {
+        std::atomic_thread_fence (std::memory_order_acquire);
+        return sequence.load (std::memory_order_relaxed) == seq;
+    }
+
+private:
+    struct Entry
+    {
+        juce::RangedAudioParameter* param = nullptr;
+        juce::uint32 idHash = 0;                        // IDs::hash
+        juce::uint32 legacyHash = 0;                    // スキーマ版 1 の鍵（juce::String::hashCode）
+        bool engineSetting = false;                     // バイパス・内部精度
+    };
+
+    int indexOfHash (juce::uint32 idHash, bool legacy = false) const noexcept;
+    Snapshot defaults() const;
+
+    // 書き換えの間だけシーケンス番号を奇数にする
+    struct ScopedWrite
+    {
+        explicit ScopedWrite (std::atomic<juce::uint32>& s) noexcept : seq (s)
+        {
+            seq.fetch_add (1, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_release);
+        }
+        ~ScopedWrite() { seq.fetch_add (1, std::memory_order_release); }
+        std::atomic<juce::uint32>& seq;
+    };
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::vector<Entry> entries;                         // レイアウト順
+
+    std::atomic<juce::uint32> sequence { 0 };
+    Snapshot slots[2];
+    Slot activeSlot = Slot::a;
+    int currentPreset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (PluginState)
+};
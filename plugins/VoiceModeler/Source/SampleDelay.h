@@ -0,0 +1,58 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ScratchArena.h"
+
+// 整数サンプルの遅延（レイテンシ補償用）。
+// リングは 2 のべき乗長で prepare 時に ScratchArena から切り出し、処理中はマスクで巻き戻すだけ。
+template <typename SampleType>
+class SampleDelay
+{
+public:
+    void prepare (int numChannelsToUse, int maxDelaySamples, ScratchArena& arena)
+    {
+        mask = juce::nextPowerOfTwo (juce::jmax (1, maxDelaySamples) + 1) - 1;
+        numChannels = juce::jmax (1, numChannelsToUse);
+        ring = arena.take<SampleType> ((size_t) (numChannels * (mask + 1)));   // 数えるパスでは nullptr
+        delay = juce::jmin (delay, mask);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (ring != nullptr)
+            std::fill (ring, ring + numChannels * (mask + 1), SampleType (0));
+        writePos = 0;
+    }
+
+    void setDelay (int samples) noexcept { delay = juce::jlimit (0, mask, samples); }
+    int getDelay() const noexcept        { return delay; }
+
+    // in-place で [startSample, startSample + numSamples) を遅延させる
+    void process (SampleType* const* channels, int numChannelsToProcess, int startSample, int numSamples) noexcept
+    {
+        if (delay == 0 || ring == nullptr)
+            return;
+
+        const int chs = juce::jmin (numChannelsToProcess, numChannels);
+
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            auto* r = ring + ch * (mask + 1);
+            auto* d = channels[ch] + startSample;
+            int wp = writePos;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                r[wp] = d[i];
+                d[i] = r[(wp - delay) & mask];
+                wp = (wp + 1) & mask;
+            }
+        }
+
+        writePos = (writePos + numSamples) & mask;
+    }
+
+private:
+    SampleType* ring = nullptr;          // [ch][mask + 1]（ScratchArena の領域）
+    int numChannels = 0, mask = 0, writePos = 0, delay = 0;
+};
@@ -0,0 +1,243 @@
+#include "Saturation.h"
+
+#if defined (__AVX__)
+ #include <immintrin.h>
+ #define VOICEMODELER_SAT_AVX 1
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define VOICEMODELER_SAT_SSE 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define VOICEMODELER_SAT_NEON 1
+#endif
+
+#include <algorithm>
+
+namespace
+{
+    //==============================================================================
+    // 最小限のベクトル演算。カーネルはこの Ops 越しに書き、スカラ版と同じ式を共有する
+    struct ScalarOps
+    {
+        using V = float;
+        static constexpr int width = 1;
+
+        static V load (const float* p) noexcept       { return *p; }
+        static void store (float* p, V v) noexcept    { *p = v; }
+        static V set (float x) noexcept               { return x; }
+        static V add (V a, V b) noexcept              { return a + b; }
+        static V mul (V a, V b) noexcept              { return a * b; }
+        static V div (V a, V b) noexcept              { return a / b; }
+        static V min (V a, V b) noexcept              { return std::min (a, b); }
+        static V max (V a, V b) noexcept              { return std::max (a, b); }
+    };
+
+   #if VOICEMODELER_SAT_AVX
+    struct SimdOps
+    {
+        using V = __m256;
+        static constexpr int width = 8;
+
+        static V load (const float* p) noexcept       { return _mm256_loadu_ps (p); }
+        static void store (float* p, V v) noexcept    { _mm256_storeu_ps (p, v); }
+        static V set (float x) noexcept               { return _mm256_set1_ps (x); }
+        static V add (V a, V b) noexcept              { return _mm256_add_ps (a, b); }
+        static V mul (V a, V b) noexcept              { return _mm256_mul_ps (a, b); }
+        static V div (V a, V b) noexcept              { return _mm256_div_ps (a, b); }
+        static V min (V a, V b) noexcept              { return _mm256_min_ps (a, b); }
+        static V max (V a, V b) noexcept              { return _mm256_max_ps (a, b); }
+    };
+   #elif VOICEMODELER_SAT_SSE
+    struct SimdOps
+    {
+        using V = __m128;
+        static constexpr int width = 4;
+
+        static V load (const float* p) noexcept       { return _mm_loadu_ps (p); }
+        static void store (float* p, V v) noexcept    { _mm_storeu_ps (p, v); }
+        static V set (float x) noexcept               { return _mm_set1_ps (x); }
+        static V add (V a, V b) noexcept              { return _mm_add_ps (a, b); }
+        static V mul (V a, V b) noexcept              { return _mm_mul_ps (a, b); }
+        static V div (V a, V b) noexcept              { return _mm_div_ps (a, b); }
+        static V min (V a, V b) noexcept              { return _mm_min_ps (a, b); }
+        static V max (V a, V b) noexcept              { return _mm_max_ps (a, b); }
+    };
+   #elif VOICEMODELER_SAT_NEON
+    struct SimdOps
+    {
+        using V = float32x4_t;
+        static constexpr int width = 4;
+
+        static V load (const float* p) noexcept       { return vld1q_f32 (p); }
+        static void store (float* p, V v) noexcept    { vst1q_f32 (p, v); }
+        static V set (float x) noexcept               { return vdupq_n_f32 (x); }
+        static V add (V a, V b) noexcept              { return vaddq_f32 (a, b); }
+        static V mul (V a, V b) noexcept              { return vmulq_f32 (a, b); }
+        static V min (V a, V b) noexcept              { return vminq_f32 (a, b); }
+        static V max (V a, V b) noexcept              { return vmaxq_f32 (a, b); }
+
+        static V div (V a, V b) noexcept
+        {
+           #if defined (__aarch64__) || defined (_M_ARM64)
+            return vdivq_f32 (a, b);
+           #else
+            // ARMv7 には除算が無いので逆数推定 + Newton 2 回
+            auto r = vrecpeq_f32 (b);
+            r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+            r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+            return vmulq_f32 (a, r);
+           #endif
+        }
+    };
+   #else
+    using SimdOps = ScalarOps;
+   #endif
+
+    template <typename Ops>
+    typename Ops::V clamp (typename Ops::V x, float limit) noexcept
+    {
+        return Ops::min (Ops::max (x, Ops::set (-limit)), Ops::set (limit));
+    }
+
+    //==============================================================================
+    // tanh の近似（精度の表は Saturation.h）
+    struct TanhFast
+    {
+        template <typename Ops>
+        static typename Ops::V eval (typename Ops::V x) noexcept
+        {
+            x = clamp<Ops> (x, 3.0f);
+            const auto x2 = Ops::mul (x, x);
+            const auto num = Ops::mul (x, Ops::add (x2, Ops::set (27.0f)));
+            const auto den = Ops::add (Ops::mul (x2, Ops::set (9.0f)), Ops::set (27.0f));
+            return clamp<Ops> (Ops::div (num, den), 1.0f);
+        }
+    };
+
+    struct TanhBalanced
+    {
+        template <typename Ops>
+        static typename Ops::V eval (typename Ops::V x) noexcept
+        {
+            x = clamp<Ops> (x, 4.97178686f);
+            const auto x2 = Ops::mul (x, x);
+
+            auto num = Ops::add (x2, Ops::set (378.0f));
+            num = Ops::add (Ops::mul (num, x2), Ops::set (17325.0f));
+            num = Ops::mul (Ops::add (Ops::mul (num, x2), Ops::set (135135.0f)), x);
+
+            auto den = Ops::add (Ops::mul (x2, Ops::set (28.0f)), Ops::set (3150.0f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (62370.0f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (135135.0f));
+
+            return clamp<Ops> (Ops::div (num, den), 1.0f);
+        }
+    };
+
+    struct TanhAccurate
+    {
+        template <typename Ops>
+        static typename Ops::V eval (typename Ops::V x) noexcept
+        {
+            x = clamp<Ops> (x, 8.5f);
+            const auto x2 = Ops::mul (x, x);
+
+            auto num = Ops::add (Ops::mul (x2, Ops::set (3.8855558e-11f)), Ops::set (1.14449814e-07f));
+            num = Ops::add (Ops::mul (num, x2), Ops::set (4.28322776e-05f));
+            num = Ops::add (Ops::mul (num, x2), Ops::set (0.00444740595f));
+            num = Ops::add (Ops::mul (num, x2), Ops::set (0.141152627f));
+            num = Ops::mul (Ops::add (Ops::mul (num, x2), Ops::set (1.0f)), x);
+
+            auto den = Ops::add (Ops::mul (x2, Ops::set (3.07435374e-09f)), Ops::set (2.65620843e-06f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (0.000504977751f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (0.0292760599f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (0.47448596f));
+            den = Ops::add (Ops::mul (den, x2), Ops::set (1.0f));
+
+            return clamp<Ops> (Ops::div (num, den), 1.0f);
+        }
+    };
+
+    //==============================================================================
+    template <typename Tanh>
+    struct Plain
+    {
+        template <typename Ops>
+        static typename Ops::V apply (typename Ops::V x) noexcept { return Tanh::template eval<Ops> (x); }
+    };
+
+    template <typename Tanh>
+    struct RBass
+    {
+        // 0.6·2t/(1+t²) + 0.4·t = t·(1.2/(1+t²) + 0.4)、t = tanh(x/2)
+        template <typename Ops>
+        static typename Ops::V apply (typename Ops::V x) noexcept
+        {
+            const auto t = Tanh::template eval<Ops> (Ops::mul (x, Ops::set (0.5f)));
+            const auto k = Ops::div (Ops::set (1.2f), Ops::add (Ops::mul (t, t), Ops::set (1.0f)));
+            return Ops::mul (t, Ops::add (k, Ops::set (0.4f)));
+        }
+    };
+
+    template <typename Shape>
+    void run (const float* src, float* dst, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + SimdOps::width <= numSamples; i += SimdOps::width)
+            SimdOps::store (dst + i, Shape::template apply<SimdOps> (SimdOps::load (src + i)));
+
+        for (; i < numSamples; ++i)
+            dst[i] = Shape::template apply<ScalarOps> (src[i]);
+    }
+
+    template <typename Shape>
+    void run (const double* src, double* dst, int numSamples) noexcept
+    {
+        constexpr int chunk = 256;
+        float tmp[chunk];
+
+        for (int pos = 0; pos < numSamples; pos += chunk)
+        {
+            const int n = std::min (chunk, numSamples - pos);
+            for (int i = 0; i < n; ++i)
+                tmp[i] = (float) src[pos + i];
+
+            run<Shape> (tmp, tmp, n);
+
+            for (int i = 0; i < n; ++i)
+                dst[pos + i] = (double) tmp[i];
+        }
+    }
+
+    template <typename SampleType>
+    void runTanh (const SampleType* src, SampleType* dst, int numSamples, Saturation::Quality q) noexcept
+    {
+        switch (q)
+        {
+            case Saturation::Quality::fast:     run<Plain<TanhFast>>     (src, dst, numSamples); break;
+            case Saturation::Quality::balanced: run<Plain<TanhBalanced>> (src, dst, numSamples); break;
+            case Saturation::Quality::accurate: run<Plain<TanhAccurate>> (src, dst, numSamples); break;
+        }
+    }
+
+    template <typename SampleType>
+    void runRBass (SampleType* data, int numSamples, Saturation::Quality q) noexcept
+    {
+        switch (q)
+        {
+            case Saturation::Quality::fast:     run<RBass<TanhFast>>     (data, data, numSamples); break;
+            case Saturation::Quality::balanced: run<RBass<TanhBalanced>> (data, data, numSamples); break;
+            case Saturation::Quality::accurate: run<RBass<TanhAccurate>> (data, data, numSamples); break;
+        }
+    }
+}
+
+namespace Saturation
+{
+    void tanh (const float* src, float* dst, int numSamples, Quality q) noexcept   { runTanh (src, dst, numSamples, q); }
+    void tanh (const double* src, double* dst, int numSamples, Quality q) noexcept { runTanh (src, dst, numSamples, q); }
+
+    void rbassShape (float* data, int numSamples, Quality q) noexcept  { runRBass (data, numSamples, q); }
+    void rbassShape (double* data, int numSamples, Quality q) noexcept { runRBass (data, numSamples, q); }
+}
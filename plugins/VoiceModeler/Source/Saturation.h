@@ -0,0 +1,38 @@
+#pragma once
+
+// バッファ単位の tanh 系サチュレーション。
+// 有理近似（fast / balanced は Lambert 連分数の打ち切り、accurate は同じ次数のフィット）をクランプ付きで評価し、
+// AVX / SSE2 / NEON のいずれか（ビルド時に有効なもの）で 1 命令あたり複数サンプルを処理する。
+// 端数サンプルは同じ式のスカラ版で処理するので、経路による値の差は FMA 縮約の有無程度。
+//
+// 精度（|近似 − std::tanh|、ベンチと同じ ±12 の 2^22 点で float 評価した最大値。SSE2 / AVX2+FMA）：
+//   fast      x(27+x²)/(27+9x²)、|x|≤3 でクランプ（境界で傾き 0）   2.35e-2 / 2.35e-2
+//   balanced  [7/6] Padé、|x|≤4.97                                    9.61e-5 / 9.61e-5
+//             （FastMathApproximations::tanh と同じ式。範囲外でも 1 を超えない）
+//   accurate  [11/10] 有理近似、|x|≤8.5                               3.63e-7 / 3.03e-7
+//             （|x|≤8.5 でミニマックスに寄せた重み付き最小二乗。式の誤差は 2e-11 で、残りは float の丸め）
+namespace Saturation
+{
+    enum class Quality { fast, balanced, accurate };
+
+    // 上表の誤差上限（ベンチの検証モードが使う。どちらの ISA の実測も下回る値）
+    constexpr float maxError (Quality q) noexcept
+    {
+        return q == Quality::fast ? 2.4e-2f : q == Quality::balanced ? 1.0e-4f : 4.0e-7f;
+    }
+
+    // dst[i] = tanh (src[i])。src == dst の in-place 可
+    void tanh (const float* src, float* dst, int numSamples, Quality q) noexcept;
+
+    inline void tanh (float* data, int numSamples, Quality q) noexcept { tanh (data, data, numSamples, q); }
+
+    // RBass の倍音生成：0.6·tanh(x) + 0.4·tanh(x/2) を in-place で。
+    // t = tanh(x/2) から tanh(x) = 2t/(1+t²) を作るので、近似 tanh の評価は 1 回。
+    // 誤差は t の誤差の高々 1.6 倍（実測 fast 1.08e-2、balanced 3.85e-5、accurate 2.10e-7）。
+    void rbassShape (float* data, int numSamples, Quality q) noexcept;
+
+    // double コア用。近似自体が float 精度なので、短い区間ずつ float に落として同じカーネルを通す
+    void tanh (const double* src, double* dst, int numSamples, Quality q) noexcept;
+    inline void tanh (double* data, int numSamples, Quality q) noexcept { tanh (data, data, numSamples, q); }
+    void rbassShape (double* data, int numSamples, Quality q) noexcept;
+}
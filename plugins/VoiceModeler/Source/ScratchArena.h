@@ -0,0 +1,92 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// prepareToPlay でまとめて 1 回だけ確保する作業域。切り出す領域はすべて 64 バイト境界（SIMD・キャッシュライン）。
+//
+// 大きさはサンプルレート・ブロック長・チャンネル数・先読みの上限で決まるので、2 回のパスで割り付ける：
+//   1) 数えるパス：各部品の prepare が take<T>(n) を呼ぶ。大きさを足すだけで nullptr が返る
+//   2) allocate で合計を確保（足りていれば前の領域を使い回す）し、同じ順に prepare をもう一度呼ぶ
+// layout (fn) がこの 2 回をまとめて行う。部品は領域が nullptr の間は中身に触らないこと。
+// 切り出した領域はゼロで埋まっている。processBlock の間は何も確保しない。
+class ScratchArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    // fn（部品の prepare を呼ぶ）を数えるパスと割り付けるパスの 2 回呼ぶ
+    template <typename Fn>
+    void layout (Fn&& prepareAll)
+    {
+        measuring = true;
+        used = 0;
+        prepareAll();
+
+        allocate();
+        prepareAll();
+        jassert (used <= capacity);   // 2 回のパスで同じ大きさを取ること
+    }
+
+    template <typename T>
+    T* take (size_t count) noexcept
+    {
+        const size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        used = offset + count * sizeof (T);
+
+        if (measuring || count == 0 || used > capacity)
+            return nullptr;
+
+        return reinterpret_cast<T*> (base + offset);
+    }
+
+    // numChannels × numSamples を切り出して buffer に参照させる（チャンネルごとに 64 バイト境界）。
+    // 数えるパスでは buffer を空にする
+    template <typename SampleType>
+    void take (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
+    {
+        constexpr int maxViewChannels = 31;   // AudioBuffer が参照の配列を確保せずに持てる数
+        jassert (numChannels <= maxViewChannels);
+        numChannels = juce::jlimit (0, maxViewChannels, numChannels);
+
+        std::array<SampleType*, maxViewChannels> channels {};
+        bool complete = numChannels > 0 && numSamples > 0;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            channels[(size_t) ch] = take<SampleType> ((size_t) numSamples);
+            complete = complete && channels[(size_t) ch] != nullptr;
+        }
+
+        if (complete)
+            buffer.setDataToReferTo (channels.data(), numChannels, numSamples);
+        else
+            buffer.setDataToReferTo (channels.data(), 0, 0);
+    }
+
+    size_t getCapacityBytes() const noexcept { return capacity; }
+
+private:
+    void allocate()
+    {
+        measuring = false;
+
+        if (used > capacity)
+        {
+            storage.allocate (used + alignment, false);
+            capacity = used;
+            base = reinterpret_cast<char*> ((reinterpret_cast<std::uintptr_t> (storage.get()) + alignment - 1)
+                                            & ~(std::uintptr_t) (alignment - 1));
+        }
+
+        if (base != nullptr)
+            std::memset (base, 0, capacity);
+
+        used = 0;
+    }
+
+    juce::HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t capacity = 0, used = 0;
+    bool measuring = false;
+};
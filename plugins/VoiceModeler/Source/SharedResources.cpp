@@ -0,0 +1,142 @@
+#include "SharedResources.h"
+#include <cstring>
+
+namespace
+{
+    // float の仮数を 12 ビットに丸めた 21 ビット（正の値のみ）
+    constexpr int droppedBits = 23 - 12;
+
+    juce::uint32 quantise (double value) noexcept
+    {
+        const auto f = (float) juce::jmax (1.0e-30, value);
+        juce::uint32 bits;
+        std::memcpy (&bits, &f, sizeof (bits));
+        return (bits + (1u << (droppedBits - 1))) >> droppedBits;
+    }
+
+    double dequantise (juce::uint32 q) noexcept
+    {
+        const juce::uint32 bits = q << droppedBits;
+        float f;
+        std::memcpy (&f, &bits, sizeof (f));
+        return (double) f;
+    }
+
+    juce::uint64 mix (juce::uint64 x) noexcept
+    {
+        // splitmix64 の最終段
+        x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27; x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+}
+
+//==============================================================================
+CoefficientCache::CoefficientCache()
+: slots (new Slot[(size_t) numSlots])
+{
+    // 形 0 のキーは使わないので、空のスロットはどのキーにも一致しない
+    for (int i = 0; i < numSlots; ++i)
+    {
+        slots[(size_t) i].key[0].store (0);
+        slots[(size_t) i].key[1].store (0);
+        for (auto& c : slots[(size_t) i].coeffs)
+            c.store (0.0);
+    }
+}
+
+BiquadCoeffs CoefficientCache::get (Shape shape, double sampleRate, double freq, double q, double gainFactor) noexcept
+{
+    const auto qf = quantise (freq), qq = quantise (q), qg = quantise (gainFactor);
+    const juce::uint64 k0 = ((juce::uint64) shape << 32) | (juce::uint64) juce::roundToInt (sampleRate);
+    const juce::uint64 k1 = ((juce::uint64) qf << 42) | ((juce::uint64) qq << 21) | (juce::uint64) qg;
+
+    auto& slot = slots[(size_t) (mix (k0 * 0x9e3779b97f4a7c15ull ^ k1) & (juce::uint64) (numSlots - 1))];
+
+    // 読み：シーケンスが偶数のまま変わらず、キーが一致すればヒット
+    const auto seq = slot.sequence.load (std::memory_order_acquire);
+    if ((seq & 1u) == 0
+        && slot.key[0].load (std::memory_order_relaxed) == k0
+        && slot.key[1].load (std::memory_order_relaxed) == k1)
+    {
+        const BiquadCoeffs c { slot.coeffs[0].load (std::memory_order_relaxed), slot.coeffs[1].load (std::memory_order_relaxed),
+                               slot.coeffs[2].load (std::memory_order_relaxed), slot.coeffs[3].load (std::memory_order_relaxed),
+                               slot.coeffs[4].load (std::memory_order_relaxed) };
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (slot.sequence.load (std::memory_order_relaxed) == seq)
+            return c;
+    }
+
+    // ミス：量子化した値で計算
+    const auto c = compute (shape, sampleRate, dequantise (qf), dequantise (qq), dequantise (qg));
+
+    // 書き：スロットを取れたときだけ（他のスレッドが書いている最中なら諦める）
+    auto expected = slot.sequence.load (std::memory_order_relaxed);
+    if ((expected & 1u) == 0
+        && slot.sequence.compare_exchange_strong (expected, expected + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+        std::atomic_thread_fence (std::memory_order_release);
+        slot.key[0].store (k0, std::memory_order_relaxed);
+        slot.key[1].store (k1, std::memory_order_relaxed);
+        slot.coeffs[0].store (c.b0, std::memory_order_relaxed);
+        slot.coeffs[1].store (c.b1, std::memory_order_relaxed);
+        slot.coeffs[2].store (c.b2, std::memory_order_relaxed);
+        slot.coeffs[3].store (c.a1, std::memory_order_relaxed);
+        slot.coeffs[4].store (c.a2, std::memory_order_relaxed);
+        slot.sequence.store (expected + 2, std::memory_order_release);
+    }
+
+    return c;
+}
+
+BiquadCoeffs CoefficientCache::compute (Shape shape, double sampleRate, double freq, double q, double gainFactor) noexcept
+{
+    switch (shape)
+    {
+        case Shape::peak:     return BiquadDesign::peak (sampleRate, freq, q, gainFactor);
+        case Shape::bandPass: return BiquadDesign::bandPass (sampleRate, freq, q);
+        case Shape::highPass: return BiquadDesign::highPass (sampleRate, freq, q);
+        case Shape::lowPass:  return BiquadDesign::lowPass (sampleRate, freq, q);
+    }
+
+    return {};
+}
+
+//==============================================================================
+std::shared_ptr<const std::vector<float>> SharedResources::getWindow (Window shape, int length)
+{
+    const std::lock_guard<std::mutex> guard (lock);
+
+    auto& entry = windows[{ (int) shape, length }];
+    if (auto existing = entry.lock())
+        return existing;
+
+    auto table = std::make_shared<std::vector<float>> ((size_t) length);
+    for (int i = 0; i < length; ++i)
+    {
+        (*table)[(size_t) i] = shape == Window::hannPeriodic
+            ? 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) length)
+            : 0.54f - 0.46f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) juce::jmax (1, length - 1));
+    }
+
+    entry = table;
+    return table;
+}
+
+SharedResources::Usage SharedResources::getUsage() const
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    Usage usage;
+
+    for (auto& [key, entry] : windows)
+    {
+        if (auto table = entry.lock())
+        {
+            ++usage.numWindows;
+            usage.bytes += table->size() * sizeof (float);
+        }
+    }
+
+    return usage;
+}
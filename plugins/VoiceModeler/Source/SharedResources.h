@@ -0,0 +1,68 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "BiquadCoefficients.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// 量子化した (形, サンプルレート, 周波数, Q, ゲイン) をキーにした biquad 係数のキャッシュ。
+// 全インスタンスのオーディオスレッドから同時に読み書きする、ロックなしの直接写像テーブル
+// （スロットごとのシーケンスロック。書き込みが競合したら書かずに諦め、読みが競合したらミス扱いで計算する）。
+// 係数は量子化した値から計算するので、ヒットしてもミスしても結果は同じ。
+// 周波数・Q・ゲイン倍率は float の仮数を 12 ビットに丸める（相対 0.025 %：周波数で約 0.4 セント、ゲインで約 0.002 dB）。
+class CoefficientCache
+{
+public:
+    enum class Shape : juce::uint32 { peak = 1, bandPass, highPass, lowPass };
+
+    CoefficientCache();
+
+    BiquadCoeffs get (Shape shape, double sampleRate, double freq, double q, double gainFactor = 1.0) noexcept;
+
+    // キャッシュを通さない計算（BiquadDesign の各関数。量子化もしない）
+    static BiquadCoeffs compute (Shape shape, double sampleRate, double freq, double q, double gainFactor = 1.0) noexcept;
+
+private:
+    static constexpr int numSlots = 4096;
+
+    struct alignas (64) Slot
+    {
+        std::atomic<juce::uint32> sequence { 0 };   // 奇数の間は書き込み中
+        std::atomic<juce::uint64> key[2];
+        std::atomic<double> coeffs[5];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+
+    JUCE_DECLARE_NON_COPYABLE (CoefficientCache)
+};
+
+// プロセス内の全インスタンスで共有するリソース（juce::SharedResourcePointer で参照カウント）。
+//   ・窓テーブル（Hann 周期版／Hamming）：種類と長さごとに 1 つ。使っているインスタンスがなくなれば解放
+//   ・biquad 係数のキャッシュ（CoefficientCache）
+// 取得（getWindow）は prepare の間だけ（ロックを取る）。受け取ったテーブルは変更されないので、
+// オーディオスレッドはロックなしでそのまま読む。
+//
+// FFT は共有しない。JUCE の fallback エンジンは perform の中で SpinLock を取り（作業域をエンジン内に持つ）、
+// IPP も作業域をエンジン内に持つので、共有するとインスタンスのオーディオスレッドどうしと線形位相 EQ の
+// 読み込み側が同じロックを取り合う。FFT を使う部品はそれぞれ自分のスレッド用に持つ。
+class SharedResources
+{
+public:
+    enum class Window { hannPeriodic, hammingSymmetric };
+
+    std::shared_ptr<const std::vector<float>> getWindow (Window shape, int length);
+    CoefficientCache& getCoefficientCache() noexcept    { return coefficientCache; }
+
+    // ベンチ用：いま生きている共有テーブルの数とバイト数
+    struct Usage { int numWindows = 0; size_t bytes = 0; };
+    Usage getUsage() const;
+
+private:
+    mutable std::mutex lock;
+    std::map<std::pair<int, int>, std::weak_ptr<const std::vector<float>>> windows;
+    CoefficientCache coefficientCache;
+};
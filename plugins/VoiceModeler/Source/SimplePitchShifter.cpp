@@ -1,2 +1,276 @@
 #include "SimplePitchShifter.h"
-// 実装はヘッダ内。将来の拡張用に .cpp を用意。
+
+void SimplePitchShifter::prepare (double sampleRate, int maxBlock, int numChannels, ScratchArena& arena)
+{
+    sr = sampleRate;
+    channels = juce::jmax (1, numChannels);
+    maxBlockSize = juce::jmax (1, maxBlock);
+
+    window = resources->getWindow (SharedResources::Window::hannPeriodic, windowTableSize);
+
+    // delay：窓 20 ms、遅延は平均でその半分
+    windowSize = juce::jmax (64, juce::roundToInt (sampleRate * 0.02));
+
+    // psola：70 Hz までの周期を扱い、粒の末尾が常に書き込み済みになるだけ遅らせる
+    maxPeriod    = juce::roundToInt (sampleRate / 70.0);
+    psolaLatency = (5 * maxPeriod + 1) / 2 + 2;
+    hopSize      = juce::jmax (32, juce::roundToInt (sampleRate * 0.005));
+
+    // 周期推定は 12 kHz 前後に間引いて行う（60 Hz〜500 Hz）
+    decimation   = juce::jmax (1, juce::roundToInt (sampleRate / 12000.0));
+    const double decRate = sampleRate / decimation;
+    minLag       = juce::jmax (2, (int) (decRate / 500.0));
+    maxLag       = (int) std::ceil (decRate / 60.0);
+    yinWindow    = maxLag;
+    lowpassCoeff = 1.0f - std::exp (-juce::MathConstants<float>::twoPi * 1500.0f / (float) sampleRate);
+
+    ringLen = juce::nextPowerOfTwo (juce::jmax (windowSize + 2,
+                                                psolaLatency + 2 * maxPeriod + 2,
+                                                (yinWindow + maxLag + 2) * decimation));
+    mask = ringLen - 1;
+
+    // 数えるパスではどれも nullptr（process は何もしない）
+    ring      = arena.take<float> ((size_t) (channels * ringLen));
+    psolaOut  = arena.take<float> ((size_t) (channels * ringLen));
+    pitchRing = arena.take<float> ((size_t) ringLen);
+    tapDelay  = arena.take<float> ((size_t) (4 * maxBlockSize));
+    yinFrame  = arena.take<float> ((size_t) (yinWindow + maxLag + 2));
+    yinDiff   = arena.take<float> ((size_t) (maxLag + 2));
+
+    reset();
+}
+
+void SimplePitchShifter::reset() noexcept
+{
+    if (ring != nullptr)
+    {
+        std::fill (ring, ring + channels * ringLen, 0.0f);
+        std::fill (psolaOut, psolaOut + channels * ringLen, 0.0f);
+        std::fill (pitchRing, pitchRing + ringLen, 0.0f);
+    }
+
+    writePos = 0;
+    phase = 0.0f;
+
+    inputTime = 0;
+    period = juce::roundToInt (sr / 150.0);
+    nextGrainOut = (double) period;
+    analysisMark = nextGrainOut - psolaLatency;
+    lowpassState = 0.0f;
+    hopCounter = 0;
+}
+
+template <typename SampleType>
+void SimplePitchShifter::process (SampleType* const* data, int numChannelsToProcess, int startSample, int numSamples) noexcept
+{
+    if (ring == nullptr)
+        return;
+
+    const int chs = juce::jmin (numChannelsToProcess, channels);
+
+    if (mode == Mode::delay)
+    {
+        for (int pos = 0; pos < numSamples; pos += maxBlockSize)
+            processDelay (data, chs, startSample + pos, juce::jmin (maxBlockSize, numSamples - pos));
+    }
+    else
+    {
+        processPsola (data, chs, startSample, numSamples);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void SimplePitchShifter::processDelay (SampleType* const* data, int chs, int startSample, int numSamples) noexcept
+{
+    // 制御値をブロック分まとめて作る（全チャンネル共通）
+    // 遅延 d = phase × 窓長 が (1 − ratio) の速さで動くので、読み出し速度は ratio
+    auto* dA = tapDelay;
+    auto* dB = dA + maxBlockSize;
+    auto* gA = dB + maxBlockSize;
+    auto* gB = gA + maxBlockSize;
+
+    const float inc = (1.0f - ratio) / (float) windowSize;
+    const float w = (float) windowSize;
+    const auto* win = window->data();
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float pB = phase < 0.5f ? phase + 0.5f : phase - 0.5f;
+        dA[i] = phase * w;
+        dB[i] = pB * w;
+
+        // Hann は半周期ずらすと和が 1 になるので、B の重みは 1 − A
+        const float t = phase * (float) windowTableSize;
+        const int k = juce::jmin (windowTableSize - 1, (int) t);
+        const float w0 = win[k], w1 = win[(k + 1) & (windowTableSize - 1)];
+        gA[i] = w0 + (t - (float) k) * (w1 - w0);
+        gB[i] = 1.0f - gA[i];
+
+        phase += inc;
+        phase -= std::floor (phase);
+    }
+
+    const float ringOffset = (float) ringLen;
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        auto* r  = ringFor (ch);
+        auto* io = data[ch] + startSample;
+        int wp = writePos;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            r[wp] = (float) io[i];
+
+            // 読み位置は常に正（+ringLen）にしてから切り捨て、マスクで巻き戻す
+            const float posA = (float) wp - dA[i] + ringOffset;
+            const float posB = (float) wp - dB[i] + ringOffset;
+            const int iA = (int) posA, iB = (int) posB;
+            const float fA = posA - (float) iA, fB = posB - (float) iB;
+
+            const float a0 = r[iA & mask], a1 = r[(iA + 1) & mask];
+            const float b0 = r[iB & mask], b1 = r[(iB + 1) & mask];
+
+            io[i] = (SampleType) (gA[i] * (a0 + fA * (a1 - a0)) + gB[i] * (b0 + fB * (b1 - b0)));
+            wp = (wp + 1) & mask;
+        }
+    }
+
+    writePos = (writePos + numSamples) & mask;
+}
+
+//==============================================================================
+template <typename SampleType>
+void SimplePitchShifter::processPsola (SampleType* const* data, int chs, int startSample, int numSamples) noexcept
+{
+    const float invChs = 1.0f / (float) chs;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        writePos = (int) (inputTime & mask); // 粒は絶対時刻でリングを引く
+
+        // 入力を書き込み、周期推定用にローパスしたモノ和も残す
+        float sum = 0.0f;
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            const float x = (float) data[ch][startSample + i];
+            ringFor (ch)[writePos] = x;
+            sum += x;
+        }
+
+        lowpassState += lowpassCoeff * (sum * invChs - lowpassState);
+        pitchRing[writePos] = lowpassState;
+
+        if (++hopCounter >= hopSize)
+        {
+            hopCounter = 0;
+            estimatePeriod();
+        }
+
+        // 先頭が次の出力サンプルに届いた粒を配置（粒の長さは 2 周期）
+        const auto now = inputTime;
+        while ((juce::int64) std::llround (nextGrainOut) - period <= now)
+        {
+            const auto centreOut = (juce::int64) std::llround (nextGrainOut);
+            const double target = (double) centreOut - psolaLatency;
+
+            // 解析マークは周期ずつ進めて、目標に最も近いものを使う（ratio > 1 は同じ粒の再利用、< 1 は間引き）
+            for (int k = 0; k < 4 && analysisMark + 0.5 * period < target; ++k)
+                analysisMark += period;
+            if (analysisMark > target + 0.5 * period || analysisMark < target - period)
+                analysisMark = target; // 周期が大きく変わったときは再同期（粒の末尾が未来に出ないように）
+
+            placeGrain (chs, centreOut, (juce::int64) std::llround (analysisMark), period);
+            nextGrainOut += (double) period / (double) ratio;
+        }
+
+        // 出力（重畳加算済みの位置を読んでクリア）
+        const int op = (int) (now & mask);
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            auto* o = outFor (ch);
+            data[ch][startSample + i] = (SampleType) o[op];
+            o[op] = 0.0f;
+        }
+
+        ++inputTime;
+    }
+}
+
+template void SimplePitchShifter::process<float>  (float* const*,  int, int, int) noexcept;
+template void SimplePitchShifter::process<double> (double* const*, int, int, int) noexcept;
+
+void SimplePitchShifter::placeGrain (int chs, juce::int64 centreOut, juce::int64 centreIn, int grainPeriod) noexcept
+{
+    // Hann（長さ 2P）を P / ratio 間隔で重ねると窓の和は ratio になるので 1/ratio で正規化
+    const int len = 2 * grainPeriod;
+    const float gain = 1.0f / ratio;
+
+    // 既に出力済みの位置（周期が急に伸びた場合）は書かない
+    const int first = (int) juce::jmax ((juce::int64) 0, inputTime - (centreOut - grainPeriod));
+
+    const auto outStart = centreOut - grainPeriod;
+    const auto inStart  = centreIn - grainPeriod;
+
+    const auto* win = window->data();
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        const auto* r = ringFor (ch);
+        auto* o = outFor (ch);
+
+        for (int j = first; j < len; ++j)
+        {
+            const float w = win[(j * windowTableSize) / len];
+            o[(int) ((outStart + j) & mask)] += gain * w * r[(int) ((inStart + j) & mask)];
+        }
+    }
+}
+
+void SimplePitchShifter::estimatePeriod() noexcept
+{
+    // 直近 (yinWindow + maxLag) 点を間引いて取り出す
+    const int n = yinWindow + maxLag;
+    auto* x = yinFrame;
+    for (int j = 0; j < n; ++j)
+        x[j] = pitchRing[(writePos - (n - 1 - j) * decimation) & mask];
+
+    // YIN：差分関数 → 累積平均正規化 → 閾値を下回った最初の谷
+    auto* d = yinDiff;
+    d[0] = 1.0f;
+    float running = 0.0f;
+    int best = -1;
+
+    for (int tau = 1; tau <= maxLag; ++tau)
+    {
+        float acc = 0.0f;
+        for (int j = 0; j < yinWindow; ++j)
+        {
+            const float diff = x[j] - x[j + tau];
+            acc += diff * diff;
+        }
+
+        running += acc;
+        d[tau] = running > 0.0f ? acc * (float) tau / running : 1.0f;
+
+        if (best < 0 && tau > minLag && d[tau - 1] < 0.15f && d[tau] >= d[tau - 1])
+            best = tau - 1;
+    }
+
+    // 無声（谷なし）のときは直前の周期のまま。粒の並べ替えは通常の OLA と同じ振る舞いになる
+    if (best < 0)
+        return;
+
+    // 放物線補間で小数ラグ
+    float lag = (float) best;
+    if (best > 1 && best < maxLag)
+    {
+        const float a = d[best - 1], b = d[best], c = d[best + 1];
+        const float den = a - 2.0f * b + c;
+        if (den > 0.0f)
+            lag += 0.5f * (a - c) / den;
+    }
+
+    period = juce::jlimit (8, maxPeriod, juce::roundToInt (lag * (float) decimation));
+}
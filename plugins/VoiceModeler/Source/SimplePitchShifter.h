@@ -1,114 +1,77 @@
 #pragma once
 #include <juce_dsp/juce_dsp.h>
-
-// 軽量・低遅延な簡易ピッチシフタ（2タップ＋クロスフェード）
-// 高品位化したい場合は RubberBand / PSOLA 等に差し替え可能
+#include "ScratchArena.h"
+#include "SharedResources.h"
+#include <vector>
+
+// ピッチシフタ（2 モード）
+//  delay : 2 タップ可変遅延＋Hann クロスフェード。軽量・低遅延（窓長の半分 ≒ 10 ms）。
+//          フォルマントもピッチと一緒に動く。
+//  psola : 基本周期を YIN で推定し、周期同期の粒（2 周期ぶんの Hann 窓）を
+//          出力側で「周期 / ratio」間隔に並べ直す TD-PSOLA。粒の中身＝フォルマントは保たれる。
+//          遅延は最長周期（70 Hz）の 2.5 倍。
+//
+// 窓は共有テーブル（SharedResources）を引き、リングは 2 のべき乗長のマスクで巻き戻す（分岐なし）。
+// リングと作業域はすべて prepare で ScratchArena から切り出し、処理中は確保しない。
 class SimplePitchShifter
 {
 public:
-    void prepare (double sampleRate, int maxBlock, int numChannels,
-                  int windowSizeSamples = 1024)
-    {
-        juce::ignoreUnused (maxBlock);
-
-        sr = sampleRate;
-        channels = numChannels;
-        windowSize = juce::jmax (256, windowSizeSamples);
-        bufLen = juce::nextPowerOfTwo (windowSize * 8);
-
-        buffer.setSize (channels, bufLen);
-        buffer.clear();
-        writePos = 0;
-
-        phaseA = 0.0f;
-        phaseB = 0.5f;
+    enum class Mode { delay, psola };
 
-        setSemitone (0.0f);
-    }
+    void prepare (double sampleRate, int maxBlock, int numChannels, ScratchArena& arena);
+    void reset() noexcept;
 
-    void reset()
-    {
-        buffer.clear();
-        writePos = 0;
-        phaseA = 0.0f;
-        phaseB = 0.5f;
-    }
+    // モード変更時は reset() も呼ぶこと
+    void setMode (Mode newMode) noexcept { mode = newMode; }
+    Mode getMode() const noexcept        { return mode; }
 
     // 半音指定（例：+7, -5 など）
-    void setSemitone (float semi)
-    {
-        ratio = std::pow (2.0f, semi / 12.0f);
-        readSpeed = 1.0f / ratio; // 読み速度（原音=1.0）
-    }
+    void setSemitone (float semi) noexcept { ratio = std::pow (2.0f, semi / 12.0f); }
 
-    // in-placeで処理（ステレオ想定）
-    void process (juce::AudioBuffer<float>& block)
-    {
-        const int numSamples = block.getNumSamples();
-        const int chs = juce::jmin (channels, block.getNumChannels());
+    int getLatencySamples() const noexcept { return mode == Mode::delay ? windowSize / 2 : psolaLatency; }
+    int getMaxLatencySamples() const noexcept { return juce::jmax (windowSize / 2, psolaLatency); }
 
-        for (int i = 0; i < numSamples; ++i)
-        {
-            // 書き込み
-            for (int ch = 0; ch < chs; ++ch)
-                buffer.setSample (ch, writePos, block.getSample (ch, i));
+    // in-place で [startSample, startSample + numSamples) を処理（float / double。内部は float）
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannelsToProcess, int startSample, int numSamples) noexcept;
 
-            // 2本の読み取りタップ（0.5位相ずれ）
-            float posA = getReadPosFromPhase (phaseA);
-            float posB = getReadPosFromPhase (phaseB);
-
-            float wA = hannWindow (phaseA);
-            float wB = hannWindow (phaseB);
-
-            for (int ch = 0; ch < chs; ++ch)
-            {
-                float a = readInterp (ch, posA);
-                float b = readInterp (ch, posB);
-                block.setSample (ch, i, a * wA + b * wB);
-            }
+private:
+    static constexpr int windowTableSize = 1024;
 
-            // 位相を進める
-            phaseA += readSpeed / (float)windowSize;
-            phaseB += readSpeed / (float)windowSize;
-            if (phaseA >= 1.0f) phaseA -= 1.0f;
-            if (phaseB >= 1.0f) phaseB -= 1.0f;
+    template <typename SampleType>
+    void processDelay (SampleType* const* channels, int chs, int startSample, int numSamples) noexcept;
+    template <typename SampleType>
+    void processPsola (SampleType* const* channels, int chs, int startSample, int numSamples) noexcept;
+    void estimatePeriod() noexcept;
+    void placeGrain (int chs, juce::int64 centreOut, juce::int64 centreIn, int period) noexcept;
 
-            // 書きポインタ前進（リング）
-            writePos = (writePos + 1) & (bufLen - 1);
-        }
-    }
+    float* ringFor (int ch) noexcept   { return ring + ch * ringLen; }
+    float* outFor (int ch) noexcept    { return psolaOut + ch * ringLen; }
 
-private:
-    juce::AudioBuffer<float> buffer;
-    int bufLen = 0, writePos = 0, windowSize = 1024, channels = 2;
+    Mode mode = Mode::delay;
     double sr = 48000.0;
-
     float ratio = 1.0f;
-    float readSpeed = 1.0f;
-    float phaseA = 0.0f, phaseB = 0.5f;
-
-    inline float getReadPosFromPhase (float p) const noexcept
-    {
-        float offset = p * (float)windowSize;
-        float rp = (float)writePos - offset;
-        while (rp < 0.0f) rp += (float)bufLen;
-        while (rp >= (float)bufLen) rp -= (float)bufLen;
-        return rp;
-    }
-
-    inline float hannWindow (float p) const noexcept
-    {
-        return 0.5f * (1.0f - std::cos (2.0f * juce::MathConstants<float>::pi * p));
-    }
-
-    inline float readInterp (int ch, float pos) const noexcept
-    {
-        int i0 = (int)pos;
-        int i1 = (i0 + 1) & (bufLen - 1);
-        float frac = pos - (float)i0;
-
-        float s0 = buffer.getSample (ch, i0);
-        float s1 = buffer.getSample (ch, i1);
-        return s0 + (s1 - s0) * frac;
-    }
+    int channels = 2;
+
+    juce::SharedResourcePointer<SharedResources> resources;
+    std::shared_ptr<const std::vector<float>> window; // Hann（周期版）テーブル
+    float* ring = nullptr;             // 入力リング [ch][ringLen]（ここから下の配列は ScratchArena の領域）
+    int ringLen = 0, mask = 0, writePos = 0;
+
+    // delay モード
+    float* tapDelay = nullptr;         // ブロック内の制御値 [A 遅延, B 遅延, A 重み, B 重み] × maxBlock
+    int maxBlockSize = 0, windowSize = 960;
+    float phase = 0.0f;
+
+    // psola モード
+    float* psolaOut = nullptr;         // 重畳加算リング [ch][ringLen]
+    float* pitchRing = nullptr;        // 周期推定用（ローパス済みモノ）
+    float* yinFrame = nullptr;
+    float* yinDiff = nullptr;
+    juce::int64 inputTime = 0;         // 書き込んだサンプル数（絶対時刻）
+    double nextGrainOut = 0.0, analysisMark = 0.0;
+    float lowpassState = 0.0f, lowpassCoeff = 0.2f;
+    int decimation = 4, minLag = 24, maxLag = 172, yinWindow = 172;
+    int hopSize = 240, hopCounter = 0;
+    int period = 400, maxPeriod = 686, psolaLatency = 1716;
 };
@@ -0,0 +1,83 @@
+#include "Telemetry.h"
+
+TelemetryCollector::~TelemetryCollector()
+{
+    stopTimer();
+    stopCsv();
+}
+
+void TelemetryCollector::startCollecting()
+{
+    if (! isTimerRunning())
+        startTimerHz (30);
+}
+
+void TelemetryCollector::resetPeaks() noexcept
+{
+    peakLoad = 0.0f;
+    peakBlockMs = 0.0f;
+    overloads = 0;
+}
+
+bool TelemetryCollector::startCsv (const juce::File& file)
+{
+    stopCsv();
+
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream> (file);
+    if (! stream->openedOk())
+        return false;
+
+    stream->writeText (csvHeader(), false, false, nullptr);
+    csv = std::move (stream);
+    csvFile = file;
+
+    startCollecting();
+    return true;
+}
+
+void TelemetryCollector::stopCsv()
+{
+    if (csv != nullptr)
+        csv->flush();
+
+    csv.reset();
+}
+
+juce::String TelemetryCollector::csvHeader()
+{
+    return "sample_pos,wall_ms,num_samples,block_ms,load,peak_in_db,rms_in_db,peak_out_db,rms_out_db,gr_db,rbass_rms_db,idle,bypassed\n";
+}
+
+juce::String TelemetryCollector::toCsvRow (const TelemetrySnapshot& s)
+{
+    const auto db = [] (float g) { return juce::String (juce::Decibels::gainToDecibels (g, -120.0f), 2); };
+
+    return juce::String (s.samplePosition) + ","
+         + juce::String (s.wallMs, 3) + ","
+         + juce::String (s.numSamples) + ","
+         + juce::String (s.blockMs, 4) + ","
+         + juce::String (s.load, 4) + ","
+         + db (s.peakIn) + "," + db (s.rmsIn) + ","
+         + db (s.peakOut) + "," + db (s.rmsOut) + ","
+         + juce::String (s.gainReductionDb, 2) + ","
+         + db (s.rbassRms) + ","
+         + (s.idle ? "1" : "0") + "," + (s.bypassed ? "1" : "0") + "\n";
+}
+
+void TelemetryCollector::timerCallback()
+{
+    TelemetrySnapshot s;
+
+    while (fifo.pop (s))
+    {
+        latest = s;
+        peakLoad    = juce::jmax (peakLoad, s.load);
+        peakBlockMs = juce::jmax (peakBlockMs, s.blockMs);
+        if (s.load > 1.0f)
+            ++overloads;
+
+        if (csv != nullptr)
+            csv->writeText (toCsvRow (s), false, false, nullptr);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_events/juce_events.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+// ブロックごとの計測値（オーディオスレッドが 1 ブロック 1 個 push する）
+struct TelemetrySnapshot
+{
+    juce::int64 samplePosition = 0;  // このブロック先頭までに処理したサンプル数
+    double wallMs = 0.0;             // Time::getMillisecondCounterHiRes()
+    int numSamples = 0;
+    float blockMs = 0.0f;            // processBlock の所要時間
+    float load = 0.0f;               // 所要時間 / ブロックの実時間（1 を超えたら間に合っていない）
+    float peakIn = 0.0f,  rmsIn = 0.0f;
+    float peakOut = 0.0f, rmsOut = 0.0f;
+    float gainReductionDb = 0.0f;    // リミッター段（≤ 0）
+    float rbassRms = 0.0f;           // RBass で足した成分の RMS
+    bool idle = false;               // 無音入力でウェット処理を省いた
+    bool bypassed = false;           // バイパス中（クロスフェード中を含む）
+};
+
+// オーディオスレッド → メッセージスレッドの SPSC リング（AbstractFifo、ロック・確保なし）。
+// 満杯のときは捨てて数えるだけで、オーディオスレッドは待たない。
+class TelemetryFifo
+{
+public:
+    static constexpr int capacity = 1024;
+
+    bool push (const TelemetrySnapshot& s) noexcept
+    {
+        const auto scope = fifo.write (1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = s;
+        return true;
+    }
+
+    bool pop (TelemetrySnapshot& s) noexcept
+    {
+        const auto scope = fifo.read (1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        s = slots[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+        return true;
+    }
+
+    int getNumDropped() const noexcept { return dropped.load (std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<TelemetrySnapshot, capacity> slots {};
+    std::atomic<int> dropped { 0 };
+};
+
+// メッセージスレッド側：リングを定期的に吸い出し、最新値とピークホールドを保持。
+// CSV ログ中は全ブロックを 1 行ずつ書き出す（エディタを閉じても続く）。
+class TelemetryCollector : private juce::Timer
+{
+public:
+    explicit TelemetryCollector (TelemetryFifo& source) : fifo (source) {}
+    ~TelemetryCollector() override;
+
+    // エディタ／ログ開始時に呼ぶ（メッセージスレッド）
+    void startCollecting();
+
+    const TelemetrySnapshot& getLatest() const noexcept { return latest; }
+    float getPeakLoad() const noexcept                  { return peakLoad; }
+    float getPeakBlockMs() const noexcept               { return peakBlockMs; }
+    int getNumOverloads() const noexcept                { return overloads; }
+    int getNumDropped() const noexcept                  { return fifo.getNumDropped(); }
+    void resetPeaks() noexcept;
+
+    bool startCsv (const juce::File& file);
+    void stopCsv();
+    bool isLoggingCsv() const noexcept { return csv != nullptr; }
+    juce::File getCsvFile() const      { return csvFile; }
+
+    static juce::String csvHeader();
+    static juce::String toCsvRow (const TelemetrySnapshot&);
+
+private:
+    void timerCallback() override;
+
+    TelemetryFifo& fifo;
+    TelemetrySnapshot latest;
+    float peakLoad = 0.0f, peakBlockMs = 0.0f;
+    int overloads = 0;
+
+    std::unique_ptr<juce::FileOutputStream> csv;
+    juce::File csvFile;
+
+    JUCE_DECLARE_NON_COPYABLE (TelemetryCollector)
+};
@@ -0,0 +1,560 @@
+// VoiceModeler オフライン一括レンダラ
+// プリセット（getStateInformation が出す apvts の XML、またはそのバイナリ）を読み込み、
+// WAV / FLAC / AIFF を VoiceModelerAudioProcessor に大きなブロックで流して書き出す。
+// ワーカースレッドごとにプロセッサを 1 個ずつ持ち、ファイル単位で並列に処理する。
+//
+//   VoiceModelerBatch --out=dir [--preset=preset.xml] [--threads=N] [--block=65536]
+//                     [--format=same|wav|flac|aiff] [--bits=24] [--set=pitchSemis=2,...]
+//                     [--automation=curves.txt] [--mmap] [--verbose] <file or dir> ...
+//
+// ・入力は AudioFormatReader で block ずつ読むだけなので、何 GB のファイルでも全体は読み込まない
+//   （--mmap を付けると WAV / AIFF はメモリマップで読む）。出力も block ずつ書く。
+// ・プラグインのレイテンシ分は先頭を捨て、末尾はゼロを流して吐き出させる（出力長＝入力長）。
+// ・--automation：1 行 1 点「秒, パラメータ ID, 実値」のオートメーション（点の間は直線）。
+//   サンプル精度の対象は processBlock の直前に曲線をキューへ積み（pushAutomationCurve）、それ以外はブロック先頭で設定。
+// ・ディレクトリは再帰的に探し、相対パスを保ったまま --out 以下に書く。
+//   書き込みは一時ファイル経由なので、失敗しても途中までのファイルは残らない。
+// 最後に合計の音声長 / 経過時間（x-realtime）を表示。失敗したファイルがあれば終了コード 1。
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    struct JobResult
+    {
+        bool ok = false;
+        juce::String error;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+    };
+
+    // オートメーションの 1 パラメータぶん：時刻順の (秒, 実値)。点の間は直線で結び、両端の外は端の値
+    struct AutomationLane
+    {
+        juce::String paramID;
+        std::vector<std::pair<double, float>> points;
+
+        float valueAt (double seconds) const noexcept
+        {
+            const auto next = std::upper_bound (points.begin(), points.end(), seconds,
+                                                [] (double t, const std::pair<double, float>& p) { return t < p.first; });
+            if (next == points.begin())  return points.front().second;
+            if (next == points.end())    return points.back().second;
+
+            const auto& a = *(next - 1);
+            const auto& b = *next;
+            const double w = (seconds - a.first) / juce::jmax (1.0e-12, b.first - a.first);
+            return (float) (a.second + w * (b.second - a.second));
+        }
+    };
+
+    struct BatchOptions
+    {
+        juce::MemoryBlock preset;    // setStateInformation にそのまま渡す形
+        juce::String settings;       // "paramID=値,..."（プリセットの後に上書き）
+        juce::String format = "same";
+        int bitDepth = 0;            // 0：入力と同じ
+        int blockSize = 65536;
+        bool memoryMapped = false;
+        std::vector<AutomationLane> automation;
+    };
+
+    // オートメーションがあるときの processBlock 1 回の長さ。キュー（パラメータあたり 256 点）にも、
+    // 区間数の上限（16）にも届かない長さに刻む（区間は 64 サンプル程度の細かさになる）
+    constexpr int automationSlice = 1024;
+
+    // --set の "id=value" をパラメータの実値として設定（Bench と同じ書式）
+    void applySettings (VoiceModelerAudioProcessor& proc, const juce::String& settings)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens (settings, ",", "");
+
+        for (auto& t : tokens)
+        {
+            const auto id = t.upToFirstOccurrenceOf ("=", false, false).trim();
+            if (auto* p = proc.apvts.getParameter (id))
+                p->setValueNotifyingHost (p->convertTo0to1 (t.fromFirstOccurrenceOf ("=", false, false).getFloatValue()));
+            else if (id.isNotEmpty())
+                std::fprintf (stderr, "unknown parameter: %s\n", id.toRawUTF8());
+        }
+    }
+
+    // XML ならバイナリ化（copyXmlToBinary）、それ以外は getStateInformation の出力とみなす
+    bool loadPreset (const juce::File& file, juce::MemoryBlock& dest)
+    {
+        if (auto xml = juce::parseXML (file))
+        {
+            juce::AudioProcessor::copyXmlToBinary (*xml, dest);
+            return true;
+        }
+
+        return file.loadFileAsData (dest) && dest.getSize() > 0;
+    }
+
+    // 「秒, ID, 実値」（カンマ・空白区切り、# 以降はコメント）を読んでパラメータごとにまとめる
+    bool loadAutomation (const juce::File& file, std::vector<AutomationLane>& lanes)
+    {
+        juce::StringArray lines;
+        file.readLines (lines);
+        if (lines.isEmpty())
+            return false;
+
+        for (int n = 0; n < lines.size(); ++n)
+        {
+            const auto line = lines[n].upToFirstOccurrenceOf ("#", false, false).trim();
+            if (line.isEmpty())
+                continue;
+
+            juce::StringArray tokens;
+            tokens.addTokens (line, ", \t", "");
+            tokens.removeEmptyStrings();
+            if (tokens.size() != 3)
+            {
+                std::fprintf (stderr, "%s:%d: expected \"seconds, paramID, value\"\n", file.getFileName().toRawUTF8(), n + 1);
+                return false;
+            }
+
+            auto lane = std::find_if (lanes.begin(), lanes.end(), [&] (const AutomationLane& l) { return l.paramID == tokens[1]; });
+            if (lane == lanes.end())
+                lane = lanes.insert (lanes.end(), AutomationLane { tokens[1], {} });
+
+            lane->points.emplace_back (tokens[0].getDoubleValue(), tokens[2].getFloatValue());
+        }
+
+        for (auto& lane : lanes)
+            std::stable_sort (lane.points.begin(), lane.points.end(),
+                              [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+        return ! lanes.empty();
+    }
+
+    int chooseBitDepth (juce::AudioFormat& format, int wanted)
+    {
+        // 対応している中で wanted 以下の最大（なければ最小）
+        int best = 0, smallest = 0;
+        for (auto b : format.getPossibleBitDepths())
+        {
+            if (b <= wanted && b > best)
+                best = b;
+            if (smallest == 0 || b < smallest)
+                smallest = b;
+        }
+        return best > 0 ? best : smallest;
+    }
+
+    //==============================================================================
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (const BatchOptions& o, const std::vector<Job>& j, std::vector<JobResult>& r,
+                std::atomic<int>& next, std::atomic<int>& finished)
+        : juce::Thread ("VoiceModelerBatch worker"), options (o), jobs (j), results (r),
+          nextJob (next), numFinished (finished)
+        {
+            // プロセッサ（APVTS のタイマー）はメッセージスレッドで作っておく
+            if (options.preset.getSize() > 0)
+                proc.setStateInformation (options.preset.getData(), (int) options.preset.getSize());
+            applySettings (proc, options.settings);
+
+            for (auto& lane : options.automation)
+                bindings.push_back ({ &lane, proc.apvts.getParameter (lane.paramID),
+                                      VoiceModelerAudioProcessor::getAutomationIndex (lane.paramID), 0.0f });
+            curve.resize ((size_t) automationSlice);
+
+            formats.registerBasicFormats();
+        }
+
+        void run() override
+        {
+            for (;;)
+            {
+                const int index = nextJob.fetch_add (1);
+                if (index >= (int) jobs.size() || threadShouldExit())
+                    break;
+
+                const auto t0 = std::chrono::steady_clock::now();
+                auto& r = results[(size_t) index];
+                r.error = render (jobs[(size_t) index], r.audioSeconds);
+                r.ok = r.error.isEmpty();
+                r.wallSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+                numFinished.fetch_add (1);
+            }
+        }
+
+    private:
+        struct Binding
+        {
+            const AutomationLane* lane;
+            juce::RangedAudioParameter* parameter;
+            int index;                  // サンプル精度の対象（getAutomationIndex）、対象外なら -1
+            float last;                 // パラメータに設定済みの値
+        };
+
+        void setParameter (Binding& b, float plainValue)
+        {
+            b.parameter->setValueNotifyingHost (b.parameter->convertTo0to1 (plainValue));
+            b.last = plainValue;
+        }
+
+        // 入力の [start, start + len) を処理する直前：対象は区間内の曲線をキューへ積み、パラメータ自体は区間末尾の値に
+        // （次の区間はそこから始まる）。対象外（モードなど）は区間先頭の値をそのまま設定
+        void queueAutomation (juce::int64 start, int len, double sampleRate)
+        {
+            for (auto& b : bindings)
+            {
+                const auto at = [&] (juce::int64 n) { return b.lane->valueAt ((double) n / sampleRate); };
+
+                if (b.index < 0)
+                {
+                    if (const float v = at (start); v != b.last)
+                        setParameter (b, v);
+                    continue;
+                }
+
+                bool moving = false;
+                for (int i = 0; i < len; ++i)
+                {
+                    curve[(size_t) i] = at (start + i);
+                    moving = moving || curve[(size_t) i] != b.last;
+                }
+
+                if (moving)
+                {
+                    proc.pushAutomationCurve (b.index, curve.data(), len);
+                    setParameter (b, curve[(size_t) len - 1]);
+                }
+            }
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> openReader (const juce::File& file)
+        {
+            if (options.memoryMapped)
+            {
+                if (auto* format = formats.findFormatForFileExtension (file.getFileExtension()))
+                {
+                    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped (format->createMemoryMappedReader (file));
+                    if (mapped != nullptr && mapped->mapEntireFile())
+                        return mapped;
+                }
+            }
+
+            return std::unique_ptr<juce::AudioFormatReader> (formats.createReaderFor (file));
+        }
+
+        // 成功なら空文字を返す
+        juce::String render (const Job& job, double& audioSeconds)
+        {
+            auto reader = openReader (job.input);
+            if (reader == nullptr)
+                return "cannot read input";
+
+            const int numChannels = (int) reader->numChannels;
+            if (numChannels < 1 || numChannels > VoiceModelerAudioProcessor::maxChannels)
+                return "unsupported channel count " + juce::String (numChannels);
+
+            auto* format = formats.findFormatForFileExtension (job.output.getFileExtension());
+            if (format == nullptr)
+                return "no writer for " + job.output.getFileExtension();
+
+            const double sampleRate = reader->sampleRate;
+            const auto length = reader->lengthInSamples;
+            const int bits = chooseBitDepth (*format, options.bitDepth > 0 ? options.bitDepth : (int) reader->bitsPerSample);
+
+            job.output.getParentDirectory().createDirectory();
+            juce::TemporaryFile temp (job.output);
+
+            auto stream = std::make_unique<juce::FileOutputStream> (temp.getFile());
+            if (! stream->openedOk())
+                return "cannot create " + temp.getFile().getFullPathName();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                      bits, {}, 0));
+            if (writer == nullptr)
+                return "cannot write " + format->getFormatName() + " (" + juce::String (bits) + " bit)";
+            stream.release(); // writer が所有
+
+            for (auto& b : bindings)
+                if (b.parameter == nullptr)
+                    return "unknown parameter in automation: " + b.lane->paramID;
+
+            // オートメーションは先頭の値から始める（prepare で取り込まれる）
+            for (auto& b : bindings)
+                setParameter (b, b.lane->valueAt (0.0));
+
+            // ファイルごとに prepare し直す（サンプルレート・チャンネル数が変わってもよい）
+            const int block = options.blockSize;
+            const int slice = bindings.empty() ? block : juce::jmin (block, automationSlice);
+            proc.setPlayConfigDetails (numChannels, numChannels, sampleRate, block);
+            proc.prepareToPlay (sampleRate, block);
+            const int latency = proc.getLatencySamples();
+
+            juce::AudioBuffer<float> buffer (numChannels, block);
+            juce::MidiBuffer midi;
+
+            juce::int64 readPos = 0, toSkip = latency, remaining = length;
+
+            while (remaining > 0)
+            {
+                if (threadShouldExit())
+                    return "cancelled";
+
+                // 入力が尽きたらゼロでレイテンシ分を吐き出させる
+                const int fromFile = (int) juce::jlimit ((juce::int64) 0, (juce::int64) block, length - readPos);
+                if (fromFile > 0 && ! reader->read (&buffer, 0, fromFile, readPos, true, true))
+                    return "read error";
+                if (fromFile < block)
+                    buffer.clear (fromFile, block - fromFile);
+
+                for (int pos = 0; pos < block; pos += slice)
+                {
+                    const int len = juce::jmin (slice, block - pos);
+                    juce::AudioBuffer<float> view (buffer.getArrayOfWritePointers(), numChannels, pos, len);
+
+                    queueAutomation (readPos + pos, len, sampleRate);
+                    proc.processBlock (view, midi);
+                }
+                readPos += block;
+
+                const int skip = (int) juce::jmin (toSkip, (juce::int64) block);
+                toSkip -= skip;
+
+                const int count = (int) juce::jmin (remaining, (juce::int64) (block - skip));
+                if (count > 0 && ! writer->writeFromAudioSampleBuffer (buffer, skip, count))
+                    return "write error";
+                remaining -= count;
+            }
+
+            writer.reset(); // ヘッダを確定してから差し替える
+            proc.releaseResources();
+
+            if (! temp.overwriteTargetFileWithTemporary())
+                return "cannot replace " + job.output.getFullPathName();
+
+            audioSeconds = (double) length / sampleRate;
+            return {};
+        }
+
+        const BatchOptions& options;
+        const std::vector<Job>& jobs;
+        std::vector<JobResult>& results;
+        std::atomic<int>& nextJob;
+        std::atomic<int>& numFinished;
+
+        VoiceModelerAudioProcessor proc;
+        juce::AudioFormatManager formats;
+        std::vector<Binding> bindings;
+        std::vector<float> curve;       // 1 区間ぶんの曲線（pushAutomationCurve に渡す）
+
+        JUCE_DECLARE_NON_COPYABLE (Worker)
+    };
+
+    //==============================================================================
+    juce::File resolve (const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (path);
+    }
+
+    juce::File outputFor (const juce::File& input, const juce::File& root, const juce::File& outDir, const juce::String& format)
+    {
+        const auto relative = root.isDirectory() ? input.getRelativePathFrom (root) : input.getFileName();
+        auto out = outDir.getChildFile (relative);
+        return format == "same" ? out : out.withFileExtension (format);
+    }
+
+    bool collectJobs (const juce::StringArray& inputs, const juce::File& outDir, const juce::String& format,
+                      juce::AudioFormatManager& formats, std::vector<Job>& jobs)
+    {
+        bool ok = true;
+        const auto wildcard = formats.getWildcardForAllFormats();
+
+        for (auto& path : inputs)
+        {
+            const auto root = resolve (path);
+
+            juce::Array<juce::File> files;
+            if (root.isDirectory())
+                files = root.findChildFiles (juce::File::findFiles, true, wildcard);
+            else if (root.existsAsFile())
+                files.add (root);
+            else
+            {
+                std::fprintf (stderr, "not found: %s\n", path.toRawUTF8());
+                ok = false;
+            }
+
+            for (auto& f : files)
+            {
+                // 出力先の中を入力に含めたときに自分の出力を読み直さないように
+                if (f.isAChildOf (outDir))
+                    continue;
+
+                const auto out = outputFor (f, root, outDir, format);
+                if (out == f)
+                {
+                    std::fprintf (stderr, "output would overwrite input: %s\n", f.getFullPathName().toRawUTF8());
+                    ok = false;
+                    continue;
+                }
+
+                jobs.push_back ({ f, out });
+            }
+        }
+
+        return ok;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // APVTS がタイマーを使うのでメッセージマネージャだけ用意する（ウィンドウ・デバイスは作らない）
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    const auto optionOr = [&args] (const char* name, const char* fallback)
+    {
+        const auto v = args.getValueForOption (name);
+        return v.isNotEmpty() ? v : juce::String (fallback);
+    };
+
+    juce::StringArray inputs;
+    for (auto& a : args.arguments)
+        if (! a.isOption())
+            inputs.add (a.text);
+
+    const auto outPath = args.getValueForOption ("--out");
+    if (outPath.isEmpty() || inputs.isEmpty())
+    {
+        std::fprintf (stderr, "usage: VoiceModelerBatch --out=dir [--preset=file] [--threads=N] [--block=65536]\n"
+                              "                         [--format=same|wav|flac|aiff] [--bits=N] [--set=id=value,...]\n"
+                              "                         [--automation=file] [--mmap] [--verbose] <file or dir> ...\n");
+        return 2;
+    }
+
+    BatchOptions options;
+    options.settings     = args.getValueForOption ("--set");
+    options.format       = optionOr ("--format", "same").toLowerCase().trimCharactersAtStart (".");
+    options.bitDepth     = args.getValueForOption ("--bits").getIntValue();
+    options.blockSize    = juce::jlimit (64, 1 << 20, optionOr ("--block", "65536").getIntValue());
+    options.memoryMapped = args.containsOption ("--mmap");
+
+    const auto presetPath = args.getValueForOption ("--preset");
+    if (presetPath.isNotEmpty() && ! loadPreset (resolve (presetPath), options.preset))
+    {
+        std::fprintf (stderr, "cannot load preset: %s\n", presetPath.toRawUTF8());
+        return 2;
+    }
+
+    const auto automationPath = args.getValueForOption ("--automation");
+    if (automationPath.isNotEmpty() && ! loadAutomation (resolve (automationPath), options.automation))
+    {
+        std::fprintf (stderr, "cannot load automation: %s\n", automationPath.toRawUTF8());
+        return 2;
+    }
+
+    const auto outDir = resolve (outPath);
+    if (! outDir.createDirectory().wasOk())
+    {
+        std::fprintf (stderr, "cannot create %s\n", outDir.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    std::vector<Job> jobs;
+    bool inputsOk = true;
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        inputsOk = collectJobs (inputs, outDir, options.format, formats, jobs);
+    }
+
+    if (jobs.empty())
+    {
+        std::fprintf (stderr, "no audio files to process\n");
+        return 1;
+    }
+
+    const auto threadsArg = args.getValueForOption ("--threads");
+    const int numThreads = juce::jlimit (1, (int) jobs.size(),
+                                         threadsArg.isNotEmpty() ? threadsArg.getIntValue() : juce::SystemStats::getNumCpus());
+
+    std::vector<JobResult> results (jobs.size());
+    std::atomic<int> nextJob { 0 }, numFinished { 0 };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back (std::make_unique<Worker> (options, jobs, results, nextJob, numFinished));
+
+    std::printf ("%d files, %d threads, block %d\n", (int) jobs.size(), numThreads, options.blockSize);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (auto& w : workers)
+        w->startThread();
+
+    // 進捗表示（終わるまで待つだけ）
+    for (int lastShown = -1;;)
+    {
+        const int done = numFinished.load();
+        if (done != lastShown)
+        {
+            std::printf ("\r%d / %d", done, (int) jobs.size());
+            std::fflush (stdout);
+            lastShown = done;
+        }
+
+        if (done >= (int) jobs.size())
+            break;
+
+        juce::Thread::sleep (200);
+    }
+    std::printf ("\n");
+
+    for (auto& w : workers)
+        w->stopThread (-1);
+
+    const double wallSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+    workers.clear();
+
+    double audioSeconds = 0.0, busySeconds = 0.0;
+    int numFailed = 0;
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const auto& r = results[i];
+        busySeconds += r.wallSeconds;
+
+        if (r.ok)
+        {
+            audioSeconds += r.audioSeconds;
+            if (args.containsOption ("--verbose"))
+                std::printf ("ok    %9.2f s %9.1fx  %s\n", r.audioSeconds, r.audioSeconds / juce::jmax (1.0e-9, r.wallSeconds),
+                             jobs[i].output.getFullPathName().toRawUTF8());
+        }
+        else
+        {
+            ++numFailed;
+            std::fprintf (stderr, "FAIL  %s: %s\n", jobs[i].input.getFullPathName().toRawUTF8(), r.error.toRawUTF8());
+        }
+    }
+
+    // x-realtime：全体は 音声長 / 経過時間、1 スレッドあたりは 音声長 / 各スレッドの処理時間の合計
+    std::printf ("%d ok, %d failed\n", (int) jobs.size() - numFailed, numFailed);
+    std::printf ("audio %.1f s, wall %.2f s, %.1fx realtime (%.1fx per thread)\n",
+                 audioSeconds, wallSeconds,
+                 audioSeconds / juce::jmax (1.0e-9, wallSeconds),
+                 audioSeconds / juce::jmax (1.0e-9, busySeconds));
+
+    return (numFailed > 0 || ! inputsOk) ? 1 : 0;
+}
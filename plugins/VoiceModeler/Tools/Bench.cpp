@@ -0,0 +1,1253 @@
+// VoiceModeler ヘッドレスベンチマーク
+// VoiceModelerAudioProcessor を直接生成し、サンプルレート × ブロックサイズ × オートメーション
+// パターンの組み合わせごとに processBlock のコストを計測する。オーディオデバイスは使わない。
+//
+//   VoiceModelerBench [--rates=44100,48000,96000,192000] [--blocks=16,32,64,128,256,512,1024,4096]
+//                     [--patterns=static,ramp,jump,sample] [--channels=2] [--seconds=5] [--json=result.json]
+//                     [--set=formantMode=1,oversampling=2] [--precision=float,double] [--internal=host,float,double]
+//                     [--signal=voice|sparse]
+//   VoiceModelerBench --saturation
+//   VoiceModelerBench --golden=dir [--update] [--tolerance=-80] | --responses | --rtsafety
+//   VoiceModelerBench --state [--instances=64] [--iterations=20]
+//   VoiceModelerBench --formants [--background]
+//   VoiceModelerBench --convolution [--partitions=32,64,128,256,512]
+//   VoiceModelerBench --shared [--instances=150] [--seconds=2]
+//   VoiceModelerBench --dynamic [--seconds=3]
+//   VoiceModelerBench --cascade [--blocks=16,32,64,512] [--seconds=5]
+//
+// 出力：構成ごとの ns/sample、ブロック処理時間の p50/p99/max (µs)、リアルタイム倍率
+//       （= 音声の長さ / 処理時間、1 より大きければ実時間より速い）。
+// --precision：ホストのバッファ（float = 32bit ホスト、double = 64bit ホスト）。
+// --internal ：Precision パラメータ（host = バッファに合わせる、float / double = 内部精度を固定し境界で変換）。
+// --signal   ：voice = 声っぽいパルス列が鳴り続ける、sparse = 4 秒のうち 0.5 秒だけ鳴る（無音の多い台詞トラック。
+//              アイドル判定で処理を省く効果を見る）。
+// --saturation：tanh 近似の各精度を std::tanh と比較し、誤差と速度を表示。
+//               Saturation.h に書いた誤差上限を超えたら終了コード 1。
+// --golden / --responses / --rtsafety：回帰・正しさのチェック（Checks.h）。不合格なら終了コード 1。
+// --state：状態の保存・読み込み時間（インスタンスあたり µs、バイナリ vs 旧 XML）と往復の一致、全 ID が IDs::all にあるか、
+//          スキーマ版 1 の状態が読めるか。どれか満たさなければ終了コード 1。
+// --formants：Adaptive モードのフォルマント追跡。合成母音での F1–F3 の誤差・無声区間での保持と、
+//             トラッカーのコスト（Peak モードのチェインの 20 % 未満）。--background はワーカースレッドで解析。不合格なら終了コード 1。
+// --convolution：線形位相 EQ。分割畳み込みと直接畳み込みの差（-90 dB 未満）、設計した FIR と IIR の段の積の振幅の差
+//               （100 Hz 以上で 0.5 dB 未満）、Minimum → Linear の切替で FIR が入るまで Minimum と同じ出力・レイテンシか、
+//               分割長ごとのコストを 11 段の IIR チェインと比較。不合格なら終了コード 1。
+// --shared：多数インスタンス。全インスタンスで同じ EQ 操作をしながら順に処理し、係数キャッシュあり／なしの
+//           ns/sample（インスタンスあたり）と、共有している窓・FFT の量を表示。キャッシュありの出力がなしと
+//           -60 dB 以上ずれたら終了コード 1。
+// --dynamic：動的 EQ／RBass ダッキング。検出器のゲイン（キー無音で 1、しきい値 +12 dB 以上で range）と、
+//            無音のサイドチェインで静的なときと出力が一致するか、静的に対する増分コスト（30 % 未満）。不合格なら終了コード 1。
+// --cascade：11 段の IIR チェイン。旧実装（段ごとの ProcessorDuplicator<IIR::Filter>）と融合カスケード（BiquadCascade）の
+//            ns/sample と速度比（目標 3 倍）、出力の差を float / double で表示。差が -100 dB re peak 以上なら終了コード 1（速度比では落とさない）。
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+#include "Saturation.h"
+#include "FormantTracker.h"
+#include "PartitionedConvolver.h"
+#include "LinearPhaseEq.h"
+#include "DynamicsDetector.h"
+#include "BiquadCascade.h"
+#include "SharedResources.h"
+#include "BenchSupport.h"
+#include "Checks.h"
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    struct BenchConfig
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 64;
+        int numChannels = 2;
+        juce::String pattern = "static";
+        juce::String settings;   // "paramID=値,..."（実値。prepare 前に設定）
+        bool doubleBuffers = false;
+        juce::String internal = "host";
+        juce::String signal = "voice";
+    };
+
+    struct BenchResult
+    {
+        BenchConfig config;
+        int numBlocks = 0;
+        double nsPerSample = 0.0;
+        double p50Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+        double realtimeFactor = 0.0;
+        bool doubleCore = false;
+    };
+
+    juce::Array<double> parseList (const juce::String& csv)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens (csv, ",", "");
+
+        juce::Array<double> values;
+        for (auto& t : tokens)
+            if (t.trim().isNotEmpty())
+                values.add (t.trim().getDoubleValue());
+        return values;
+    }
+
+    // オートメーションパターン（正規化値で setValueNotifyingHost する＝ホストと同じ経路）
+    class Automation
+    {
+    public:
+        Automation (VoiceModelerAudioProcessor& p, const juce::String& patternName, const BenchConfig& c)
+        : proc (p), pattern (patternName), config (c)
+        {
+            for (auto* id : { IDs::gainDb, IDs::formantRatio, IDs::pitchSemis, IDs::nasalAmt, IDs::nasalNotch,
+                              IDs::rbDriveDb, IDs::rbFocusHz, IDs::rbMix,
+                              IDs::eq1Freq, IDs::eq1Gain, IDs::eq1Q,
+                              IDs::eq2Freq, IDs::eq2Gain, IDs::eq2Q,
+                              IDs::eq3Freq, IDs::eq3Gain, IDs::eq3Q })
+                params.add (p.apvts.getParameter (id));
+
+            jumpInterval = juce::jmax (1, (int) (0.05 * c.sampleRate / c.blockSize)); // 約 50 ms ごと
+        }
+
+        void apply (int blockIndex)
+        {
+            const double t = (double) blockIndex * config.blockSize / config.sampleRate;
+
+            if (pattern == "ramp")
+            {
+                // 連続的なスイープ：毎ブロック値が動く
+                for (auto& r : ramps)
+                    set (r.id, r.at (t));
+            }
+            else if (pattern == "sample")
+            {
+                // 同じスイープをサンプル精度で：ブロック内に 16 サンプルごとの点を積み、パラメータ自体は末尾の値にする
+                for (auto& r : ramps)
+                {
+                    auto* p = find (r.id);
+                    const int index = VoiceModelerAudioProcessor::getAutomationIndex (r.id);
+
+                    for (int offset = 0; offset < config.blockSize; offset += 16)
+                        proc.pushAutomation (index, offset, p->convertFrom0to1 (r.at (t + offset / config.sampleRate)));
+
+                    set (r.id, r.at (t + (config.blockSize - 1) / config.sampleRate));
+                }
+            }
+            else if (pattern == "jump")
+            {
+                // 全パラメータをランダムにジャンプ（最悪ケース寄り）
+                if (blockIndex % jumpInterval == 0)
+                    for (auto* p : params)
+                        if (p != nullptr)
+                            p->setValueNotifyingHost (rng.nextFloat());
+            }
+        }
+
+    private:
+        struct Ramp
+        {
+            const char* id;
+            float centre, depth;
+            double hz;
+
+            float at (double t) const noexcept
+            {
+                return juce::jlimit (0.0f, 1.0f, centre + depth * (float) std::sin (juce::MathConstants<double>::twoPi * hz * t));
+            }
+        };
+
+        static constexpr Ramp ramps[] = {
+            { IDs::formantRatio, 0.5f, 0.5f, 0.5 },
+            { IDs::eq2Gain,      0.5f, 0.4f, 0.3 },
+            { IDs::eq3Freq,      0.5f, 0.3f, 0.2 },
+            { IDs::gainDb,       0.5f, 0.1f, 1.0 }
+        };
+
+        juce::RangedAudioParameter* find (const char* id) const
+        {
+            for (auto* p : params)
+                if (p != nullptr && p->paramID == id)
+                    return p;
+            return nullptr;
+        }
+
+        void set (const char* id, float normalised)
+        {
+            if (auto* p = find (id))
+                p->setValueNotifyingHost (juce::jlimit (0.0f, 1.0f, normalised));
+        }
+
+        VoiceModelerAudioProcessor& proc;
+        juce::String pattern;
+        BenchConfig config;
+        juce::Array<juce::RangedAudioParameter*> params;
+        juce::Random rng { 42 };
+        int jumpInterval = 1;
+    };
+
+    template <typename SampleType>
+    BenchResult runConfigWith (const BenchConfig& config, double seconds)
+    {
+        const int numChannels = config.numChannels;
+        VoiceModelerAudioProcessor proc;
+        BenchSupport::applySettings (proc, config.settings);
+
+        // 内部精度（Precision パラメータ）とホストの処理精度
+        const auto internalIndex = juce::StringArray { "host", "float", "double" }.indexOf (config.internal);
+        BenchSupport::applySettings (proc, "precision=" + juce::String (juce::jmax (0, internalIndex)));
+        proc.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                        : juce::AudioProcessor::singlePrecision);
+
+        proc.setPlayConfigDetails (numChannels, numChannels, config.sampleRate, config.blockSize);
+        proc.prepareToPlay (config.sampleRate, config.blockSize);
+
+        // 入力は事前生成してループ再生（生成コストを計測に含めない）。voice は 1 秒鳴りっぱなし、sparse は 4 秒中 0.5 秒
+        const bool sparse = config.signal == "sparse";
+        juce::AudioBuffer<float> source (numChannels, (int) (config.sampleRate * (sparse ? 4.0 : 1.0)));
+        BenchSupport::renderVoice (source, config.sampleRate, sparse ? (int) (config.sampleRate * 0.5) : source.getNumSamples());
+
+        juce::AudioBuffer<SampleType> io (numChannels, config.blockSize);
+        juce::MidiBuffer midi;
+        Automation automation (proc, config.pattern, config);
+
+        const int warmupBlocks = juce::jmax (4, (int) (0.2 * config.sampleRate / config.blockSize));
+        const int numBlocks    = juce::jmax (16, (int) (seconds * config.sampleRate / config.blockSize));
+
+        std::vector<double> blockNs;
+        blockNs.reserve ((size_t) numBlocks);
+
+        int readPos = 0;
+        double totalNs = 0.0;
+
+        for (int b = -warmupBlocks; b < numBlocks; ++b)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                for (int i = 0, pos = readPos; i < config.blockSize; ++i, pos = (pos + 1) % source.getNumSamples())
+                    io.setSample (ch, i, source.getSample (ch, pos));
+            }
+            readPos = (readPos + config.blockSize) % source.getNumSamples();
+
+            automation.apply (b + warmupBlocks);
+
+            const auto t0 = std::chrono::steady_clock::now();
+            proc.processBlock (io, midi);
+            const auto t1 = std::chrono::steady_clock::now();
+
+            if (b >= 0)
+            {
+                const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (t1 - t0).count();
+                blockNs.push_back (ns);
+                totalNs += ns;
+            }
+        }
+
+        std::sort (blockNs.begin(), blockNs.end());
+        const auto percentile = [&blockNs] (double p)
+        {
+            const auto idx = (size_t) juce::jlimit (0.0, (double) blockNs.size() - 1.0, std::ceil (p * (double) blockNs.size()) - 1.0);
+            return blockNs[idx];
+        };
+
+        BenchResult r;
+        r.config         = config;
+        r.numBlocks      = numBlocks;
+        r.nsPerSample    = totalNs / ((double) numBlocks * config.blockSize);
+        r.p50Us          = percentile (0.50) * 1.0e-3;
+        r.p99Us          = percentile (0.99) * 1.0e-3;
+        r.maxUs          = blockNs.back() * 1.0e-3;
+        r.realtimeFactor = ((double) numBlocks * config.blockSize / config.sampleRate) / (totalNs * 1.0e-9);
+        r.doubleCore     = proc.isUsingDoubleCore();
+        return r;
+    }
+
+    BenchResult runConfig (const BenchConfig& config, double seconds)
+    {
+        return config.doubleBuffers ? runConfigWith<double> (config, seconds)
+                                    : runConfigWith<float>  (config, seconds);
+    }
+
+    juce::var toJson (const juce::Array<BenchResult>& results, double seconds)
+    {
+        juce::Array<juce::var> list;
+
+        for (auto& r : results)
+        {
+            juce::DynamicObject::Ptr o = new juce::DynamicObject();
+            o->setProperty ("sampleRate",     r.config.sampleRate);
+            o->setProperty ("blockSize",      r.config.blockSize);
+            o->setProperty ("channels",       r.config.numChannels);
+            o->setProperty ("pattern",        r.config.pattern);
+            o->setProperty ("signal",         r.config.signal);
+            o->setProperty ("settings",       r.config.settings);
+            o->setProperty ("buffer",         r.config.doubleBuffers ? "double" : "float");
+            o->setProperty ("internal",       r.config.internal);
+            o->setProperty ("doubleCore",     r.doubleCore);
+            o->setProperty ("blocks",         r.numBlocks);
+            o->setProperty ("nsPerSample",    r.nsPerSample);
+            o->setProperty ("p50Us",          r.p50Us);
+            o->setProperty ("p99Us",          r.p99Us);
+            o->setProperty ("maxUs",          r.maxUs);
+            o->setProperty ("realtimeFactor", r.realtimeFactor);
+            list.add (juce::var (o.get()));
+        }
+
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty ("tool",     "VoiceModelerBench");
+        root->setProperty ("cpu",      juce::SystemStats::getCpuModel());
+        root->setProperty ("os",       juce::SystemStats::getOperatingSystemName());
+        root->setProperty ("seconds",  seconds);
+        root->setProperty ("results",  list);
+        return juce::var (root.get());
+    }
+}
+
+namespace
+{
+    // tanh 近似の検証：±12 を密にスイープして std::tanh（double）と比較
+    int checkSaturation()
+    {
+        constexpr int numPoints = 1 << 22;
+        std::vector<float> x ((size_t) numPoints), y ((size_t) numPoints), ref ((size_t) numPoints);
+
+        for (int i = 0; i < numPoints; ++i)
+            x[(size_t) i] = -12.0f + 24.0f * (float) i / (float) (numPoints - 1);
+
+        const auto timeNs = [numPoints] (auto&& fn)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - t0).count() / numPoints;
+        };
+
+        const double stdNs = timeNs ([&] { for (size_t i = 0; i < x.size(); ++i) ref[i] = std::tanh (x[i]); });
+
+        std::printf ("%-9s %12s %12s %10s\n", "quality", "max err", "bound", "ns/smp");
+        std::printf ("%-9s %12s %12s %10.3f\n", "std", "-", "-", stdNs);
+
+        const char* names[] = { "fast", "balanced", "accurate" };
+        bool ok = true;
+
+        for (int q = 0; q < 3; ++q)
+        {
+            const auto quality = (Saturation::Quality) q;
+            const double ns = timeNs ([&] { Saturation::tanh (x.data(), y.data(), numPoints, quality); });
+
+            double maxErr = 0.0;
+            for (size_t i = 0; i < x.size(); ++i)
+                maxErr = std::max (maxErr, std::abs ((double) y[i] - std::tanh ((double) x[i])));
+
+            const bool pass = maxErr <= Saturation::maxError (quality);
+            ok = ok && pass;
+
+            std::printf ("%-9s %12.3g %12.3g %10.3f %s\n", names[q], maxErr,
+                         (double) Saturation::maxError (quality), ns, pass ? "" : "FAIL");
+        }
+
+        return ok ? 0 : 1;
+    }
+
+    // 状態の保存・読み込み：プロジェクトを開く／保存するたびにインスタンス数ぶん走るので、インスタンスあたりで計る。
+    // 読み込みは別インスタンスの状態を入れる（値が変わらないとパラメータの書き換えが省かれて速く見えるため）
+    int benchState (int numInstances, int iterations)
+    {
+        std::vector<std::unique_ptr<VoiceModelerAudioProcessor>> procs;
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto p = std::make_unique<VoiceModelerAudioProcessor>();
+            p->getPluginState().loadPreset (i % PluginState::getNumPresets());
+
+            auto* gain = p->apvts.getParameter (IDs::gainDb);
+            gain->setValueNotifyingHost (gain->convertTo0to1 ((float) (i % 24) * 0.5f - 6.0f));
+            procs.push_back (std::move (p));
+        }
+
+        const auto saveAs = [] (VoiceModelerAudioProcessor& p, bool binary, juce::MemoryBlock& dest)
+        {
+            if (binary) p.getStateInformation (dest);
+            else        p.getPluginState().saveXml (dest);
+        };
+
+        const auto elapsedUs = [] (auto&& fn)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            return std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - t0).count();
+        };
+
+        bool ok = true;
+
+        // 状態の鍵：全パラメータの ID が IDs::all にあること（その中の衝突は ParameterIDs.h の static_assert が見ている）
+        {
+            VoiceModelerAudioProcessor p;
+            for (auto* param : p.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (param))
+                    if (std::none_of (std::begin (IDs::all), std::end (IDs::all),
+                                      [ranged] (const char* id) { return ranged->paramID == id; }))
+                    {
+                        std::printf ("parameter %s is missing from IDs::all FAIL\n", ranged->paramID.toRawUTF8());
+                        ok = false;
+                    }
+
+            // スキーマ版 1（鍵が juce::String::hashCode）の状態も読めること
+            juce::MemoryBlock legacy;
+            {
+                juce::MemoryOutputStream out (legacy, false);
+                out.writeInt ((int) PluginState::magic);
+                out.writeShort (1);
+                out.writeShort (1);
+                out.writeInt (juce::String (IDs::gainDb).hashCode());
+                out.writeFloat (-7.5f);
+            }
+            p.setStateInformation (legacy.getData(), (int) legacy.getSize());
+            const float gain = p.apvts.getParameter (IDs::gainDb)->convertFrom0to1 (p.apvts.getParameter (IDs::gainDb)->getValue());
+            const bool legacyOk = std::abs (gain + 7.5f) < 1.0e-3f;
+            ok = ok && legacyOk;
+            std::printf ("schema 1 state: %s\n", legacyOk ? "ok" : "FAIL");
+        }
+
+        std::printf ("%-7s %9s %12s %12s %s\n", "format", "bytes", "save us", "load us", "round trip");
+
+        for (const bool binary : { true, false })
+        {
+            std::vector<juce::MemoryBlock> blobs ((size_t) numInstances);
+
+            const double saveUs = elapsedUs ([&]
+            {
+                for (int it = 0; it < iterations; ++it)
+                    for (int i = 0; i < numInstances; ++i)
+                        saveAs (*procs[(size_t) i], binary, blobs[(size_t) i]);
+            });
+
+            // 往復：保存した状態を新しいインスタンスへ読み込み、全パラメータの実値が一致するか
+            bool same = true;
+            for (int i = 0; i < numInstances; ++i)
+            {
+                VoiceModelerAudioProcessor fresh;
+                fresh.setStateInformation (blobs[(size_t) i].getData(), (int) blobs[(size_t) i].getSize());
+
+                PluginState::Snapshot expected, actual;
+                procs[(size_t) i]->getPluginState().capture (expected);
+                fresh.getPluginState().capture (actual);
+
+                for (size_t k = 0; k < expected.size(); ++k)
+                    same = same && std::abs (expected[k] - actual[k]) <= 1.0e-4f * juce::jmax (1.0f, std::abs (expected[k]));
+            }
+            ok = ok && same;
+
+            const double loadUs = elapsedUs ([&]
+            {
+                for (int it = 0; it < iterations; ++it)
+                    for (int i = 0; i < numInstances; ++i)
+                    {
+                        const auto& blob = blobs[(size_t) ((i + it + 1) % numInstances)];
+                        procs[(size_t) i]->setStateInformation (blob.getData(), (int) blob.getSize());
+                    }
+            });
+
+            const double calls = (double) iterations * numInstances;
+            std::printf ("%-7s %9d %12.2f %12.2f %s\n", binary ? "binary" : "xml", (int) blobs[0].getSize(),
+                         saveUs / calls, loadUs / calls, same ? "ok" : "FAIL");
+        }
+
+        return ok ? 0 : 1;
+    }
+
+    // Adaptive フォルマント：合成母音で F1–F3 の推定精度、無声区間での保持、解析コストを見る。
+    // コストはトラッカー単体の ns/sample を Peak モードのプロセッサ全体（＝いまのチェイン）と比べ、20 % 未満なら合格
+    int benchFormants (bool backgroundThread)
+    {
+        struct Vowel { const char* name; float hz[3]; };
+        const Vowel vowels[] = {
+            { "a", { 730.0f, 1090.0f, 2440.0f } },
+            { "i", { 270.0f, 2290.0f, 3010.0f } },
+            { "u", { 300.0f,  870.0f, 2240.0f } },
+            { "e", { 530.0f, 1840.0f, 2480.0f } },
+            { "o", { 570.0f,  840.0f, 2410.0f } },
+        };
+
+        // LPC は倍音の間隔より細かく包絡を見られないので、高い F0 の F1 は 2 割以上ずれることがある
+        constexpr float maxRelativeError = 0.3f;
+        constexpr int blockSize = 64;
+        bool ok = true;
+
+        const auto feed = [] (FormantTracker& tracker, const juce::AudioBuffer<float>& signal)
+        {
+            for (int pos = 0; pos < signal.getNumSamples(); pos += blockSize)
+                tracker.push (signal.getArrayOfReadPointers(), signal.getNumChannels(), pos,
+                              juce::jmin (blockSize, signal.getNumSamples() - pos));
+        };
+
+        const auto settle = [backgroundThread]
+        {
+            if (backgroundThread)
+                juce::Thread::sleep (50); // ワーカーが FIFO を吸い出すのを待つ
+        };
+
+        std::printf ("%7s %4s %-5s %20s %20s %8s %7s %s\n", "rate", "f0", "vowel", "estimate (Hz)", "true (Hz)", "max err", "voiced", "unvoiced hold");
+
+        for (const double rate : { 44100.0, 48000.0, 96000.0 })
+        {
+            for (const double f0 : { 110.0, 220.0 })
+            {
+                for (auto& v : vowels)
+                {
+                    FormantTracker tracker;
+                    tracker.prepare (rate, backgroundThread);
+
+                    juce::AudioBuffer<float> signal (2, (int) rate);
+                    BenchSupport::renderVowel (signal, rate, f0, v.hz, 0.3f);
+                    feed (tracker, signal);
+                    settle();
+
+                    const auto voiced = tracker.getEstimate();
+                    float maxErr = 0.0f;
+                    for (int k = 0; k < FormantTracker::numFormants; ++k)
+                        maxErr = juce::jmax (maxErr, std::abs (voiced.hz[(size_t) k] / v.hz[k] - 1.0f));
+
+                    // 続く無声音（ノイズ）では有声度が落ち、推定値は有声区間のまま保持される
+                    // （境目で母音とノイズが混ざったフレームのぶん、数 % は動いてよい）
+                    juce::AudioBuffer<float> noise (2, (int) (rate * 0.5));
+                    BenchSupport::renderNoise (noise, 0.05f);
+                    feed (tracker, noise);
+                    settle();
+
+                    const auto unvoiced = tracker.getEstimate();
+                    bool held = unvoiced.voicing < 0.5f;
+                    for (int k = 0; k < FormantTracker::numFormants; ++k)
+                        held = held && std::abs (unvoiced.hz[(size_t) k] / voiced.hz[(size_t) k] - 1.0f) <= 0.05f;
+                    const bool pass = maxErr <= maxRelativeError && voiced.voicing > 0.5f && held;
+                    ok = ok && pass;
+
+                    std::printf ("%7.0f %4.0f /%s/   %6.0f %6.0f %6.0f   %6.0f %6.0f %6.0f %7.1f%% %7.2f %s%s\n",
+                                 rate, f0, v.name, voiced.hz[0], voiced.hz[1], voiced.hz[2], v.hz[0], v.hz[1], v.hz[2],
+                                 maxErr * 100.0f, voiced.voicing, held ? "ok" : "no", pass ? "" : " FAIL");
+                }
+            }
+        }
+
+        // コスト：48 kHz ステレオ、64 サンプルブロック
+        constexpr double rate = 48000.0;
+        constexpr double seconds = 3.0;
+
+        juce::AudioBuffer<float> voice (2, (int) (rate * seconds));
+        BenchSupport::renderVoice (voice, rate, voice.getNumSamples());
+
+        double trackerNs = 1.0e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            FormantTracker tracker;
+            tracker.prepare (rate, backgroundThread);
+
+            const auto t0 = std::chrono::steady_clock::now();
+            feed (tracker, voice);
+            const auto t1 = std::chrono::steady_clock::now();
+            trackerNs = juce::jmin (trackerNs, std::chrono::duration<double, std::nano> (t1 - t0).count() / voice.getNumSamples());
+        }
+
+        BenchConfig c;
+        c.sampleRate = rate;
+        c.blockSize = blockSize;
+        const auto peakMode = runConfig (c, seconds);
+        c.settings = "formantMode=2";
+        const auto adaptiveMode = runConfig (c, seconds);
+
+        const double share = trackerNs / peakMode.nsPerSample;
+        const bool costOk = share < 0.2;
+        ok = ok && costOk;
+
+        std::printf ("\ncost @48k stereo: tracker %.2f ns/smp%s, Peak chain %.2f ns/smp, Adaptive chain %.2f ns/smp\n"
+                     "tracker / chain = %.1f%% (limit 20%%) %s\n",
+                     trackerNs, backgroundThread ? " (audio thread only)" : "", peakMode.nsPerSample, adaptiveMode.nsPerSample,
+                     share * 100.0, costOk ? "ok" : "FAIL");
+
+        return ok ? 0 : 1;
+    }
+}
+
+namespace
+{
+    // 線形位相 EQ：分割畳み込みの正しさ、FIR の設計精度、分割長ごとのコスト
+    int benchConvolution (const juce::Array<double>& partitions)
+    {
+        constexpr double rate = 48000.0;
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 64;
+        bool ok = true;
+
+        std::mt19937 rng (1);
+        std::uniform_real_distribution<float> uniform (-1.0f, 1.0f);
+
+        // --- 正しさ：ランダムな IR（2048）とノイズを、不揃いなブロックで畳み込み、double の直接畳み込みと比べる ---
+        constexpr int irLength = 2048, signalLength = 16384;
+        constexpr double maxErrorDb = -90.0;
+
+        std::vector<float> ir ((size_t) irLength), input ((size_t) signalLength);
+        for (int k = 0; k < irLength; ++k)
+            ir[(size_t) k] = uniform (rng) * std::exp (-3.0f * (float) k / irLength) * 0.1f;
+        for (auto& v : input) v = uniform (rng) * 0.5f;
+
+        std::vector<double> reference ((size_t) signalLength, 0.0);
+        double referencePeak = 0.0;
+        for (int n = 0; n < signalLength; ++n)
+        {
+            double sum = 0.0;
+            for (int k = 0; k <= juce::jmin (n, irLength - 1); ++k)
+                sum += (double) ir[(size_t) k] * input[(size_t) (n - k)];
+            reference[(size_t) n] = sum;
+            referencePeak = juce::jmax (referencePeak, std::abs (sum));
+        }
+
+        std::printf ("%9s %-5s %8s %12s\n", "partition", "head", "latency", "max err dB");
+
+        for (auto partition : partitions)
+        {
+            for (const bool head : { false, true })
+            {
+                PartitionedConvolver convolver;
+                convolver.prepare (1, (int) partition, irLength, head);
+                convolver.loadImpulseResponse (ir.data(), irLength);
+                convolver.reset();
+
+                auto output = input;
+                float* channels[] = { output.data() };
+                for (int pos = 0, len = 1; pos < signalLength; pos += len, len = len * 7 % 253 + 1)
+                    convolver.process (channels, 1, pos, juce::jmin (len, signalLength - pos));
+
+                const int latency = convolver.getLatencySamples();
+                double worst = 0.0;
+                for (int n = latency; n < signalLength; ++n)
+                    worst = juce::jmax (worst, std::abs ((double) output[(size_t) n] - reference[(size_t) (n - latency)]));
+
+                const double errDb = juce::Decibels::gainToDecibels (worst / referencePeak, -200.0);
+                const bool pass = errDb < maxErrorDb;
+                ok = ok && pass;
+
+                std::printf ("%9d %-5s %8d %12.1f %s\n", convolver.getPartitionSize(), head ? "yes" : "no", latency, errDb, pass ? "" : "FAIL");
+            }
+        }
+
+        // --- 設計：既定の EQ を少し動かした段の積と、設計した FIR の振幅（DTFT）の差 ---
+        using namespace BiquadDesign;
+        constexpr double maxDesignErrorDb = 0.5, minCheckHz = 100.0;
+
+        const auto stagesAt = [] (double sr)
+        {
+            return std::vector<BiquadCoeffs> {
+                peak (sr, 600.0, 1.2, juce::Decibels::decibelsToGain (0.4)),
+                peak (sr, 1000.0, 2.0, juce::Decibels::decibelsToGain (4.0)),
+                peak (sr, 3000.0, 2.5, juce::Decibels::decibelsToGain (-6.0)),
+                peak (sr, 120.0, 1.0, juce::Decibels::decibelsToGain (6.0)),
+                peak (sr, 1000.0, 1.0, juce::Decibels::decibelsToGain (-4.0)),
+                peak (sr, 3500.0, 3.0, juce::Decibels::decibelsToGain (9.0)) };
+        };
+
+        std::printf ("\n%7s %9s %8s %14s\n", "rate", "FIR taps", "latency", "max diff dB");
+
+        for (const double sr : { 44100.0, 48000.0, 96000.0 })
+        {
+            const auto stages = stagesAt (sr);
+            LinearPhaseEq eq;
+            eq.prepare (sr, 1, 128, false);
+
+            std::vector<float> fir ((size_t) eq.getFirLength());
+            eq.designImpulse (stages.data(), (int) stages.size(), fir.data());
+
+            double worst = 0.0;
+            for (double f = minCheckHz; f < 0.45 * sr; f *= 1.02)
+            {
+                const auto z1 = std::polar (1.0, -juce::MathConstants<double>::twoPi * f / sr);
+                std::complex<double> expected (1.0);
+                for (auto& c : stages)
+                    expected *= (c.b0 + c.b1 * z1 + c.b2 * z1 * z1) / (1.0 + c.a1 * z1 + c.a2 * z1 * z1);
+
+                std::complex<double> measured;
+                for (size_t k = 0; k < fir.size(); ++k)
+                    measured += (double) fir[k] * std::polar (1.0, -juce::MathConstants<double>::twoPi * f / sr * (double) k);
+
+                worst = juce::jmax (worst, std::abs (20.0 * std::log10 (std::abs (measured) / std::abs (expected))));
+            }
+
+            const bool pass = worst < maxDesignErrorDb;
+            ok = ok && pass;
+            std::printf ("%7.0f %9d %8d %14.3f %s\n", sr, eq.getFirLength(), eq.getLatencySamples(), worst, pass ? "" : "FAIL");
+        }
+
+        // --- コスト：48 kHz ステレオ、64 サンプルブロック。FIR は 48 kHz の線形位相 EQ と同じ長さ ---
+        constexpr double seconds = 3.0;
+        const int numSamples = (int) (rate * seconds);
+
+        juce::AudioBuffer<float> voice (numChannels, numSamples);
+        BenchSupport::renderVoice (voice, rate, numSamples);
+
+        const auto timeNs = [&] (auto&& processBlock)
+        {
+            double best = 1.0e30;
+            for (int run = 0; run < 3; ++run)
+            {
+                juce::AudioBuffer<float> work (voice);
+                const auto t0 = std::chrono::steady_clock::now();
+                for (int pos = 0; pos < numSamples; pos += blockSize)
+                    processBlock (work.getArrayOfWritePointers(), pos, juce::jmin (blockSize, numSamples - pos));
+                const auto t1 = std::chrono::steady_clock::now();
+                best = juce::jmin (best, std::chrono::duration<double, std::nano> (t1 - t0).count() / numSamples);
+            }
+            return best;
+        };
+
+        // IIR：プロセッサのチェインと同じ 11 段（すべて非恒等）
+        BiquadCascade<float> cascade;
+        cascade.prepare (numChannels, blockSize);
+        cascade.setNumStages (11);
+        cascade.reset();
+        for (int s = 0; s < 11; ++s)
+            cascade.setStage (s, peak (rate, 200.0 * (s + 1), 1.5, juce::Decibels::decibelsToGain (s % 2 == 0 ? 3.0 : -3.0)));
+
+        const double iirNs = timeNs ([&] (float* const* ch, int pos, int len) { cascade.process (ch, numChannels, pos, len); });
+
+        LinearPhaseEq sizing;
+        sizing.prepare (rate, 1, 128, false);
+        const int firLength = sizing.getFirLength();
+        std::vector<float> fir ((size_t) firLength);
+        const auto stages = stagesAt (rate);
+        sizing.designImpulse (stages.data(), (int) stages.size(), fir.data());
+
+        std::printf ("\ncost @48k stereo, block %d, FIR %d taps (ns/smp)\n%-22s %10.2f\n", blockSize, firLength, "IIR chain (11 stages)", iirNs);
+
+        for (auto partition : partitions)
+        {
+            for (const bool head : { false, true })
+            {
+                PartitionedConvolver convolver;
+                convolver.prepare (numChannels, (int) partition, firLength, head);
+                convolver.loadImpulseResponse (fir.data(), firLength);
+                convolver.reset();
+
+                const double ns = timeNs ([&] (float* const* ch, int pos, int len) { convolver.process (ch, numChannels, pos, len); });
+                const auto name = juce::String ("FIR B=") + juce::String (convolver.getPartitionSize()) + (head ? " +head" : "");
+                std::printf ("%-22s %10.2f  (x%.1f, latency %d)\n", name.toRawUTF8(), ns, ns / iirNs,
+                             firLength / 2 + convolver.getLatencySamples());
+            }
+        }
+
+        // --- Minimum → Linear の切替：FIR が設計されて畳み込みに入るまでは Minimum と同じ出力・同じレイテンシで鳴り、
+        //     入った時点でレイテンシが FIR ぶん増える（メッセージスレッドの処理は handlePendingUpdates で毎ブロック回す） ---
+        {
+            const juce::String shaping = "nasalAmt=60,eq1Gain=6,eq2Gain=-6,eq3Gain=4,eq3Q=3";
+            VoiceModelerAudioProcessor minimum, switched;
+            for (auto* p : { &minimum, &switched })
+            {
+                BenchSupport::applySettings (*p, shaping + ",eqPhase=0");
+                p->setPlayConfigDetails (numChannels, numChannels, rate, blockSize);
+                p->prepareToPlay (rate, blockSize);
+            }
+
+            const int latencyBefore = switched.getLatencySamples();
+            BenchSupport::applySettings (switched, "eqPhase=1");
+
+            juce::AudioBuffer<float> source (numChannels, (int) rate);
+            BenchSupport::renderVoice (source, rate, source.getNumSamples());
+            juce::AudioBuffer<float> a (numChannels, blockSize), b (numChannels, blockSize);
+            juce::MidiBuffer midi;
+
+            bool same = true;
+            int handoffBlock = -1;
+            for (int block = 0; block < source.getNumSamples() / blockSize; ++block)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    a.copyFrom (ch, 0, source, ch, block * blockSize, blockSize);
+                    b.copyFrom (ch, 0, source, ch, block * blockSize, blockSize);
+                }
+                minimum.processBlock (a, midi);
+                switched.processBlock (b, midi);
+
+                switched.handlePendingUpdates();
+                if (switched.getLatencySamples() != latencyBefore)
+                {
+                    handoffBlock = block;       // このブロックから FIR
+                    break;
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    same = same && std::equal (a.getReadPointer (ch), a.getReadPointer (ch) + blockSize, b.getReadPointer (ch));
+
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));   // ワーカーに設計させる
+            }
+
+            const int expectedLatency = latencyBefore + switched.getLinearPhaseLatencySamples();
+            const bool pass = same && handoffBlock >= 0 && switched.getLatencySamples() == expectedLatency;
+            ok = ok && pass;
+            std::printf ("\nMinimum -> Linear: same output as Minimum for %d blocks until the FIR was loaded%s, latency %d -> %d (expected %d) %s\n",
+                         juce::jmax (0, handoffBlock), same ? "" : " (differs)", latencyBefore, switched.getLatencySamples(),
+                         expectedLatency, pass ? "ok" : "FAIL");
+        }
+
+        // プロセッサ全体（既定の分割 128、先頭分割なし）
+        BenchConfig c;
+        c.sampleRate = rate;
+        c.blockSize = blockSize;
+        c.settings = "eqPhase=0";
+        const auto minimumPhase = runConfig (c, seconds);
+        c.settings = "eqPhase=1";
+        const auto linearPhase = runConfig (c, seconds);
+
+        std::printf ("\nprocessor: Minimum %.2f ns/smp, Linear %.2f ns/smp\n", minimumPhase.nsPerSample, linearPhase.nsPerSample);
+
+        return ok ? 0 : 1;
+    }
+}
+
+namespace
+{
+    // 多数インスタンス：ダビングのセッションのように同じプリセットのインスタンスを並べ、全部に同じ EQ 操作をしながら
+    // ブロックごとに順に処理する（ホストが 1 スレッドで回す場合）。係数キャッシュがあれば 2 個目以降は計算を省ける
+    int benchShared (int numInstances, double seconds)
+    {
+        constexpr double rate = 48000.0;
+        constexpr int blockSize = 64, numChannels = 2;
+        const int numSamples = (int) (rate * seconds);
+        const int editInterval = (int) (0.05 * rate / blockSize);   // 約 50 ms ごとに操作
+
+        juce::AudioBuffer<float> voice (numChannels, numSamples);
+        BenchSupport::renderVoice (voice, rate, numSamples);
+
+        std::printf ("%-9s %10s %12s %14s\n", "cache", "instances", "ns/smp/inst", "RTx (all)");
+
+        std::vector<float> firstOutput[2];
+        for (const bool cached : { false, true })
+        {
+            std::vector<std::unique_ptr<VoiceModelerAudioProcessor>> procs;
+            for (int i = 0; i < numInstances; ++i)
+            {
+                auto p = std::make_unique<VoiceModelerAudioProcessor>();
+                p->setSharedCoefficientCache (cached);
+                p->setPlayConfigDetails (numChannels, numChannels, rate, blockSize);
+                p->prepareToPlay (rate, blockSize);
+                procs.push_back (std::move (p));
+            }
+
+            juce::AudioBuffer<float> block (numChannels, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random rng (7);
+            auto& out = firstOutput[cached ? 1 : 0];
+            out.assign ((size_t) numSamples, 0.0f);
+
+            double elapsed = 0.0;
+            for (int pos = 0, index = 0; pos + blockSize <= numSamples; pos += blockSize, ++index)
+            {
+                if (index % editInterval == 0)
+                {
+                    const float values[] = { rng.nextFloat(), rng.nextFloat(), rng.nextFloat() };
+                    for (auto& p : procs)
+                    {
+                        p->apvts.getParameter (IDs::eq2Freq)->setValueNotifyingHost (values[0]);
+                        p->apvts.getParameter (IDs::eq2Gain)->setValueNotifyingHost (values[1]);
+                        p->apvts.getParameter (IDs::eq3Gain)->setValueNotifyingHost (values[2]);
+                    }
+                }
+
+                for (size_t i = 0; i < procs.size(); ++i)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        block.copyFrom (ch, 0, voice, ch, pos, blockSize);
+
+                    const auto t0 = std::chrono::steady_clock::now();
+                    procs[i]->processBlock (block, midi);
+                    elapsed += std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+                    if (i == 0)
+                        std::copy (block.getReadPointer (0), block.getReadPointer (0) + blockSize, out.begin() + pos);
+                }
+            }
+
+            const double ns = elapsed * 1.0e9 / ((double) numSamples * numInstances);
+            std::printf ("%-9s %10d %12.2f %14.2f\n", cached ? "shared" : "off", numInstances, ns, seconds / elapsed);
+
+            if (cached)
+            {
+                juce::SharedResourcePointer<SharedResources> shared;
+                const auto usage = shared->getUsage();
+                std::printf ("shared tables: %d windows, %.1f KB (per-instance copies would be %.1f KB)\n",
+                             usage.numWindows, usage.bytes / 1024.0, usage.bytes * numInstances / 1024.0);
+            }
+        }
+
+        // キャッシュは係数を丸めるので、出力のずれはごく小さいはず
+        double worst = 0.0, peak = 0.0;
+        for (size_t n = 0; n < firstOutput[0].size(); ++n)
+        {
+            worst = juce::jmax (worst, (double) std::abs (firstOutput[0][n] - firstOutput[1][n]));
+            peak  = juce::jmax (peak, (double) std::abs (firstOutput[0][n]));
+        }
+
+        const double diffDb = juce::Decibels::gainToDecibels (worst / juce::jmax (1.0e-9, peak), -200.0);
+        const bool ok = diffDb < -60.0;
+        std::printf ("cached vs direct coefficients: max diff %.1f dB %s\n", diffDb, ok ? "ok" : "FAIL");
+
+        return ok ? 0 : 1;
+    }
+}
+
+namespace
+{
+    // 動的 EQ／RBass ダッキング：声のトラックに、0.5 秒ごとに鳴ったり止んだりする音楽（広帯域ノイズ）をサイドチェインで当てる
+    int benchDynamic (double seconds)
+    {
+        constexpr double rate = 48000.0;
+        constexpr int blockSize = 64, numChannels = 2;
+        bool ok = true;
+
+        // --- 検出器：キーが無音ならゲインはちょうど 1、しきい値 +12 dB 以上の定常音なら range に落ち着く ---
+        {
+            constexpr float rangeDb = -9.0f, thresholdDb = -40.0f, maxErrorDb = 0.05f;
+            const int n = (int) rate;
+
+            DynamicsDetector detector;
+            ScratchArena arena;
+            arena.layout ([&] { detector.prepare (rate, n, arena); });
+            detector.setBand (DynamicsDetector::eq3, BiquadDesign::bandPass (rate, 5000.0, 2.0));
+            for (int l = 0; l < DynamicsDetector::numLanes; ++l)
+                detector.setLane (l, thresholdDb, rangeDb);
+
+            std::vector<float> key ((size_t) n, 0.0f);
+            const float* channels[] = { key.data() };
+
+            detector.process (channels, 1, 0, n);
+            bool unity = true;
+            for (int l = 0; l < DynamicsDetector::numLanes; ++l)
+                for (int i = 0; i < n; ++i)
+                    unity = unity && detector.getGains (l)[i] == 1.0f;
+
+            // -10 dBFS の 5 kHz：EQ3 のレーン（5 kHz の BPF）と全帯域のレーンは range いっぱい、EQ1/2（恒等の BPF）も同じ
+            for (int i = 0; i < n; ++i)
+                key[(size_t) i] = 0.316f * (float) std::sin (juce::MathConstants<double>::twoPi * 5000.0 * i / rate);
+            detector.process (channels, 1, 0, n);
+
+            float worst = 0.0f;
+            for (int l = 0; l < DynamicsDetector::numLanes; ++l)
+                worst = juce::jmax (worst, std::abs (juce::Decibels::gainToDecibels (detector.getGains (l)[n - 1]) - rangeDb));
+
+            const bool pass = unity && worst < maxErrorDb;
+            ok = ok && pass;
+            std::printf ("detector: silent key -> gain 1 %s, loud key -> range within %.3f dB %s\n",
+                         unity ? "ok" : "no", worst, pass ? "ok" : "FAIL");
+        }
+
+        // --- プロセッサ：サイドチェインを有効にして 静的 / 動的（EQ3 だけ＝ディエッサー、全レーン）を比較 ---
+        const int numSamples = (int) (rate * seconds);
+        juce::AudioBuffer<float> voice (numChannels, numSamples), music (numChannels, numSamples);
+        BenchSupport::renderVoice (voice, rate, numSamples);
+
+        juce::Random rng (99);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float level = (i / (int) (rate * 0.5)) % 2 == 0 ? 0.3f : 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                music.setSample (ch, i, level * (rng.nextFloat() * 2.0f - 1.0f));
+        }
+
+        const juce::String base = "nasalAmt=60,nasalNotch=40,eq1Gain=3,eq2Gain=-3,eq3Freq=6000,eq3Gain=2,eq3Q=2,rbMix=40";
+        const juce::String deEss = ",eq3DynThreshDb=-45,eq3DynRangeDb=-8";
+        const juce::String allLanes = deEss + ",eq1DynThreshDb=-40,eq1DynRangeDb=-6,eq2DynThreshDb=-40,eq2DynRangeDb=4"
+                                            ",rbDuckThreshDb=-40,rbDuckRangeDb=-18";
+
+        struct Result { double ns = 1.0e30; std::vector<float> out; };
+        const auto run = [&] (const juce::String& settings, bool silentKey)
+        {
+            Result r;
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                VoiceModelerAudioProcessor proc;
+                proc.getBus (true, 1)->enable();
+                BenchSupport::applySettings (proc, settings);
+                proc.prepareToPlay (rate, blockSize);
+
+                juce::AudioBuffer<float> io (2 * numChannels, blockSize);
+                juce::MidiBuffer midi;
+                r.out.assign ((size_t) numSamples, 0.0f);
+
+                double elapsed = 0.0;
+                for (int pos = 0; pos + blockSize <= numSamples; pos += blockSize)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        io.copyFrom (ch, 0, voice, ch, pos, blockSize);
+                        if (silentKey) io.clear (numChannels + ch, 0, blockSize);
+                        else           io.copyFrom (numChannels + ch, 0, music, ch, pos, blockSize);
+                    }
+
+                    const auto t0 = std::chrono::steady_clock::now();
+                    proc.processBlock (io, midi);
+                    elapsed += std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+                    std::copy (io.getReadPointer (0), io.getReadPointer (0) + blockSize, r.out.begin() + pos);
+                }
+
+                r.ns = juce::jmin (r.ns, elapsed * 1.0e9 / numSamples);
+            }
+            return r;
+        };
+
+        const auto staticMode = run (base + allLanes + ",dynKey=0", false);
+        const auto silent     = run (base + allLanes + ",dynKey=2", true);
+        const auto deEsser    = run (base + deEss + ",dynKey=2", false);
+        const auto dynamic    = run (base + allLanes + ",dynKey=2", false);
+
+        const bool identical = silent.out == staticMode.out;
+        ok = ok && identical;
+        std::printf ("silent sidechain vs static: %s\n", identical ? "identical" : "FAIL (outputs differ)");
+
+        double moved = 0.0;
+        for (size_t i = 0; i < dynamic.out.size(); ++i)
+            moved = juce::jmax (moved, (double) std::abs (dynamic.out[i] - staticMode.out[i]));
+        std::printf ("music sidechain vs static: max diff %.1f dB\n", juce::Decibels::gainToDecibels (moved, -200.0));
+
+        const double overhead = dynamic.ns / staticMode.ns - 1.0;
+        const bool costOk = overhead < 0.3;
+        ok = ok && costOk;
+
+        std::printf ("\ncost @48k stereo, block %d (ns/smp)\n%-24s %8.2f\n%-24s %8.2f  (+%.1f%%)\n%-24s %8.2f  (+%.1f%%, limit 30%%) %s\n",
+                     blockSize, "static", staticMode.ns,
+                     "dynamic: EQ3 (de-ess)", deEsser.ns, (deEsser.ns / staticMode.ns - 1.0) * 100.0,
+                     "dynamic: all lanes", dynamic.ns, overhead * 100.0, costOk ? "ok" : "FAIL");
+
+        return ok ? 0 : 1;
+    }
+}
+
+namespace
+{
+    // 11 段の IIR チェイン：旧実装（段ごとに ProcessorDuplicator でバッファを 1 パスずつ）vs 融合カスケード。
+    // 係数は同じ（SampleType に丸めた値）なので出力はビット一致するはず（-100 dB re peak を超えたら不合格）
+    template <typename SampleType>
+    bool compareCascade (const juce::Array<double>& blocks, double seconds)
+    {
+        using Duplicator = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<SampleType>, juce::dsp::IIR::Coefficients<SampleType>>;
+        constexpr double rate = 48000.0;
+        constexpr int numChannels = 2, numStages = 11;
+        const int numSamples = (int) (rate * seconds);
+
+        // プロセッサのチェインと同じ並び（HPF、F1–F3、鼻腔 1k/3k、ノッチ 1k/3k、EQ1–3）。どれも恒等でない値
+        const auto gain = [] (double db) { return juce::Decibels::decibelsToGain (db); };
+        const std::array<BiquadCoeffs, numStages> stages {
+            BiquadDesign::highPass (rate, 25.0),
+            BiquadDesign::peak (rate, 500.0, 4.0, gain (4.0)),  BiquadDesign::peak (rate, 1500.0, 4.0, gain (3.0)),
+            BiquadDesign::peak (rate, 2500.0, 4.0, gain (2.0)),
+            BiquadDesign::peak (rate, 1000.0, 2.0, gain (3.0)), BiquadDesign::peak (rate, 3000.0, 2.0, gain (2.0)),
+            BiquadDesign::peak (rate, 1000.0, 8.0, gain (-6.0)), BiquadDesign::peak (rate, 3000.0, 8.0, gain (-4.0)),
+            BiquadDesign::peak (rate, 200.0, 0.7, gain (2.0)),  BiquadDesign::peak (rate, 1000.0, 1.0, gain (-3.0)),
+            BiquadDesign::peak (rate, 5000.0, 1.5, gain (4.0)) };
+
+        juce::AudioBuffer<float> voice (numChannels, numSamples);
+        BenchSupport::renderVoice (voice, rate, numSamples);
+        juce::AudioBuffer<SampleType> input (numChannels, numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                input.setSample (ch, i, (SampleType) voice.getSample (ch, i));
+
+        const char* typeName = std::is_same_v<SampleType, float> ? "float" : "double";
+        constexpr double maxDiffDb = -100.0;   // re peak
+        bool ok = true;
+
+        for (auto blockValue : blocks)
+        {
+            const int blockSize = juce::jmax (1, (int) blockValue);
+            const juce::dsp::ProcessSpec spec { rate, (juce::uint32) blockSize, (juce::uint32) numChannels };
+
+            std::array<Duplicator, numStages> chain;
+            for (int s = 0; s < numStages; ++s)
+            {
+                chain[(size_t) s].state = new juce::dsp::IIR::Coefficients<SampleType> (1, 0, 0, 1, 0, 0);
+                BiquadDesign::copyTo (stages[(size_t) s], *chain[(size_t) s].state);
+                chain[(size_t) s].prepare (spec);
+            }
+
+            BiquadCascade<SampleType> cascade;
+            cascade.prepare (numChannels, blockSize);
+            cascade.setNumStages (numStages);
+            for (int s = 0; s < numStages; ++s)
+                cascade.setStage (s, stages[(size_t) s]);
+            cascade.reset();
+
+            // 3 回のうち最短（ns/sample）。最後の回の出力を比較に使う
+            const auto timeNs = [&] (juce::AudioBuffer<SampleType>& work, auto&& processBlock, auto&& resetState)
+            {
+                double best = 1.0e30;
+                for (int run = 0; run < 3; ++run)
+                {
+                    work.makeCopyOf (input, true);
+                    resetState();
+                    const auto t0 = std::chrono::steady_clock::now();
+                    for (int pos = 0; pos < numSamples; pos += blockSize)
+                        processBlock (work, pos, juce::jmin (blockSize, numSamples - pos));
+                    const auto t1 = std::chrono::steady_clock::now();
+                    best = juce::jmin (best, std::chrono::duration<double, std::nano> (t1 - t0).count() / numSamples);
+                }
+                return best;
+            };
+
+            juce::AudioBuffer<SampleType> oldOut, fusedOut;
+            const double oldNs = timeNs (oldOut,
+                [&] (juce::AudioBuffer<SampleType>& work, int pos, int len)
+                {
+                    juce::dsp::AudioBlock<SampleType> block (work.getArrayOfWritePointers(), (size_t) numChannels, (size_t) pos, (size_t) len);
+                    juce::dsp::ProcessContextReplacing<SampleType> context (block);
+                    for (auto& stage : chain)
+                        stage.process (context);
+                },
+                [&] { for (auto& stage : chain) stage.reset(); });
+
+            const double fusedNs = timeNs (fusedOut,
+                [&] (juce::AudioBuffer<SampleType>& work, int pos, int len) { cascade.process (work.getArrayOfWritePointers(), numChannels, pos, len); },
+                [&] { cascade.reset(); });
+
+            // 演算順序は同じなのでふつうはビット一致。FMA への縮約がコンパイラ任せのビルドでは丸め程度ずれうる
+            double worst = 0.0, peak = 0.0;
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    worst = juce::jmax (worst, (double) std::abs (oldOut.getSample (ch, i) - fusedOut.getSample (ch, i)));
+                    peak  = juce::jmax (peak, (double) std::abs (oldOut.getSample (ch, i)));
+                }
+
+            const double diffDb = juce::Decibels::gainToDecibels (worst / juce::jmax (1.0e-30, peak), -300.0);
+            const bool pass = diffDb < maxDiffDb;
+            ok = ok && pass;
+
+            std::printf ("%-7s %6d %14.2f %14.2f %8.2fx %12s %s\n", typeName, blockSize, oldNs, fusedNs, oldNs / fusedNs,
+                         worst == 0.0 ? "identical" : juce::String (diffDb, 1).toRawUTF8(),
+                         ! pass ? "FAIL" : oldNs / fusedNs >= 3.0 ? "" : "(below 3x)");
+        }
+
+        return ok;
+    }
+
+    int benchCascade (const juce::Array<double>& blocks, double seconds)
+    {
+        std::printf ("11-stage IIR chain @48k stereo (ns/smp, best of 3)\n");
+        std::printf ("%-7s %6s %14s %14s %9s %12s\n", "type", "block", "duplicator", "fused", "speedup", "diff dB");
+
+        const bool ok = compareCascade<float> (blocks, seconds) & compareCascade<double> (blocks, seconds);
+        return ok ? 0 : 1;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // APVTS がタイマーを使うのでメッセージマネージャだけ用意する（ウィンドウ・デバイスは作らない）
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--saturation"))
+        return checkSaturation();
+
+    const auto optionOr = [&args] (const char* name, const char* fallback)
+    {
+        const auto v = args.getValueForOption (name);
+        return v.isNotEmpty() ? v : juce::String (fallback);
+    };
+
+    // 回帰・正しさのチェック（Checks.h）
+    if (args.containsOption ("--golden"))
+        return Checks::golden (juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--golden")),
+                               args.containsOption ("--update"), optionOr ("--tolerance", "-80").getDoubleValue());
+    if (args.containsOption ("--responses"))
+        return Checks::responses();
+    if (args.containsOption ("--rtsafety"))
+        return Checks::realtimeSafety();
+
+    if (args.containsOption ("--formants"))
+        return benchFormants (args.containsOption ("--background"));
+
+    if (args.containsOption ("--shared"))
+        return benchShared (juce::jmax (1, optionOr ("--instances", "150").getIntValue()),
+                            juce::jmax (0.1, optionOr ("--seconds", "2").getDoubleValue()));
+
+    if (args.containsOption ("--dynamic"))
+        return benchDynamic (juce::jmax (0.5, optionOr ("--seconds", "3").getDoubleValue()));
+
+    if (args.containsOption ("--cascade"))
+        return benchCascade (parseList (optionOr ("--blocks", "16,32,64,512")), juce::jmax (0.5, optionOr ("--seconds", "5").getDoubleValue()));
+
+    if (args.containsOption ("--convolution"))
+        return benchConvolution (parseList (optionOr ("--partitions", "32,64,128,256,512")));
+
+    if (args.containsOption ("--state"))
+        return benchState (juce::jmax (1, optionOr ("--instances", "64").getIntValue()),
+                           juce::jmax (1, optionOr ("--iterations", "20").getIntValue()));
+
+    const auto rates    = parseList (optionOr ("--rates",  "44100,48000,96000,192000"));
+    const auto blocks   = parseList (optionOr ("--blocks", "16,32,64,128,256,512,1024,4096"));
+    const auto seconds  = optionOr ("--seconds", "5").getDoubleValue();
+    const auto channels = parseList (optionOr ("--channels", "2"));
+    const auto jsonPath = args.getValueForOption ("--json");
+    const auto settings = args.getValueForOption ("--set");
+    const auto signal   = optionOr ("--signal", "voice");
+
+    juce::StringArray patterns, precisions, internals;
+    patterns.addTokens (optionOr ("--patterns", "static,ramp,jump"), ",", "");
+    precisions.addTokens (optionOr ("--precision", "float"), ",", "");
+    internals.addTokens (optionOr ("--internal", "host"), ",", "");
+
+    std::printf ("%9s %6s %3s %-7s %-13s %10s %10s %10s %10s %9s\n",
+                 "rate", "block", "ch", "pattern", "buffer/core", "ns/smp", "p50 us", "p99 us", "max us", "RTx");
+
+    juce::Array<BenchResult> results;
+
+    for (auto numCh : channels)
+    {
+        for (auto rate : rates)
+        {
+            for (auto block : blocks)
+            {
+                for (auto& pattern : patterns)
+                {
+                    for (auto& precision : precisions)
+                    {
+                        for (auto& internal : internals)
+                        {
+                            BenchConfig c;
+                            c.sampleRate    = rate;
+                            c.blockSize     = (int) block;
+                            c.numChannels   = juce::jlimit (1, VoiceModelerAudioProcessor::maxChannels, (int) numCh);
+                            c.pattern       = pattern.trim();
+                            c.settings      = settings;
+                            c.doubleBuffers = precision.trim() == "double";
+                            c.internal      = internal.trim();
+                            c.signal        = signal;
+
+                            const auto r = runConfig (c, seconds);
+                            results.add (r);
+
+                            const auto prec = juce::String (c.doubleBuffers ? "double" : "float") + "/" + (r.doubleCore ? "double" : "float");
+                            std::printf ("%9.0f %6d %3d %-7s %-13s %10.2f %10.2f %10.2f %10.2f %9.1f\n",
+                                         r.config.sampleRate, r.config.blockSize, r.config.numChannels, r.config.pattern.toRawUTF8(),
+                                         prec.toRawUTF8(), r.nsPerSample, r.p50Us, r.p99Us, r.maxUs, r.realtimeFactor);
+                            std::fflush (stdout);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (jsonPath.isNotEmpty())
+    {
+        const auto json = juce::JSON::toString (toJson (results, seconds));
+
+        if (jsonPath == "-")
+            std::printf ("%s\n", json.toRawUTF8());
+        else if (! juce::File::getCurrentWorkingDirectory().getChildFile (jsonPath).replaceWithText (json))
+        {
+            std::fprintf (stderr, "failed to write %s\n", jsonPath.toRawUTF8());
+            return 1;
+        }
+    }
+
+    return 0;
+}
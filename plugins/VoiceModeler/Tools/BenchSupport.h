@@ -0,0 +1,134 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include <cstdio>
+
+// ベンチとチェック（Checks.cpp）で共有するテスト信号とパラメータ設定
+namespace BenchSupport
+{
+    // --set の "id=value" をパラメータの実値として設定（モード切替などの比較用）
+    inline void applySettings (VoiceModelerAudioProcessor& proc, const juce::String& settings)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens (settings, ",", "");
+
+        for (auto& t : tokens)
+        {
+            const auto id = t.upToFirstOccurrenceOf ("=", false, false).trim();
+            if (auto* p = proc.apvts.getParameter (id))
+                p->setValueNotifyingHost (p->convertTo0to1 (t.fromFirstOccurrenceOf ("=", false, false).getFloatValue()));
+            else if (id.isNotEmpty())
+                std::fprintf (stderr, "unknown parameter: %s\n", id.toRawUTF8());
+        }
+    }
+
+    // 声っぽいテスト信号：120 Hz 前後で揺れるパルス列（声門波の代わり）＋少量のノイズ。
+    // numVoicedSamples 以降はデジタル無音
+    inline void renderVoice (juce::AudioBuffer<float>& dst, double sampleRate, int numVoicedSamples)
+    {
+        juce::Random rng (1234);
+        double phase = 0.0;
+        dst.clear();
+
+        for (int i = 0; i < juce::jmin (numVoicedSamples, dst.getNumSamples()); ++i)
+        {
+            const double f0 = 120.0 * (1.0 + 0.05 * std::sin (juce::MathConstants<double>::twoPi * 3.0 * i / sampleRate));
+            phase += f0 / sampleRate;
+            float pulse = 0.0f;
+            if (phase >= 1.0)
+            {
+                phase -= 1.0;
+                pulse = 0.8f;
+            }
+
+            const float noise = (rng.nextFloat() * 2.0f - 1.0f) * 0.02f;
+            for (int ch = 0; ch < dst.getNumChannels(); ++ch)
+                dst.setSample (ch, i, pulse + noise);
+        }
+    }
+
+    // 先頭 1 サンプルだけのインパルス
+    inline void renderImpulse (juce::AudioBuffer<float>& dst, float amplitude)
+    {
+        dst.clear();
+        for (int ch = 0; ch < dst.getNumChannels(); ++ch)
+            dst.setSample (ch, 0, amplitude);
+    }
+
+    // 母音っぽいテスト信号：f0 のパルス列を声門の傾き（1 極）に通し、F1–F3（＋固定の F4）の共振器を並列に足す。
+    // ピークを peak に正規化（全チャンネル同じ）
+    inline void renderVowel (juce::AudioBuffer<float>& dst, double sampleRate, double f0,
+                             const float (&formantHz)[3], float peak)
+    {
+        struct Resonator
+        {
+            double b0, a1, a2, y1 = 0.0, y2 = 0.0;
+
+            Resonator (double sr, double hz, double bw)
+            {
+                const double r = std::exp (-juce::MathConstants<double>::pi * bw / sr);
+                a1 = -2.0 * r * std::cos (juce::MathConstants<double>::twoPi * hz / sr);
+                a2 = r * r;
+                b0 = 1.0 - r;
+            }
+
+            double process (double x) noexcept
+            {
+                const double y = b0 * x - a1 * y1 - a2 * y2;
+                y2 = y1;
+                y1 = y;
+                return y;
+            }
+        };
+
+        Resonator r1 (sampleRate, formantHz[0], 80.0), r2 (sampleRate, formantHz[1], 100.0),
+                  r3 (sampleRate, formantHz[2], 120.0), r4 (sampleRate, 3500.0, 200.0);
+        juce::Random rng (1234);
+        double phase = 0.0, glottis = 0.0;
+        float maxAbs = 1.0e-9f;
+
+        for (int i = 0; i < dst.getNumSamples(); ++i)
+        {
+            phase += f0 / sampleRate;
+            const double pulse = phase >= 1.0 ? 1.0 : 0.0;
+            if (phase >= 1.0)
+                phase -= 1.0;
+
+            glottis = pulse + 0.97 * glottis;
+            const double y = r1.process (glottis) + 0.7 * r2.process (glottis) + 0.5 * r3.process (glottis)
+                           + 0.3 * r4.process (glottis) + (rng.nextFloat() * 2.0f - 1.0f) * 0.002;
+
+            dst.setSample (0, i, (float) y);
+            maxAbs = juce::jmax (maxAbs, std::abs ((float) y));
+        }
+
+        dst.applyGain (0, 0, dst.getNumSamples(), peak / maxAbs);
+        for (int ch = 1; ch < dst.getNumChannels(); ++ch)
+            dst.copyFrom (ch, 0, dst, 0, 0, dst.getNumSamples());
+    }
+
+    // 20 Hz → 20 kHz の対数スイープ（全長で 1 回）
+    inline void renderSweep (juce::AudioBuffer<float>& dst, double sampleRate, float amplitude)
+    {
+        const double f0 = 20.0, f1 = juce::jmin (20000.0, sampleRate * 0.45);
+        const double duration = dst.getNumSamples() / sampleRate;
+        const double k = std::log (f1 / f0);
+
+        for (int i = 0; i < dst.getNumSamples(); ++i)
+        {
+            const double t = i / sampleRate;
+            const double phase = juce::MathConstants<double>::twoPi * f0 * duration / k * (std::exp (t / duration * k) - 1.0);
+            for (int ch = 0; ch < dst.getNumChannels(); ++ch)
+                dst.setSample (ch, i, amplitude * (float) std::sin (phase + ch * 0.5));
+        }
+    }
+
+    // 一様ホワイトノイズ（チャンネルごとに別系列、シード固定）
+    inline void renderNoise (juce::AudioBuffer<float>& dst, float amplitude)
+    {
+        juce::Random rng (4321);
+        for (int ch = 0; ch < dst.getNumChannels(); ++ch)
+            for (int i = 0; i < dst.getNumSamples(); ++i)
+                dst.setSample (ch, i, amplitude * (rng.nextFloat() * 2.0f - 1.0f));
+    }
+}
@@ -0,0 +1,661 @@
+#include "Checks.h"
+#include "BenchSupport.h"
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+#include "FilterCoefficientEngine.h"
+#include "BiquadCascade.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <malloc.h>
+ #include <pthread.h>
+#endif
+
+//==============================================================================
+// リアルタイム安全性の計測：processBlock の間だけ、そのスレッドの確保・解放・ロックを数える。
+// Linux では malloc 系と pthread_mutex_lock を実行ファイル側で差し替える（operator new も
+// juce::HeapBlock も最後は malloc に来る）。本物は glibc の __libc_* / RTLD_NEXT へ渡す。
+namespace
+{
+    thread_local bool armed = false;
+    std::atomic<int> allocations { 0 }, deallocations { 0 }, locks { 0 };
+
+    struct ScopedArm
+    {
+        ScopedArm() noexcept  { armed = true; }
+        ~ScopedArm() noexcept { armed = false; }
+    };
+
+    void countAllocation() noexcept   { if (armed) allocations.fetch_add (1, std::memory_order_relaxed); }
+    void countDeallocation() noexcept { if (armed) deallocations.fetch_add (1, std::memory_order_relaxed); }
+}
+
+#if JUCE_LINUX
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void  __libc_free (void*);
+
+    void* malloc (size_t size) noexcept                    { countAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size) noexcept      { countAllocation(); return __libc_calloc (count, size); }
+    void* realloc (void* p, size_t size) noexcept          { countAllocation(); return __libc_realloc (p, size); }
+    void* memalign (size_t alignment, size_t size) noexcept { countAllocation(); return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size) noexcept { countAllocation(); return __libc_memalign (alignment, size); }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free (void* p) noexcept
+    {
+        if (p != nullptr)
+            countDeallocation();
+        __libc_free (p);
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        using LockFn = int (*) (pthread_mutex_t*);
+        static LockFn real = nullptr;   // 関数内 static のガードはロックを使うことがあるので、初期化子は付けない
+        if (real == nullptr)
+            real = (LockFn) dlsym (RTLD_NEXT, "pthread_mutex_lock");
+
+        if (armed)
+            locks.fetch_add (1, std::memory_order_relaxed);
+
+        return real (mutex);
+    }
+}
+#endif
+
+namespace
+{
+    constexpr double checkSampleRate = 48000.0;
+
+    //==========================================================================
+    // ゴールデン出力
+    struct GoldenCase
+    {
+        const char* name;
+        const char* settings;
+        const char* exactCase = nullptr;    // 係数キャッシュありで描き、この（キャッシュなしの）ケースともスペクトルで比べる
+    };
+
+    // チェインの各段・各モードが 1 回は効く組み合わせ
+    const GoldenCase goldenCases[] = {
+        { "default",     "" },
+        { "voice",       "nasalAmt=60,nasalNotch=40,formantRatio=1.2,eq1Gain=6,eq2Gain=-6,eq3Gain=4,eq3Q=3" },
+        { "spectral",    "formantMode=1,formantRatio=0.85" },
+        { "adaptive",    "formantMode=2,formantRatio=1.2" },
+        { "linear",      "eqPhase=1,nasalAmt=60,nasalNotch=40,eq1Gain=6,eq2Gain=-6,eq3Gain=4,eq3Q=3" },
+        { "dynamic",     "dynKey=1,eq1DynThreshDb=-40,eq1DynRangeDb=6,eq3Freq=5000,eq3DynThreshDb=-50,eq3DynRangeDb=-9,"
+                         "rbMix=60,rbDuckThreshDb=-40,rbDuckRangeDb=-12" },
+        { "pitch-delay", "pitchMode=1,pitchSemis=5" },
+        { "pitch-psola", "pitchMode=2,pitchSemis=-4" },
+        { "rbass-os",    "rbMix=80,rbDriveDb=18,oversampling=2,satQuality=2" },
+        { "limiter",     "gain=18,limCeilingDb=-3,limReleaseMs=20" },
+        { "double",      "precision=2,nasalAmt=30,eq2Gain=9" },
+        { "bypass",      "bypass=1" },
+        { "voice-cached", "nasalAmt=60,nasalNotch=40,formantRatio=1.2,eq1Gain=6,eq2Gain=-6,eq3Gain=4,eq3Q=3", "voice" },
+    };
+
+    const char* const goldenSignals[] = { "impulse", "sweep", "noise", "voice" };
+
+    constexpr int goldenLength = 12000;      // 0.25 s
+    constexpr int goldenMaxBlock = 256;
+    constexpr double spectralToleranceDb = 0.5;
+
+    // 係数キャッシュの鍵の丸め（周波数・Q・ゲイン倍率の仮数 12 ビット、相対 2^-13 以内）による振幅の差の上限。
+    // 1 段の解析解の差は EQ の範囲で最大 0.05 dB（Q 5、-18 dB、18 kHz。他の段は 0.003 dB 未満）
+    constexpr double cacheStageToleranceDb = 0.1;
+    constexpr double cacheBandToleranceDb  = 0.1;    // 1/3 オクターブ帯域（キャッシュあり vs なしのゴールデン）
+
+    void renderSignal (const juce::String& name, juce::AudioBuffer<float>& dst)
+    {
+        if (name == "impulse")     BenchSupport::renderImpulse (dst, 0.5f);
+        else if (name == "sweep")  BenchSupport::renderSweep (dst, checkSampleRate, 0.5f);
+        else if (name == "noise")  BenchSupport::renderNoise (dst, 0.25f);
+        else                       BenchSupport::renderVoice (dst, checkSampleRate, dst.getNumSamples());
+    }
+
+    // 不揃いなブロック長（サブブロック分割・1 サンプルブロックも通す）で処理
+    juce::AudioBuffer<float> renderGolden (const GoldenCase& c, const juce::String& signal)
+    {
+        VoiceModelerAudioProcessor proc;
+        proc.setSharedCoefficientCache (c.exactCase != nullptr);   // 既定は丸めない係数で記録・比較する
+        BenchSupport::applySettings (proc, c.settings);
+        proc.setPlayConfigDetails (2, 2, checkSampleRate, goldenMaxBlock);
+        proc.prepareToPlay (checkSampleRate, goldenMaxBlock);
+
+        juce::AudioBuffer<float> io (2, goldenLength);
+        renderSignal (signal, io);
+
+        static constexpr int blockPattern[] = { 256, 64, 1, 200, 128, 31 };
+        juce::MidiBuffer midi;
+
+        for (int pos = 0, k = 0; pos < goldenLength; ++k)
+        {
+            const int len = juce::jmin (blockPattern[k % (int) std::size (blockPattern)], goldenLength - pos);
+            juce::AudioBuffer<float> view (io.getArrayOfWritePointers(), 2, pos, len);
+            proc.processBlock (view, midi);
+            pos += len;
+        }
+
+        return io;
+    }
+
+    // 形式：'VMG1'、サンプルレート、チャンネル数、サンプル数、チャンネルごとの float（リトルエンディアン）
+    constexpr int goldenMagic = 0x31474d56;
+
+    bool writeGolden (const juce::File& file, const juce::AudioBuffer<float>& buffer)
+    {
+        file.deleteFile();
+        juce::FileOutputStream out (file);
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt (goldenMagic);
+        out.writeDouble (checkSampleRate);
+        out.writeInt (buffer.getNumChannels());
+        out.writeInt (buffer.getNumSamples());
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                out.writeFloat (buffer.getSample (ch, i));
+
+        out.flush();
+        return out.getStatus().wasOk();
+    }
+
+    bool readGolden (const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::FileInputStream in (file);
+        if (! in.openedOk() || in.readInt() != goldenMagic || in.readDouble() != checkSampleRate)
+            return false;
+
+        const int chs = in.readInt();
+        const int n = in.readInt();
+        if (chs <= 0 || chs > VoiceModelerAudioProcessor::maxChannels || n <= 0
+             || in.getTotalLength() < 20 + (juce::int64) chs * n * 4)
+            return false;
+
+        buffer.setSize (chs, n);
+        for (int ch = 0; ch < chs; ++ch)
+            for (int i = 0; i < n; ++i)
+                buffer.setSample (ch, i, in.readFloat());
+
+        return true;
+    }
+
+    // 1/3 オクターブ帯域（25 Hz–20 kHz）のエネルギー (dB)
+    std::vector<double> thirdOctaveBands (const float* x, int n)
+    {
+        constexpr int order = 14, size = 1 << order;
+        juce::dsp::FFT fft (order);
+        std::vector<float> data ((size_t) size * 2, 0.0f);
+        std::vector<double> energy;
+
+        // 長さを揃えて（切り詰め／ゼロ詰め）1 フレームで
+        std::copy (x, x + juce::jmin (n, size), data.begin());
+        fft.performFrequencyOnlyForwardTransform (data.data());
+
+        for (double centre = 25.0; centre <= 20000.0; centre *= std::pow (2.0, 1.0 / 3.0))
+        {
+            const int lo = juce::jmax (1, (int) (centre * std::pow (2.0, -1.0 / 6.0) * size / checkSampleRate));
+            const int hi = juce::jmax (lo + 1, (int) (centre * std::pow (2.0, 1.0 / 6.0) * size / checkSampleRate));
+
+            double sum = 0.0;
+            for (int k = lo; k < juce::jmin (hi, size / 2); ++k)
+                sum += (double) data[(size_t) k] * data[(size_t) k];
+
+            energy.push_back (10.0 * std::log10 (sum + 1.0e-30));
+        }
+
+        return energy;
+    }
+
+    // 帯域ごとの差の最大 (dB)。基準の最大帯域から 80 dB 以内の帯域だけ比べる
+    double maxBandDiffDb (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference)
+    {
+        double worst = 0.0;
+        for (int ch = 0; ch < output.getNumChannels(); ++ch)
+        {
+            const auto got = thirdOctaveBands (output.getReadPointer (ch), output.getNumSamples());
+            const auto ref = thirdOctaveBands (reference.getReadPointer (ch), reference.getNumSamples());
+            const double floor = *std::max_element (ref.begin(), ref.end()) - 80.0;
+
+            for (size_t b = 0; b < ref.size(); ++b)
+                if (ref[b] > floor)
+                    worst = juce::jmax (worst, std::abs (got[b] - ref[b]));
+        }
+
+        return worst;
+    }
+
+    //==========================================================================
+    // 周波数応答
+    std::complex<double> biquadResponse (const BiquadCoeffs& c, double freq)
+    {
+        const auto z1 = std::polar (1.0, -juce::MathConstants<double>::twoPi * freq / checkSampleRate);
+        const auto z2 = z1 * z1;
+        return (c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2);
+    }
+
+    // インパルス応答の DTFT（指定周波数だけ直接和をとる。double で評価）
+    template <typename SampleType>
+    double measuredMagnitudeDb (const std::vector<SampleType>& ir, double freq)
+    {
+        const double w = juce::MathConstants<double>::twoPi * freq / checkSampleRate;
+        std::complex<double> sum;
+        for (size_t k = 0; k < ir.size(); ++k)
+            sum += (double) ir[k] * std::polar (1.0, -w * (double) k);
+        return 20.0 * std::log10 (std::abs (sum) + 1.0e-30);
+    }
+
+    std::vector<double> logFrequencies (double lo, double hi, int count)
+    {
+        std::vector<double> f;
+        for (int i = 0; i < count; ++i)
+            f.push_back (lo * std::pow (hi / lo, (double) i / (count - 1)));
+        return f;
+    }
+
+    // 1 段だけのカスケードの応答と、同じ精度に丸めた係数の解析解との最大差 (dB)
+    template <typename SampleType>
+    double stageErrorDb (const BiquadCoeffs& c, const std::vector<double>& freqs)
+    {
+        constexpr int irLength = 1 << 16;
+
+        BiquadCascade<SampleType> cascade;
+        cascade.prepare (1, 4096);
+        cascade.setNumStages (1);
+        cascade.reset();
+        cascade.setStage (0, c);
+
+        std::vector<SampleType> ir ((size_t) irLength, SampleType (0));
+        ir[0] = SampleType (1);
+        SampleType* channels[] = { ir.data() };
+        cascade.process (channels, 1, 0, irLength);
+
+        const BiquadCoeffs rounded { (double) (SampleType) c.b0, (double) (SampleType) c.b1, (double) (SampleType) c.b2,
+                                     (double) (SampleType) c.a1, (double) (SampleType) c.a2 };
+        double worst = 0.0;
+
+        for (auto f : freqs)
+        {
+            const double expected = juce::Decibels::gainToDecibels (std::abs (biquadResponse (rounded, f)), -200.0);
+            if (expected < -60.0)
+                continue;
+
+            worst = juce::jmax (worst, std::abs (measuredMagnitudeDb (ir, f) - expected));
+        }
+
+        return worst;
+    }
+
+    const char* const bandNames[] = { "hpf", "formant1", "formant2", "formant3", "nasal1k", "nasal3k",
+                                      "notch1k", "notch3k", "eq1", "eq2", "eq3", "rbassFocus",
+                                      "dynamic1", "dynamic2", "dynamic3" };
+}
+
+//==============================================================================
+int Checks::golden (const juce::File& directory, bool update, double toleranceDb)
+{
+    if (update && ! directory.createDirectory().wasOk())
+    {
+        std::fprintf (stderr, "cannot create %s\n", directory.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    std::printf ("%-12s %-8s %12s %12s\n", "case", "signal", "max err dB", "band diff dB");
+    bool ok = true;
+    int written = 0;
+
+    for (const auto& c : goldenCases)
+    {
+        for (auto* signal : goldenSignals)
+        {
+            const auto output = renderGolden (c, signal);
+            const auto file = directory.getChildFile (juce::String (c.name) + "-" + signal + ".f32");
+
+            if (update)
+            {
+                if (! writeGolden (file, output))
+                {
+                    std::fprintf (stderr, "failed to write %s\n", file.getFullPathName().toRawUTF8());
+                    return 1;
+                }
+                ++written;
+                continue;
+            }
+
+            juce::AudioBuffer<float> expected;
+            if (! readGolden (file, expected) || expected.getNumChannels() != output.getNumChannels()
+                 || expected.getNumSamples() != output.getNumSamples())
+            {
+                std::printf ("%-12s %-8s %12s %12s FAIL (missing or wrong size; record with --update)\n", c.name, signal, "-", "-");
+                ok = false;
+                continue;
+            }
+
+            // サンプル単位：最大絶対誤差（dBFS）
+            float maxErr = 0.0f;
+            for (int ch = 0; ch < output.getNumChannels(); ++ch)
+                for (int i = 0; i < output.getNumSamples(); ++i)
+                    maxErr = juce::jmax (maxErr, std::abs (output.getSample (ch, i) - expected.getSample (ch, i)));
+
+            const double bandDiff = maxBandDiffDb (output, expected);
+            const double errDb = juce::Decibels::gainToDecibels ((double) maxErr, -200.0);
+            const bool pass = errDb <= toleranceDb && bandDiff <= spectralToleranceDb;
+            ok = ok && pass;
+
+            std::printf ("%-12s %-8s %12.1f %12.3f %s\n", c.name, signal, errDb, bandDiff, pass ? "" : "FAIL");
+
+            // キャッシュあり：丸めた係数の出力がキャッシュなしのゴールデンと帯域で揃っているか
+            if (c.exactCase != nullptr)
+            {
+                juce::AudioBuffer<float> exact;
+                const bool found = readGolden (directory.getChildFile (juce::String (c.exactCase) + "-" + signal + ".f32"), exact)
+                                && exact.getNumChannels() == output.getNumChannels() && exact.getNumSamples() == output.getNumSamples();
+                const double exactDiff = found ? maxBandDiffDb (output, exact) : 0.0;
+                const bool exactPass = found && exactDiff <= cacheBandToleranceDb;
+                ok = ok && exactPass;
+
+                std::printf ("%-12s %-8s %12s %12.3f vs %s (<= %g) %s\n", "", signal, "-", exactDiff, c.exactCase,
+                             cacheBandToleranceDb, exactPass ? "" : (found ? "FAIL" : "FAIL (missing)"));
+            }
+        }
+    }
+
+    if (update)
+        std::printf ("wrote %d golden files to %s\n", written, directory.getFullPathName().toRawUTF8());
+
+    return ok ? 0 : 1;
+}
+
+//==============================================================================
+int Checks::responses()
+{
+    using Engine = FilterCoefficientEngine;
+
+    constexpr double floatToleranceDb  = 0.1;    // float の 25 Hz HPF は 20 Hz 付近で 0.04 dB ずれる（TDF-II の丸め）
+    constexpr double doubleToleranceDb = 1.0e-6;
+    constexpr double designToleranceDb = 0.01;
+    constexpr double chainToleranceDb  = 0.05;
+
+    const auto freqs = logFrequencies (20.0, 20000.0, 120);
+    const char* const grid[] = {
+        "",
+        "nasalAmt=100,nasalNotch=100,formantRatio=1.4,eq1Freq=80,eq1Gain=12,eq2Gain=-18,eq2Q=5,eq3Freq=12000,eq3Gain=9",
+        "formantRatio=0.7,eq1Gain=-6,eq1Q=0.3,eq2Freq=20,eq2Gain=18,eq3Freq=18000,eq3Gain=-12,eq3Q=5,rbFocusHz=60",
+    };
+
+    bool ok = true;
+    const auto report = [&ok] (const char* what, double value, double tolerance)
+    {
+        const bool pass = value <= tolerance;
+        ok = ok && pass;
+        std::printf ("  %-22s %12.3g dB  (<= %g) %s\n", what, value, tolerance, pass ? "" : "FAIL");
+    };
+
+    for (auto* settings : grid)
+    {
+        std::printf ("settings: %s\n", *settings != 0 ? settings : "(defaults)");
+
+        VoiceModelerAudioProcessor proc;
+        BenchSupport::applySettings (proc, settings);
+
+        // 係数キャッシュなし（丸めない係数）とあり（出荷時の既定。鍵を丸めた係数）
+        juce::SharedResourcePointer<SharedResources> shared;
+        Engine engine (proc.apvts), cachedEngine (proc.apvts);
+        cachedEngine.setCoefficientCache (&shared->getCoefficientCache());
+        for (auto* e : { &engine, &cachedEngine })
+        {
+            e->prepare (checkSampleRate);
+            e->update (0);
+        }
+
+        // 1) 段ごと：カスケード実装 vs 解析解、キャッシュの係数の解析解 vs 丸めない係数の解析解
+        for (int b = 0; b < Engine::numBands; ++b)
+        {
+            const auto& c = engine.get ((Engine::Band) b);
+            report ((juce::String (bandNames[b]) + " float").toRawUTF8(),  stageErrorDb<float>  (c, freqs), floatToleranceDb);
+            report ((juce::String (bandNames[b]) + " double").toRawUTF8(), stageErrorDb<double> (c, freqs), doubleToleranceDb);
+
+            const auto& rounded = cachedEngine.get ((Engine::Band) b);
+            double cacheDiff = 0.0;
+            for (auto f : freqs)
+                cacheDiff = juce::jmax (cacheDiff, std::abs (juce::Decibels::gainToDecibels (std::abs (biquadResponse (rounded, f)), -200.0)
+                                                           - juce::Decibels::gainToDecibels (std::abs (biquadResponse (c, f)), -200.0)));
+            report ((juce::String (bandNames[b]) + " cached").toRawUTF8(), cacheDiff, cacheStageToleranceDb);
+        }
+
+        // 2) 設計値：HPF は 25 Hz で -3.01 dB、EQ は中心周波数で設定ゲイン
+        const auto magnitudeDb = [] (const BiquadCoeffs& c, double f) { return 20.0 * std::log10 (std::abs (biquadResponse (c, f))); };
+        report ("hpf -3 dB @25 Hz", std::abs (magnitudeDb (engine.get (Engine::hpf), 25.0) + 3.0103), designToleranceDb);
+
+        const char* const eqIds[][2] = { { IDs::eq1Freq, IDs::eq1Gain }, { IDs::eq2Freq, IDs::eq2Gain }, { IDs::eq3Freq, IDs::eq3Gain } };
+        for (int k = 0; k < 3; ++k)
+        {
+            const double f0   = proc.apvts.getRawParameterValue (eqIds[k][0])->load();
+            const double gain = proc.apvts.getRawParameterValue (eqIds[k][1])->load();
+            const auto band   = (Engine::Band) (Engine::eq1 + k);
+            report ((juce::String ("eq") + juce::String (k + 1) + " gain @centre").toRawUTF8(),
+                    std::abs (magnitudeDb (engine.get (band), f0) - gain), designToleranceDb);
+        }
+
+        // 3) プロセッサ全体（RBass 0 %、ceiling 0 dB、-40 dBFS のインパルス）vs 全段の解析解の積。
+        //    キャッシュなしとあり（あり：キャッシュの係数の積。丸めによる差は 1) で見ている）
+        BenchSupport::applySettings (proc, "rbMix=0,gain=0,limCeilingDb=0");
+
+        for (const bool cached : { false, true })
+        {
+            proc.setSharedCoefficientCache (cached);
+            proc.setPlayConfigDetails (1, 1, checkSampleRate, 512);
+            proc.prepareToPlay (checkSampleRate, 512);
+
+            constexpr int irLength = 1 << 16;
+            constexpr float amplitude = 0.01f;
+            const int latency = proc.getLatencySamples();
+
+            juce::AudioBuffer<float> io (1, irLength + latency);
+            io.clear();
+            io.setSample (0, 0, amplitude);
+
+            juce::MidiBuffer midi;
+            for (int pos = 0; pos < io.getNumSamples(); pos += 512)
+            {
+                juce::AudioBuffer<float> view (io.getArrayOfWritePointers(), 1, pos, juce::jmin (512, io.getNumSamples() - pos));
+                proc.processBlock (view, midi);
+            }
+
+            std::vector<float> ir ((size_t) irLength);
+            for (int i = 0; i < irLength; ++i)
+                ir[(size_t) i] = io.getSample (0, latency + i) / amplitude;
+
+            const auto& stages = cached ? cachedEngine : engine;
+            double worst = 0.0;
+            for (auto f : freqs)
+            {
+                if (f < 30.0 || f > 18000.0)
+                    continue;
+
+                std::complex<double> expected (1.0);
+                for (int b = 0; b <= Engine::eq3; ++b)
+                    expected *= biquadResponse (stages.get ((Engine::Band) b), f);
+
+                worst = juce::jmax (worst, std::abs (measuredMagnitudeDb (ir, f) - 20.0 * std::log10 (std::abs (expected))));
+            }
+            report (cached ? "processor chain cached" : "processor chain", worst, chainToleranceDb);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
+
+//==============================================================================
+int Checks::realtimeSafety()
+{
+   #if ! JUCE_LINUX
+    std::printf ("realtime-safety check is Linux-only (malloc / pthread_mutex_lock interposition)\n");
+    return 0;
+   #else
+    constexpr int maxBlock = 512;
+    constexpr double seconds = 20.0;
+
+    std::printf ("%-14s %8s %8s %8s %8s %9s\n", "buffer/core", "blocks", "allocs", "frees", "locks", "arena KiB");
+    bool ok = true;
+
+    // 係数エンジン単体（キャッシュなし／共有キャッシュ）：パラメータはホスト側のスレッドとして数えずに動かし、
+    // オーディオスレッドが呼ぶもの（pullTargets / setTarget / setTrackedFormants / update / get）だけを数える
+    for (const bool cached : { false, true })
+    {
+        VoiceModelerAudioProcessor proc;
+        juce::SharedResourcePointer<SharedResources> shared;
+        FilterCoefficientEngine engine (proc.apvts);
+        engine.setCoefficientCache (cached ? &shared->getCoefficientCache() : nullptr);
+        engine.prepare (checkSampleRate);
+
+        juce::Array<juce::RangedAudioParameter*> params;
+        for (auto* p : proc.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (p))
+                params.add (ranged);
+
+        const int automated[] = { FilterCoefficientEngine::findSource (IDs::eq2Gain), FilterCoefficientEngine::findSource (IDs::eq3Freq) };
+        juce::Random rng (11);
+
+        allocations = 0;
+        deallocations = 0;
+        locks = 0;
+
+        constexpr int controlRate = 32;
+        int blocks = 0;
+        double sink = 0.0;
+        for (; blocks < (int) (seconds * checkSampleRate) / controlRate; ++blocks)
+        {
+            if (rng.nextInt (20) == 0)
+                params[rng.nextInt (params.size())]->setValueNotifyingHost (rng.nextFloat());
+
+            const float hz[] = { 300.0f + 600.0f * rng.nextFloat(), 900.0f + 1500.0f * rng.nextFloat(), 2000.0f + 1500.0f * rng.nextFloat() };
+
+            const ScopedArm arm;
+            engine.pullTargets();
+            if (rng.nextInt (8) == 0)
+                engine.setTarget (automated[rng.nextInt (2)], rng.nextFloat() * 1000.0f + 100.0f);
+            engine.setTrackedFormants (rng.nextInt (2) == 0 ? hz : nullptr, rng.nextFloat());
+            engine.update (controlRate);
+
+            for (int b = 0; b < FilterCoefficientEngine::numBands; ++b)
+                sink += engine.get ((FilterCoefficientEngine::Band) b).b0;
+        }
+
+        const bool pass = allocations == 0 && deallocations == 0 && locks == 0 && std::isfinite (sink);
+        ok = ok && pass;
+
+        std::printf ("%-14s %8d %8d %8d %8d %9s %s\n", cached ? "engine/cached" : "engine/direct", blocks,
+                     allocations.load(), deallocations.load(), locks.load(), "-", pass ? "" : "FAIL");
+    }
+
+    for (const bool doubleBuffers : { false, true })
+    {
+        for (const int precision : { 0, 1, 2 })
+        {
+            VoiceModelerAudioProcessor proc;
+            BenchSupport::applySettings (proc, "precision=" + juce::String (precision));
+            proc.setProcessingPrecision (doubleBuffers ? juce::AudioProcessor::doublePrecision
+                                                       : juce::AudioProcessor::singlePrecision);
+            proc.setPlayConfigDetails (2, 2, checkSampleRate, maxBlock);
+            proc.prepareToPlay (checkSampleRate, maxBlock);
+
+            // 1 秒鳴って 1 秒無音（アイドルの出入りも通す）
+            juce::AudioBuffer<float> source (2, (int) (checkSampleRate * 2.0));
+            BenchSupport::renderVoice (source, checkSampleRate, (int) checkSampleRate);
+
+            // prepare より長いブロック（maxBlock ずつに分けて処理される）も混ぜる
+            constexpr int maxHostBlock = maxBlock * 3;
+            juce::AudioBuffer<float>  ioF (2, maxHostBlock);
+            juce::AudioBuffer<double> ioD (2, maxHostBlock);
+            juce::MidiBuffer midi;
+            juce::Random rng (7);
+
+            // 精度以外の全パラメータ（モード・先読み・バイパスの切替を含む）をときどきランダムにジャンプ
+            juce::Array<juce::RangedAudioParameter*> params;
+            for (auto* p : proc.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (p); ranged != nullptr && ranged->paramID != IDs::precision)
+                    params.add (ranged);
+
+            allocations = 0;
+            deallocations = 0;
+            locks = 0;
+
+            int blocks = 0;
+            for (int pos = 0; pos < (int) (seconds * checkSampleRate); ++blocks)
+            {
+                const int len = rng.nextInt (8) == 0 ? rng.nextInt ({ maxBlock + 1, maxHostBlock + 1 })
+                                                     : rng.nextInt ({ 1, maxBlock + 1 });
+
+                if (rng.nextInt (20) == 0)
+                    params[rng.nextInt (params.size())]->setValueNotifyingHost (rng.nextFloat());
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < len; ++i)
+                    {
+                        const float x = source.getSample (ch, (pos + i) % source.getNumSamples());
+                        ioF.setSample (ch, i, x);
+                        ioD.setSample (ch, i, x);
+                    }
+
+                // ブロック内のオートメーション点（ラッパーと同じく processBlock の直前に同じスレッドで積む）
+                const auto pushPoints = [&]
+                {
+                    if (rng.nextInt (4) == 0)
+                        for (int k = rng.nextInt (40); --k >= 0;)
+                            proc.pushAutomation (rng.nextInt (VoiceModelerAudioProcessor::numAutomationTargets),
+                                                 rng.nextInt (len), rng.nextFloat() * 100.0f - 20.0f);
+                };
+
+                if (doubleBuffers)
+                {
+                    juce::AudioBuffer<double> view (ioD.getArrayOfWritePointers(), 2, 0, len);
+                    const ScopedArm arm;
+                    pushPoints();
+                    proc.processBlock (view, midi);
+                }
+                else
+                {
+                    juce::AudioBuffer<float> view (ioF.getArrayOfWritePointers(), 2, 0, len);
+                    const ScopedArm arm;
+                    pushPoints();
+                    proc.processBlock (view, midi);
+                }
+
+                pos += len;
+            }
+
+            const bool pass = allocations == 0 && deallocations == 0 && locks == 0;
+            ok = ok && pass;
+
+            const auto name = juce::String (doubleBuffers ? "double" : "float") + "/"
+                            + juce::StringArray { "host", "float", "double" }[precision];
+            std::printf ("%-14s %8d %8d %8d %8d %9.1f %s\n", name.toRawUTF8(), blocks,
+                         allocations.load(), deallocations.load(), locks.load(),
+                         (double) proc.getScratchBytes() / 1024.0, pass ? "" : "FAIL");
+        }
+    }
+
+    return ok ? 0 : 1;
+   #endif
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// VoiceModelerBench のチェック用サブコマンド（終了コード 0 = 合格、1 = 不合格）。
+// processBlock / updateFilters / processRBass を最適化するときの回帰確認用で、ヘッドレスで回る。
+namespace Checks
+{
+    // 決まった信号（インパルス・スイープ・ノイズ・パルス列）× パラメータの組み合わせをレンダリングし、
+    // 保存済みのゴールデン出力とサンプル単位（最大誤差 dBFS）と 1/3 オクターブのスペクトルで比較する。
+    // 係数キャッシュありで描くケースは、キャッシュなしの同じ設定のゴールデンともスペクトルで比べる。
+    // update なら比較せずに書き直す
+    int golden (const juce::File& directory, bool update, double toleranceDb);
+
+    // 各段の周波数応答：カスケード（float / double）のインパルス応答 vs 係数の解析解、
+    // 係数キャッシュの（丸めた）係数 vs 丸めない係数、EQ / HPF の設計値、
+    // プロセッサ全体の応答 vs 全段の解析解の積（キャッシュなし／あり）
+    int responses();
+
+    // processBlock 中（と、係数エンジン単体のオーディオスレッド側の呼び出し）のヒープ確保・解放と
+    // ミューテックスのロックを数え、1 回でもあれば不合格。
+    // malloc / pthread_mutex_lock の差し替えを使うので Linux のみ
+    int realtimeSafety();
+}
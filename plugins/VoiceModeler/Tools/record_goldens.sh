@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+# TestData/golden のゴールデンを基準のコミットのビルドで記録する。
+#
+#   plugins/VoiceModeler/Tools/record_goldens.sh <ref> [ref ...]
+#
+# ref（タグ・ブランチ・コミット）ごとに git worktree へ取り出して VoiceModelerBench をビルドし、
+# --golden=... --update の出力のうち、まだ TestData/golden に無いファイルだけを足す（同じケースは先に並べた ref の出力が残る）。
+# 基準にするビルドはタグで指す（例：git tag golden-baseline <commit> → record_goldens.sh golden-baseline）。
+# 記録したファイルはコミットする。全部を記録し直すときは先に TestData/golden/*.f32 を消す。
+# CMAKE_ARGS で configure に引数を足せる。
+set -euo pipefail
+
+plugin_dir=$(cd "$(dirname "$0")/.." && pwd)
+root=$(git -C "$plugin_dir" rev-parse --show-toplevel)
+dest="$plugin_dir/TestData/golden"
+
+if [ "$#" -eq 0 ]; then
+  echo "usage: $0 <ref> [ref ...]" >&2
+  exit 2
+fi
+refs=("$@")
+
+work=$(mktemp -d)
+cleanup()
+{
+  git -C "$root" worktree remove --force "$work/src" >/dev/null 2>&1 || true
+  rm -rf "$work"
+}
+trap cleanup EXIT
+
+mkdir -p "$dest"
+
+for ref in "${refs[@]}"; do
+  echo "== $ref"
+  git -C "$root" worktree add --detach "$work/src" "$ref" >/dev/null
+
+  # JUCE の取得はコミット間で使い回す
+  cmake -S "$work/src" -B "$work/build" -DCMAKE_BUILD_TYPE=Release \
+        -DFETCHCONTENT_BASE_DIR="$work/deps" ${CMAKE_ARGS:-}
+  cmake --build "$work/build" --config Release --target VoiceModelerBench -j"$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 2)"
+
+  bench=$(find "$work/build" -path '*VoiceModelerBench_artefacts*' -type f \
+               \( -name VoiceModelerBench -o -name VoiceModelerBench.exe \) | head -n1)
+  "$bench" --golden="$work/out" --update
+
+  for f in "$work/out"/*.f32; do
+    name=$(basename "$f")
+    if [ ! -e "$dest/$name" ]; then
+      cp "$f" "$dest/$name"
+      echo "recorded $name"
+    fi
+  done
+
+  git -C "$root" worktree remove --force "$work/src"
+  rm -rf "$work/build" "$work/out"
+done